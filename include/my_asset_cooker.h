@@ -0,0 +1,385 @@
+#ifndef MY_ASSET_COOKER_H
+#define MY_ASSET_COOKER_H
+
+#include <my_asset_pack.h>
+#include <my_mapped_file.h>
+#include <my_mesh_cache.h>
+#include <my_model_settings.h>
+#include <my_obj_parser.h>
+#include <my_skybox.h>
+#include <my_texture_codec.h>
+#include <my_thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Incremental asset cooker (run by tools/asset_cooker.cpp)
+// Builds the dependency graph of the app's sources: OBJ -> MTL -> textures, skybox faces -> cubemap, and every
+// cooked output plus the shaders -> asset pack. An output is rebuilt only when the content hash of its inputs and
+// cook settings differs from the one recorded in the cook manifest, the stale ones cook in parallel
+const char* const COOK_MANIFEST_FILE = "cook.manifest";
+const uint32_t COOK_MANIFEST_VERSION = 1;
+
+// Bump when the texture cook (mip filter, block encoders) changes, so every KTX is rebuilt
+const uint32_t TEXTURE_COOK_VERSION = 1;
+
+enum CookStep
+{
+    COOK_MESH_CACHE,    // OBJ (+ MTLs) -> .meshcache
+    COOK_TEXTURE,       // Image -> .ktx
+    COOK_CUBEMAP        // Six skybox faces -> cubemap.ktx
+};
+
+// One output and the files it's built from, jobs don't depend on each other
+struct CookJob
+{
+    CookStep step;
+    std::string output;
+    std::vector<std::string> inputs;
+    uint64_t settingsHash = 0;      // Cook settings baked into the output
+};
+
+// Output path -> hash of the inputs it was last cooked from
+typedef std::map<std::string, uint64_t> CookManifest;
+
+CookManifest readCookManifest(const std::string& path)
+{
+    CookManifest manifest;
+    std::ifstream in(path);
+    std::string line;
+    std::ostringstream expected;
+    expected << "cook.manifest " << COOK_MANIFEST_VERSION;
+    if (!std::getline(in, line) || line != expected.str())
+        return manifest;
+    while (std::getline(in, line))
+    {
+        size_t space = line.find(' ');
+        if (space != std::string::npos)
+            manifest[line.substr(space + 1)] = strtoull(line.c_str(), nullptr, 16);
+    }
+    return manifest;
+}
+
+bool writeCookManifest(const std::string& path, const CookManifest& manifest)
+{
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        out << "cook.manifest " << COOK_MANIFEST_VERSION << "\n";
+        for (const auto& entry : manifest)
+        {
+            char hash[17];
+            snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.second));
+            out << hash << " " << entry.first << "\n";
+        }
+        if (!out)
+            return false;
+    }
+    return replaceFile(tempPath, path);
+}
+
+uint64_t hashString(const std::string& text, uint64_t hash)
+{
+    return hashBytes(reinterpret_cast<const unsigned char*>(text.data()), text.size(), hash);
+}
+
+template <typename T>
+uint64_t hashValue(const T& value, uint64_t hash)
+{
+    return hashBytes(reinterpret_cast<const unsigned char*>(&value), sizeof(value), hash);
+}
+
+// Everything Model bakes into a mesh cache, with the settings the app loads this model with
+uint64_t meshCacheSettingsHash(const std::string& path)
+{
+    Model model;
+    applyModelSettings(model, path);
+    uint64_t hash = hashValue(MESH_CACHE_VERSION, hashValue(static_cast<uint32_t>(COOK_MESH_CACHE), 14695981039346656037ull));
+    bool flags[] = { model.optimizeMeshes, model.quantizeVertices, model.generateLods, model.nativeObjImport,
+        model.shareInstances, model.shareInstancesAcrossTexCoords, model.compressMeshCache };
+    hash = hashBytes(reinterpret_cast<const unsigned char*>(flags), sizeof(flags), hash);
+    return hashString(model.importProfile, hash);
+}
+
+uint64_t textureSettingsHash(CookStep step)
+{
+    return hashValue(TEXTURE_COOK_VERSION, hashValue(static_cast<uint32_t>(step), 14695981039346656037ull));
+}
+
+bool fileExists(const std::string& path)
+{
+    std::error_code error;
+    return std::filesystem::is_regular_file(path, error);
+}
+
+// Walk the model and skybox directories into cook jobs, one per output
+// Referenced sources that don't exist are reported in missing and left out
+std::vector<CookJob> buildCookGraph(const std::string& modelDirectory, const std::string& skyboxDirectory, std::vector<std::string>& missing)
+{
+    std::vector<CookJob> jobs;
+    std::set<std::string> textures;
+
+    std::vector<std::pair<std::string, std::string>> modelFiles;
+    gatherAssetFiles(modelDirectory, modelFiles);
+    for (const auto& file : modelFiles)
+    {
+        // Only OBJs go through import and processing, GLBs are loaded as they are
+        const std::string& objPath = file.first;
+        if (std::filesystem::path(objPath).extension() != ".obj")
+            continue;
+        MappedFile obj(objPath);
+        if (!obj.isOpen())
+        {
+            missing.push_back(objPath);
+            continue;
+        }
+
+        CookJob meshJob;
+        meshJob.step = COOK_MESH_CACHE;
+        meshJob.output = objPath + MESH_CACHE_EXTENSION;
+        meshJob.inputs.push_back(objPath);
+        meshJob.settingsHash = meshCacheSettingsHash(objPath);
+        for (const std::string& library : findMaterialLibraries(objPath, obj.data(), obj.size()))
+        {
+            if (!fileExists(library))
+            {
+                missing.push_back(library);
+                continue;
+            }
+            meshJob.inputs.push_back(library);
+
+            // Texture paths stay as the MTL wrote them, that's how the mesh cache and the runtime refer to them
+            std::map<std::string, std::string> diffuseTextures;
+            parseMtlFile(library, diffuseTextures);
+            for (const auto& material : diffuseTextures)
+            {
+                if (material.second.empty())
+                    continue;
+                if (fileExists(material.second))
+                    textures.insert(material.second);
+                else
+                    missing.push_back(material.second);
+            }
+        }
+        jobs.push_back(meshJob);
+    }
+
+    for (const std::string& texture : textures)
+    {
+        CookJob textureJob;
+        textureJob.step = COOK_TEXTURE;
+        textureJob.output = cookedTexturePath(texture);
+        textureJob.inputs.push_back(texture);
+        textureJob.settingsHash = textureSettingsHash(COOK_TEXTURE);
+        jobs.push_back(textureJob);
+    }
+
+    // A skybox is any directory holding all six faces
+    std::vector<std::string> directories = { skyboxDirectory };
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it(skyboxDirectory, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_directory(error))
+            directories.push_back(it->path().generic_string());
+    }
+    for (const std::string& directory : directories)
+    {
+        for (const char* extension : { ".png", ".jpg" })
+        {
+            std::vector<std::string> faces = skyboxFacePaths(directory, extension);
+            if (!std::all_of(faces.begin(), faces.end(), fileExists))
+                continue;
+            CookJob cubemapJob;
+            cubemapJob.step = COOK_CUBEMAP;
+            cubemapJob.output = cookedCubemapPath(faces);
+            cubemapJob.inputs = faces;
+            cubemapJob.settingsHash = textureSettingsHash(COOK_CUBEMAP);
+            jobs.push_back(cubemapJob);
+            break;
+        }
+    }
+    return jobs;
+}
+
+// Content hash of every path, computed in parallel, 0 for files that can't be read
+std::map<std::string, uint64_t> hashFiles(const std::vector<std::string>& paths, ThreadPool& pool)
+{
+    std::map<std::string, std::future<uint64_t>> pending;
+    for (const std::string& path : paths)
+    {
+        if (pending.find(path) != pending.end())
+            continue;
+        pending[path] = pool.submit([path]
+        {
+            MappedFile file(path);
+            if (file.isOpen())
+                return hashBytes(file.data(), file.size());
+            return fileExists(path) ? hashBytes(nullptr, 0) : 0;    // Empty files don't map
+        });
+    }
+
+    std::map<std::string, uint64_t> hashes;
+    for (auto& entry : pending)
+        hashes[entry.first] = entry.second.get();
+    return hashes;
+}
+
+// What a job's output is built from: its settings, then each input's path and content
+uint64_t cookInputHash(const CookJob& job, const std::map<std::string, uint64_t>& fileHashes)
+{
+    uint64_t hash = hashValue(job.settingsHash, 14695981039346656037ull);
+    for (const std::string& input : job.inputs)
+        hash = hashValue(fileHashes.at(input), hashString(input, hash));
+    return hash;
+}
+
+bool runCookJob(const CookJob& job)
+{
+    switch (job.step)
+    {
+    case COOK_MESH_CACHE:
+    {
+        Model model;
+        applyModelSettings(model, job.inputs[0]);
+        return model.cookMeshCache(job.inputs[0]);
+    }
+    case COOK_TEXTURE:
+    case COOK_CUBEMAP:
+    {
+        std::vector<CookedFace> faces;
+        bool withAlpha;
+        return cookKtxTexture(job.inputs, job.output, faces, withAlpha);
+    }
+    }
+    return false;
+}
+
+struct CookStats
+{
+    size_t outputs = 0;
+    size_t upToDate = 0;
+    size_t cooked = 0;
+    size_t failed = 0;
+    bool packWritten = false;
+    std::vector<std::string> missing;
+};
+
+// Cook everything stale under the model and skybox directories on every core, then rebuild the asset pack from
+// packRoots if anything it holds changed. Images with a cooked KTX are left out of the pack, the runtime never
+// reads them. An empty packPath skips the pack
+CookStats runAssetCooker(const std::vector<std::string>& packRoots, const std::string& modelDirectory, const std::string& skyboxDirectory,
+    const std::string& packPath = ASSET_PACK_FILE, const std::string& manifestPath = COOK_MANIFEST_FILE)
+{
+    CookStats stats;
+    ThreadPool pool;
+    CookManifest manifest = readCookManifest(manifestPath);
+
+    std::vector<CookJob> jobs = buildCookGraph(modelDirectory, skyboxDirectory, stats.missing);
+    std::vector<std::string> inputs;
+    for (const CookJob& job : jobs)
+        inputs.insert(inputs.end(), job.inputs.begin(), job.inputs.end());
+    std::map<std::string, uint64_t> fileHashes = hashFiles(inputs, pool);
+    stats.outputs = jobs.size();
+
+    // Stale: never cooked, inputs or settings changed since, or the output was deleted
+    std::vector<std::pair<size_t, std::future<bool>>> cooking;
+    std::vector<uint64_t> inputHashes(jobs.size());
+    std::vector<double> cookTimes(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        inputHashes[i] = cookInputHash(jobs[i], fileHashes);
+        auto recorded = manifest.find(jobs[i].output);
+        if (recorded != manifest.end() && recorded->second == inputHashes[i] && fileExists(jobs[i].output))
+        {
+            stats.upToDate++;
+            continue;
+        }
+        cooking.push_back({ i, pool.submit([&jobs, &cookTimes, i]
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            bool cooked = runCookJob(jobs[i]);
+            cookTimes[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            return cooked;
+        }) });
+    }
+    for (auto& job : cooking)
+    {
+        const CookJob& cookJob = jobs[job.first];
+        if (job.second.get())
+        {
+            manifest[cookJob.output] = inputHashes[job.first];
+            stats.cooked++;
+            std::cout << "Cooked " << cookJob.output << " (" << cookTimes[job.first] << " ms)" << std::endl;
+        }
+        else
+        {
+            manifest.erase(cookJob.output);
+            stats.failed++;
+            std::cout << "ERROR::ASSET_COOKER:: Failed to cook " << cookJob.output << std::endl;
+        }
+    }
+
+    if (!packPath.empty())
+    {
+        std::set<std::string> replaced;
+        for (const CookJob& job : jobs)
+        {
+            if (job.step != COOK_MESH_CACHE && fileExists(job.output))
+            {
+                for (const std::string& input : job.inputs)
+                    replaced.insert(normalizeAssetPath(input));
+            }
+        }
+        std::vector<std::pair<std::string, std::string>> files, packed;
+        for (const std::string& root : packRoots)
+            gatherAssetFiles(root, files);
+        for (const auto& file : files)
+        {
+            if (replaced.count(normalizeAssetPath(file.first)) == 0)
+                packed.push_back(file);
+        }
+        std::sort(packed.begin(), packed.end());
+
+        std::vector<std::string> packedFiles;
+        for (const auto& file : packed)
+            packedFiles.push_back(file.second);
+        std::map<std::string, uint64_t> packedHashes = hashFiles(packedFiles, pool);
+        uint64_t packHash = hashValue(ASSET_PACK_VERSION, 14695981039346656037ull);
+        for (const auto& file : packed)
+            packHash = hashValue(packedHashes[file.second], hashString(file.first, packHash));
+
+        auto recorded = manifest.find(packPath);
+        if (recorded == manifest.end() || recorded->second != packHash || !fileExists(packPath))
+        {
+            if (writeAssetPack(packPath, packed))
+            {
+                manifest[packPath] = packHash;
+                stats.packWritten = true;
+            }
+            else
+            {
+                manifest.erase(packPath);
+                stats.failed++;
+                std::cout << "ERROR::ASSET_COOKER:: Failed to write " << packPath << std::endl;
+            }
+        }
+    }
+
+    if (!writeCookManifest(manifestPath, manifest))
+        std::cout << "WARNING::ASSET_COOKER:: Could not write " << manifestPath << ", the next run cooks everything again" << std::endl;
+    return stats;
+}
+#endif // MY_ASSET_COOKER_H
@@ -0,0 +1,83 @@
+#ifndef MY_ASSET_IO_H
+#define MY_ASSET_IO_H
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <my_asset_pack.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+// Assimp file access through AssetFile, so imports (and the MTL files they pull in) read from the mounted pack
+// Install per importer with importer.SetIOHandler(new AssetIOSystem()), the importer owns it
+
+// Read-only stream over an asset's bytes
+class AssetIOStream : public Assimp::IOStream
+{
+public:
+    explicit AssetIOStream(AssetFile&& asset) : asset(std::move(asset)) {}
+
+    size_t Read(void* buffer, size_t size, size_t count) override
+    {
+        if (size == 0)
+            return 0;
+        size_t available = (asset.size() - position) / size;
+        size_t read = std::min(count, available);
+        memcpy(buffer, asset.data() + position, read * size);
+        position += read * size;
+        return read;
+    }
+
+    size_t Write(const void*, size_t, size_t) override
+    {
+        return 0;
+    }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t target = origin == aiOrigin_SET ? offset : origin == aiOrigin_CUR ? position + offset : asset.size() + offset;
+        if (target > asset.size())
+            return aiReturn_FAILURE;
+        position = target;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override { return position; }
+    size_t FileSize() const override { return asset.size(); }
+    void Flush() override {}
+
+private:
+    AssetFile asset;
+    size_t position = 0;
+};
+
+class AssetIOSystem : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char* path) const override
+    {
+        return assetExists(path);
+    }
+
+    char getOsSeparator() const override
+    {
+        return '/';
+    }
+
+    // Write modes aren't supported, Assimp only writes when exporting
+    Assimp::IOStream* Open(const char* path, const char* mode = "rb") override
+    {
+        if (strchr(mode, 'w') || strchr(mode, 'a'))
+            return nullptr;
+        AssetFile asset(path);
+        return asset.isOpen() ? new AssetIOStream(std::move(asset)) : nullptr;
+    }
+
+    void Close(Assimp::IOStream* stream) override
+    {
+        delete stream;
+    }
+};
+#endif // MY_ASSET_IO_H
@@ -0,0 +1,350 @@
+#ifndef MY_ASSET_PACK_H
+#define MY_ASSET_PACK_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <my_mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Asset pack: every file the app loads in one mapping (built by tools/asset_packer.cpp)
+// Layout: header | entry table sorted by path | path strings | 64-byte aligned blobs
+// Loaders open assets through AssetFile, which serves a view into the mounted pack and falls back to the loose file
+const char ASSET_PACK_MAGIC[8] = { 'A', 'S', 'S', 'E', 'T', 'P', 'K', '\0' };
+const uint32_t ASSET_PACK_VERSION = 1;
+const size_t ASSET_PACK_ALIGNMENT = 64;
+const char* const ASSET_PACK_FILE = "assets.pak";
+
+struct AssetPackHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t stringTableSize;
+};
+
+struct AssetPackEntry
+{
+    uint64_t offset;            // From the start of the pack
+    uint64_t size;
+    uint64_t pathOffset;        // Into string table
+    uint64_t pathLength;
+};
+
+// Key assets are stored and looked up under: relative, "." and ".." folded, forward slashes
+std::string normalizeAssetPath(const std::string& path)
+{
+    std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+    if (key.compare(0, 2, "./") == 0)
+        key.erase(0, 2);
+    return key;
+}
+
+// Directory of the running executable with a trailing separator, empty if it can't be found
+std::string executableDirectory()
+{
+    std::string path;
+#ifdef _WIN32
+    char buffer[MAX_PATH];
+    DWORD length = GetModuleFileNameA(NULL, buffer, MAX_PATH);
+    if (length > 0 && length < MAX_PATH)
+        path.assign(buffer, length);
+#else
+    char buffer[4096];
+    ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer));
+    if (length > 0)
+        path.assign(buffer, static_cast<size_t>(length));
+#endif
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+// Move a finished temp file over target in one step, so a reader sees the old file or the new one and never neither
+// (Windows rename won't replace an existing file)
+bool replaceFile(const std::string& tempPath, const std::string& target)
+{
+#ifdef _WIN32
+    return MoveFileExA(tempPath.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tempPath.c_str(), target.c_str()) == 0;
+#endif
+}
+
+// Process-wide mounted pack, mount once at startup before any loader runs (lookups are then read-only)
+class AssetPack
+{
+public:
+    static AssetPack& instance()
+    {
+        static AssetPack pack;
+        return pack;
+    }
+
+    // Map a pack and validate its tables, replacing any mounted one
+    bool mount(const std::string& path)
+    {
+        unmount();
+        if (!file.open(path))
+            return false;
+        mountedPath = path;
+
+        const unsigned char* base = file.data();
+        size_t size = file.size();
+        AssetPackHeader header;
+        if (size < sizeof(header))
+            return fail(path);
+        memcpy(&header, base, sizeof(header));
+        uint64_t tableEnd = sizeof(header) + static_cast<uint64_t>(header.entryCount) * sizeof(AssetPackEntry);
+        if (memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) != 0 || header.version != ASSET_PACK_VERSION ||
+            tableEnd > size || header.stringTableSize > size - tableEnd)
+            return fail(path);
+
+        entries.resize(header.entryCount);
+        memcpy(entries.data(), base + sizeof(header), entries.size() * sizeof(AssetPackEntry));
+        strings = reinterpret_cast<const char*>(base + tableEnd);
+        for (const AssetPackEntry& entry : entries)
+        {
+            if (entry.pathOffset + entry.pathLength > header.stringTableSize || entry.offset > size || entry.size > size - entry.offset)
+                return fail(path);
+        }
+        std::cout << "Asset pack: " << path << " mounted, " << entries.size() << " assets, " << size / 1024 << " KB" << std::endl;
+        return true;
+    }
+
+    void unmount()
+    {
+        file.close();
+        mountedPath.clear();
+        entries.clear();
+        strings = nullptr;
+    }
+
+    bool isMounted() const { return file.isOpen(); }
+    const std::string& path() const { return mountedPath; }
+
+    // View of a packed asset, valid while the pack stays mounted
+    bool find(const std::string& path, const unsigned char*& data, size_t& size) const
+    {
+        if (entries.empty())
+            return false;
+        std::string key = normalizeAssetPath(path);
+        auto entry = std::lower_bound(entries.begin(), entries.end(), key, [this](const AssetPackEntry& candidate, const std::string& target)
+        {
+            return entryPath(candidate) < target;
+        });
+        if (entry == entries.end() || entryPath(*entry) != key)
+            return false;
+        data = file.data() + entry->offset;
+        size = static_cast<size_t>(entry->size);
+        return true;
+    }
+
+    // Where a packed asset lies within the pack file, for readers that don't go through the mapping
+    bool findRange(const std::string& path, uint64_t& offset, size_t& size) const
+    {
+        const unsigned char* data;
+        if (!find(path, data, size))
+            return false;
+        offset = static_cast<uint64_t>(data - file.data());
+        return true;
+    }
+
+    bool contains(const std::string& path) const
+    {
+        const unsigned char* data;
+        size_t size;
+        return find(path, data, size);
+    }
+
+private:
+    MappedFile file;
+    std::string mountedPath;
+    std::vector<AssetPackEntry> entries;
+    const char* strings = nullptr;
+
+    std::string_view entryPath(const AssetPackEntry& entry) const
+    {
+        return std::string_view(strings + entry.pathOffset, static_cast<size_t>(entry.pathLength));
+    }
+
+    bool fail(const std::string& path)
+    {
+        std::cout << "ERROR::ASSET_PACK:: Invalid pack " << path << std::endl;
+        unmount();
+        return false;
+    }
+};
+
+// Mount the pack from the working directory, else from next to the executable, so the app starts from anywhere
+bool mountAssetPack(const std::string& name = ASSET_PACK_FILE)
+{
+    if (AssetPack::instance().mount(name))
+        return true;
+    std::string directory = executableDirectory();
+    return !directory.empty() && AssetPack::instance().mount(directory + name);
+}
+
+// Read-only bytes of one asset: a view into the mounted pack, or the loose file mapped on its own
+// Same interface as MappedFile so loaders can take either
+class AssetFile
+{
+public:
+    AssetFile() {}
+
+    explicit AssetFile(const std::string& path)
+    {
+        open(path);
+    }
+
+    bool open(const std::string& path)
+    {
+        close();
+        if (AssetPack::instance().find(path, packedData, packedSize))
+            return true;
+        return looseFile.open(path);
+    }
+
+    void close()
+    {
+        looseFile.close();
+        packedData = nullptr;
+        packedSize = 0;
+    }
+
+    bool isOpen() const { return packedData != nullptr || looseFile.isOpen(); }
+    bool isPacked() const { return packedData != nullptr; }
+    const unsigned char* data() const { return packedData ? packedData : looseFile.data(); }
+    size_t size() const { return packedData ? packedSize : looseFile.size(); }
+
+private:
+    const unsigned char* packedData = nullptr;
+    size_t packedSize = 0;
+    MappedFile looseFile;
+};
+
+// Whether an asset can be opened, from the pack or as a loose file
+bool assetExists(const std::string& path)
+{
+    if (AssetPack::instance().contains(path))
+        return true;
+    std::error_code error;
+    return !path.empty() && std::filesystem::exists(path, error);
+}
+
+// Add every regular file under path (or path itself) as a (packed path, file on disk) pair, skipping temp files
+// left by interrupted writes
+void gatherAssetFiles(const std::string& path, std::vector<std::pair<std::string, std::string>>& files)
+{
+    std::error_code error;
+    auto add = [&files](const std::filesystem::path& file)
+    {
+        if (file.extension() != ".tmp")
+            files.push_back({ file.generic_string(), file.string() });
+    };
+    if (std::filesystem::is_regular_file(path, error))
+    {
+        add(path);
+        return;
+    }
+    for (std::filesystem::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_regular_file(error))
+            add(it->path());
+    }
+}
+
+// Write a pack of (packed path, file on disk) pairs, through a temp file so a running app never maps a partial pack
+bool writeAssetPack(const std::string& packPath, std::vector<std::pair<std::string, std::string>> files)
+{
+    for (auto& file : files)
+        file.first = normalizeAssetPath(file.first);
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end(), [](const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b)
+    {
+        return a.first == b.first;
+    }), files.end());
+
+    AssetPackHeader header;
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(files.size());
+
+    std::string strings;
+    std::vector<AssetPackEntry> entries(files.size());
+    std::vector<MappedFile> sources(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (!sources[i].open(files[i].second))
+        {
+            std::error_code error;
+            if (!std::filesystem::is_regular_file(files[i].second, error) || std::filesystem::file_size(files[i].second, error) != 0)
+            {
+                std::cout << "ERROR::ASSET_PACK:: Could not read " << files[i].second << std::endl;
+                return false;
+            }
+        }
+        entries[i].pathOffset = strings.size();
+        entries[i].pathLength = files[i].first.size();
+        entries[i].size = sources[i].size();
+        strings += files[i].first;
+    }
+    header.stringTableSize = strings.size();
+
+    uint64_t offset = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + strings.size();
+    for (AssetPackEntry& entry : entries)
+    {
+        offset += (ASSET_PACK_ALIGNMENT - offset % ASSET_PACK_ALIGNMENT) % ASSET_PACK_ALIGNMENT;
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    std::string tempPath = packPath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cout << "ERROR::ASSET_PACK:: Could not write " << tempPath << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPackEntry));
+    out.write(strings.data(), strings.size());
+    uint64_t written = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + strings.size();
+    static const char zeros[ASSET_PACK_ALIGNMENT] = {};
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        out.write(zeros, static_cast<std::streamsize>(entries[i].offset - written));
+        out.write(reinterpret_cast<const char*>(sources[i].data()), static_cast<std::streamsize>(entries[i].size));
+        written = entries[i].offset + entries[i].size;
+    }
+    out.close();
+    if (!out)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    if (!replaceFile(tempPath, packPath))
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+#endif // MY_ASSET_PACK_H
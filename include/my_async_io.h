@@ -0,0 +1,523 @@
+#ifndef MY_ASYNC_IO_H
+#define MY_ASYNC_IO_H
+
+// io_uring through its raw syscalls (no liburing dependency), Linux only
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define MY_ASYNC_IO_URING 1
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#endif
+
+#include <my_asset_pack.h>
+#include <my_thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous whole-file reads for asset loading: every read of a batch is submitted at once and each
+// completion runs its callback (typically the decode or parse of that file) on the reader's worker threads,
+// so disk latency overlaps with CPU work instead of each loader blocking on its own reads in turn
+// Backends: io_uring with all reads in flight together on Linux, blocking reads on the worker threads elsewhere
+// (or when the kernel refuses io_uring, or the ring fails later on). Packed assets are read from their range of the asset pack
+
+// Reads in flight at once on the ring, more wait for a slot
+const unsigned int ASYNC_IO_QUEUE_DEPTH = 64;
+
+// Bytes of one asset, ok is false (and bytes empty) when the read failed
+struct AssetBuffer
+{
+    std::string path;
+    std::vector<unsigned char> bytes;
+    bool ok = false;
+
+    const unsigned char* data() const { return bytes.data(); }
+    size_t size() const { return bytes.size(); }
+};
+
+// One AsyncFileReader::readBatch call, done once every read's callback and then onDone have run
+class AsyncReadBatch
+{
+public:
+    typedef std::function<void(size_t index, AssetBuffer& buffer)> ReadCallback;
+
+    // Block until the batch is done (not from one of the reader's own callbacks)
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return finished; });
+    }
+
+    bool done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return finished;
+    }
+
+private:
+    friend class AsyncFileReader;
+    ReadCallback onRead;
+    std::function<void()> onDone;
+    std::atomic<size_t> pending{ 0 };
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool finished = false;
+
+    // Run the read's callback, the last one also finishes the batch
+    void deliver(size_t index, AssetBuffer& buffer)
+    {
+        if (onRead)
+            onRead(index, buffer);
+        if (--pending == 0)
+            finish();
+    }
+
+    void finish()
+    {
+        if (onDone)
+            onDone();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+        }
+        condition.notify_all();
+    }
+};
+
+class AsyncFileReader
+{
+public:
+    typedef AsyncReadBatch::ReadCallback ReadCallback;
+
+    // Worker threads run the callbacks (and the reads themselves without io_uring)
+    explicit AsyncFileReader(unsigned int threadCount = std::thread::hardware_concurrency(), bool useIoUring = true)
+        : workers(threadCount)
+    {
+#ifdef MY_ASYNC_IO_URING
+        if (useIoUring && setupRing())
+            reaper = std::thread([this] { reapLoop(); });
+#else
+        (void)useIoUring;
+#endif
+        if (usingIoUring())
+            std::cout << "Async I/O: io_uring, " << ASYNC_IO_QUEUE_DEPTH << " reads in flight, " << workers.size() << " callback threads" << std::endl;
+        else
+            std::cout << "Async I/O: thread pool fallback, " << workers.size() << " threads" << std::endl;
+    }
+
+    // Waits for reads in flight, then for the queued callbacks
+    ~AsyncFileReader()
+    {
+#ifdef MY_ASYNC_IO_URING
+        if (reaper.joinable())
+        {
+            {
+                // A failed ring's reaper has already stopped
+                std::unique_lock<std::mutex> lock(submitMutex);
+                submitCondition.wait(lock, [this] { return inFlightReads.size() < ASYNC_IO_QUEUE_DEPTH; });
+                if (!ringFailed)
+                {
+                    pushRead(nullptr);
+                    enterRing(1, 0, 0);
+                }
+            }
+            reaper.join();
+            closeRing();
+            for (RingRead* read : abandonedReads)
+            {
+                if (read->ownsFd && read->fd >= 0)
+                    close(read->fd);
+                delete read;
+            }
+        }
+        if (packFd >= 0)
+            close(packFd);
+#endif
+    }
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    bool usingIoUring() const
+    {
+#ifdef MY_ASYNC_IO_URING
+        return ringFd >= 0 && !ringFailed;
+#else
+        return false;
+#endif
+    }
+
+    // Read every path, calling onRead(index, buffer) on a worker thread as each one arrives and onDone after the
+    // last (callbacks may run concurrently with each other; the buffer is theirs to keep)
+    std::shared_ptr<AsyncReadBatch> readBatch(const std::vector<std::string>& paths, ReadCallback onRead, std::function<void()> onDone = nullptr)
+    {
+        std::shared_ptr<AsyncReadBatch> batch = std::make_shared<AsyncReadBatch>();
+        batch->onRead = std::move(onRead);
+        batch->onDone = std::move(onDone);
+        batch->pending = paths.size();
+        if (paths.empty())
+        {
+            batch->finish();
+            return batch;
+        }
+
+#ifdef MY_ASYNC_IO_URING
+        if (usingIoUring())
+        {
+            submitBatch(batch, paths);
+            return batch;
+        }
+#endif
+        for (size_t i = 0; i < paths.size(); i++)
+            readOnWorker(batch, i, paths[i]);
+        return batch;
+    }
+
+private:
+    ThreadPool workers;
+
+    // Fallback read of one path, delivered from a worker thread
+    void readOnWorker(const std::shared_ptr<AsyncReadBatch>& batch, size_t index, const std::string& path)
+    {
+        workers.submit([batch, index, path]
+        {
+            AssetBuffer buffer;
+            buffer.path = path;
+            readBlocking(buffer);
+            batch->deliver(index, buffer);
+        });
+    }
+
+    // Fallback: copy out of the pack, or read the loose file
+    static void readBlocking(AssetBuffer& buffer)
+    {
+        const unsigned char* data;
+        size_t size;
+        if (AssetPack::instance().find(buffer.path, data, size))
+        {
+            buffer.bytes.assign(data, data + size);
+            buffer.ok = true;
+            return;
+        }
+
+        FILE* file = fopen(buffer.path.c_str(), "rb");
+        if (!file)
+            return;
+        if (fseek(file, 0, SEEK_END) == 0)
+        {
+            long length = ftell(file);
+            if (length >= 0 && fseek(file, 0, SEEK_SET) == 0)
+            {
+                buffer.bytes.resize(static_cast<size_t>(length));
+                buffer.ok = fread(buffer.bytes.data(), 1, buffer.bytes.size(), file) == buffer.bytes.size();
+            }
+        }
+        fclose(file);
+        if (!buffer.ok)
+            buffer.bytes.clear();
+    }
+
+#ifdef MY_ASYNC_IO_URING
+    // One file read on the ring, resubmitted from where it stopped after a short read
+    struct RingRead
+    {
+        std::shared_ptr<AsyncReadBatch> batch;
+        size_t index = 0;
+        AssetBuffer buffer;
+        int fd = -1;
+        bool ownsFd = false;
+        uint64_t fileOffset = 0;    // Of the asset within the file (packed assets)
+        size_t done = 0;
+        iovec iov;
+    };
+
+    int ringFd = -1;
+    int packFd = -1;
+    unsigned int* sqHead = nullptr;
+    unsigned int* sqTail = nullptr;
+    unsigned int* sqMask = nullptr;
+    unsigned int* sqArray = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    unsigned int* cqHead = nullptr;
+    unsigned int* cqTail = nullptr;
+    unsigned int* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingBytes = 0;
+    size_t cqRingBytes = 0;
+    size_t sqeBytes = 0;
+
+    // Submissions come from any thread under submitMutex, completions are reaped by one thread
+    std::thread reaper;
+    std::mutex submitMutex;
+    std::condition_variable submitCondition;
+    std::vector<RingRead*> inFlightReads;
+
+    // Set under submitMutex when io_uring_enter fails for good: reads in flight are redone on the workers, later
+    // batches take the fallback, and the reads the kernel may still hold are only freed with the ring
+    std::atomic<bool> ringFailed{ false };
+    std::vector<RingRead*> abandonedReads;
+
+    bool setupRing()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, ASYNC_IO_QUEUE_DEPTH, &params));
+        if (fd < 0)
+            return false;   // Old kernel or blocked by a sandbox, use the fallback
+        ringFd = fd;
+
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+        sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        cqRing = singleMap ? sqRing : mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        sqeBytes = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMap == MAP_FAILED)
+        {
+            if (sqeMap != MAP_FAILED)
+                munmap(sqeMap, sqeBytes);
+            closeRing();
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+        cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    void closeRing()
+    {
+        if (sqes)
+            munmap(sqes, sqeBytes);
+        if (cqRing != MAP_FAILED && cqRing != sqRing)
+            munmap(cqRing, cqRingBytes);
+        if (sqRing != MAP_FAILED)
+            munmap(sqRing, sqRingBytes);
+        if (ringFd >= 0)
+            close(ringFd);
+        sqes = nullptr;
+        sqRing = cqRing = MAP_FAILED;
+        ringFd = -1;
+    }
+
+    int enterRing(unsigned int toSubmit, unsigned int minComplete, unsigned int flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    // Queue a readv of what's left of read (a no-op for nullptr, which wakes the reaper), submitMutex held
+    void pushRead(RingRead* read)
+    {
+        unsigned int tail = *sqTail;
+        unsigned int slot = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[slot];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = read ? IORING_OP_READV : IORING_OP_NOP;
+        if (read)
+        {
+            read->iov.iov_base = read->buffer.bytes.data() + read->done;
+            read->iov.iov_len = read->buffer.bytes.size() - read->done;
+            sqe.fd = read->fd;
+            sqe.addr = reinterpret_cast<uint64_t>(&read->iov);
+            sqe.len = 1;
+            sqe.off = read->fileOffset + read->done;
+        }
+        sqe.user_data = reinterpret_cast<uint64_t>(read);
+        sqArray[slot] = slot;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Open every file and put all the reads on the ring, entering it once per full queue
+    void submitBatch(const std::shared_ptr<AsyncReadBatch>& batch, const std::vector<std::string>& paths)
+    {
+        std::vector<RingRead*> immediate;
+        size_t fallbackFrom = paths.size();
+        std::unique_lock<std::mutex> lock(submitMutex);
+        unsigned int queued = 0;
+        for (size_t i = 0; i < paths.size() && fallbackFrom == paths.size(); i++)
+        {
+            if (inFlightReads.size() == ASYNC_IO_QUEUE_DEPTH)
+            {
+                enterRing(queued, 0, 0);
+                queued = 0;
+                submitCondition.wait(lock, [this] { return ringFailed || inFlightReads.size() < ASYNC_IO_QUEUE_DEPTH; });
+            }
+            if (ringFailed)
+            {
+                fallbackFrom = i;
+                break;
+            }
+
+            RingRead* read = new RingRead();
+            read->batch = batch;
+            read->index = i;
+            read->buffer.path = paths[i];
+            if (!openRead(*read) || read->buffer.bytes.empty())
+            {
+                immediate.push_back(read);
+                continue;
+            }
+            pushRead(read);
+            inFlightReads.push_back(read);
+            queued++;
+        }
+        if (queued > 0)
+            enterRing(queued, 0, 0);
+        lock.unlock();
+
+        // Failed opens and empty files need no I/O
+        for (RingRead* read : immediate)
+            complete(read);
+
+        // The ring failed while this batch was being queued
+        for (size_t i = fallbackFrom; i < paths.size(); i++)
+            readOnWorker(batch, i, paths[i]);
+    }
+
+    // File descriptor, offset and buffer for a read: its range of the pack, or the loose file
+    bool openRead(RingRead& read)
+    {
+        uint64_t offset;
+        size_t size;
+        if (AssetPack::instance().findRange(read.buffer.path, offset, size))
+        {
+            if (packFd < 0)
+                packFd = open(AssetPack::instance().path().c_str(), O_RDONLY | O_CLOEXEC);
+            read.fd = packFd;
+            read.fileOffset = offset;
+        }
+        else
+        {
+            read.fd = open(read.buffer.path.c_str(), O_RDONLY | O_CLOEXEC);
+            read.ownsFd = true;
+            struct stat st;
+            if (read.fd < 0 || fstat(read.fd, &st) != 0)
+                return false;
+            size = static_cast<size_t>(st.st_size);
+        }
+        if (read.fd < 0)
+            return false;
+        read.buffer.bytes.resize(size);
+        read.buffer.ok = size == 0;
+        return true;
+    }
+
+    // Completions are drained under submitMutex, which also orders them after the submitter's writes to each read
+    void reapLoop()
+    {
+        bool stopRequested = false;
+        std::vector<RingRead*> finished;
+        while (true)
+        {
+            if (enterRing(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            {
+                std::cout << "ERROR::ASYNC_IO:: io_uring_enter failed: " << strerror(errno) << ", falling back to blocking reads" << std::endl;
+                failRing();
+                break;
+            }
+
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lock(submitMutex);
+                unsigned int head = *cqHead;
+                unsigned int tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+                unsigned int resubmitted = 0;
+                for (; head != tail; head++)
+                {
+                    const io_uring_cqe& cqe = cqes[head & *cqMask];
+                    RingRead* read = reinterpret_cast<RingRead*>(cqe.user_data);
+                    if (!read)
+                    {
+                        stopRequested = true;
+                        continue;
+                    }
+                    if (cqe.res > 0)
+                    {
+                        read->done += static_cast<size_t>(cqe.res);
+                        if (read->done < read->buffer.bytes.size())
+                        {
+                            pushRead(read);
+                            resubmitted++;
+                            continue;
+                        }
+                    }
+                    read->buffer.ok = cqe.res >= 0 && read->done == read->buffer.bytes.size();
+                    inFlightReads.erase(std::find(inFlightReads.begin(), inFlightReads.end(), read));
+                    finished.push_back(read);
+                }
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+                if (resubmitted > 0)
+                    enterRing(resubmitted, 0, 0);
+                stop = stopRequested && inFlightReads.empty();
+            }
+
+            if (!finished.empty())
+                submitCondition.notify_all();
+            for (RingRead* read : finished)
+                complete(read);
+            finished.clear();
+            if (stop)
+                break;
+        }
+    }
+
+    // Give up on the ring: every read still on it is redone with a blocking read, so no batch waits forever
+    void failRing()
+    {
+        std::vector<RingRead*> stranded;
+        {
+            std::lock_guard<std::mutex> lock(submitMutex);
+            ringFailed = true;
+            stranded.swap(inFlightReads);
+            abandonedReads.insert(abandonedReads.end(), stranded.begin(), stranded.end());
+        }
+        submitCondition.notify_all();
+        for (RingRead* read : stranded)
+            readOnWorker(read->batch, read->index, read->buffer.path);
+    }
+
+    // Hand a finished read to the workers for its callback
+    void complete(RingRead* read)
+    {
+        if (read->ownsFd && read->fd >= 0)
+            close(read->fd);
+        if (!read->buffer.ok)
+            read->buffer.bytes.clear();
+        std::shared_ptr<RingRead> owned(read);
+        workers.submit([owned] { owned->batch->deliver(owned->index, owned->buffer); });
+    }
+#endif
+};
+#endif // MY_ASYNC_IO_H
@@ -0,0 +1,51 @@
+#ifndef MY_FRAME_UNIFORMS_H
+#define MY_FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <my_gl_object.h>
+
+// Per-frame camera and light state in one std140 uniform block ("FrameData" in the shaders), written once per frame
+// and read by every program bound to FRAME_UNIFORMS_BINDING (see Shader::bindUniformBlock)
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// Mirrors the std140 layout of FrameData: vec3s take a 16-byte slot
+struct FrameUniforms
+{
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 viewPos = glm::vec3(0.0f);
+    float padding0 = 0.0f;
+    glm::vec3 lightPos = glm::vec3(0.0f);
+    float padding1 = 0.0f;
+    glm::vec3 lightColour = glm::vec3(1.0f);
+    float padding2 = 0.0f;
+};
+static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 layout of FrameData");
+
+class FrameUniformBuffer
+{
+public:
+    // Allocate the buffer and attach it to its binding point, needs a current context
+    void create()
+    {
+        buffer.create();
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer.get());
+    }
+
+    // One upload per frame, before the first draw that reads it
+    void update(const FrameUniforms& uniforms)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    GLBuffer buffer;
+};
+#endif // MY_FRAME_UNIFORMS_H
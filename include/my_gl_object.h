@@ -0,0 +1,86 @@
+#ifndef MY_GL_OBJECT_H
+#define MY_GL_OBJECT_H
+
+#include <glad/glad.h>
+
+#include <my_gl_state.h>
+
+// Kinds of GL object a GLObject can own
+enum GLObjectType
+{
+    GL_OBJECT_BUFFER,
+    GL_OBJECT_VERTEX_ARRAY
+};
+
+// Owning handle to a GL object name, deleted with the matching glDelete* when the handle goes away
+// Names aren't shared, so only moves are allowed. Must be destroyed on a thread with the owning context
+// current (or a context sharing it, for buffers)
+template <GLObjectType Type>
+class GLObject
+{
+public:
+    GLObject() {}
+
+    // Adopt an existing name
+    explicit GLObject(GLuint name) : objectName(name) {}
+
+    ~GLObject()
+    {
+        reset();
+    }
+
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+
+    GLObject(GLObject&& other) noexcept : objectName(other.objectName)
+    {
+        other.objectName = 0;
+    }
+
+    GLObject& operator=(GLObject&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset(other.objectName);
+            other.objectName = 0;
+        }
+        return *this;
+    }
+
+    // Generate a fresh name, deleting any current one
+    void create()
+    {
+        GLuint name = 0;
+        if (Type == GL_OBJECT_BUFFER)
+            glGenBuffers(1, &name);
+        else
+            glGenVertexArrays(1, &name);
+        reset(name);
+    }
+
+    // Delete the current name (if any) and take ownership of another one
+    void reset(GLuint name = 0)
+    {
+        if (objectName != 0)
+        {
+            if (Type == GL_OBJECT_BUFFER)
+                glDeleteBuffers(1, &objectName);
+            else
+            {
+                glDeleteVertexArrays(1, &objectName);
+                GLState::instance().forgetVertexArray(objectName);
+            }
+        }
+        objectName = name;
+    }
+
+    GLuint get() const { return objectName; }
+    explicit operator bool() const { return objectName != 0; }
+
+private:
+    GLuint objectName = 0;
+};
+
+typedef GLObject<GL_OBJECT_BUFFER> GLBuffer;
+typedef GLObject<GL_OBJECT_VERTEX_ARRAY> GLVertexArray;
+#endif // MY_GL_OBJECT_H
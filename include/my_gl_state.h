@@ -0,0 +1,228 @@
+#ifndef MY_GL_STATE_H
+#define MY_GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Per-frame count of the state changes GLState forwards to GL and of the no-op ones it drops (see GLState::endFrame)
+struct GLStateStats
+{
+    size_t changesIssued = 0;       // GL calls made
+    size_t changesDropped = 0;      // Requests for state the context already had
+};
+
+// Texture units whose bindings are tracked, higher units are always bound
+const unsigned int GL_STATE_TEXTURE_UNITS = 16;
+
+// Shadow copy of the render context's program, VAO, texture unit, blend, depth and cull state
+// Every change on the render thread goes through it, so a change to what's already set costs no GL call and
+// draws don't need to unbind after themselves. Other contexts (e.g. the UploadWorker's) keep their own state and
+// must not use it. ImGui's GL3 backend restores everything it touches, so its draws leave the shadow valid
+class GLState
+{
+public:
+    static GLState& instance()
+    {
+        static GLState state;
+        return state;
+    }
+
+    void useProgram(GLuint program)
+    {
+        if (change(currentProgram, program))
+            glUseProgram(program);
+    }
+
+    void bindVertexArray(GLuint vertexArray)
+    {
+        if (change(currentVertexArray, vertexArray))
+            glBindVertexArray(vertexArray);
+    }
+
+    // Bind a texture to a unit, switching the active unit only when the binding actually changes
+    void bindTexture(unsigned int unit, GLenum target, GLuint texture)
+    {
+        GLuint* binding = textureBinding(unit, target);
+        if (binding && !change(*binding, texture))
+            return;
+        if (!binding)
+            changes.changesIssued++;
+        if (activeUnit != unit)
+        {
+            activeUnit = unit;
+            changes.changesIssued++;
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+        glBindTexture(target, texture);
+    }
+
+    // Bind to whichever unit is active, for creating and filling textures
+    void bindTexture(GLenum target, GLuint texture)
+    {
+        bindTexture(activeUnit != UNKNOWN ? activeUnit : 0, target, texture);
+    }
+
+    void setDepthTest(bool enabled)
+    {
+        setCapability(GL_DEPTH_TEST, depthTest, enabled);
+    }
+
+    void setDepthFunc(GLenum func)
+    {
+        if (change(depthFunc, func))
+            glDepthFunc(func);
+    }
+
+    void setBlend(bool enabled)
+    {
+        setCapability(GL_BLEND, blend, enabled);
+    }
+
+    void setBlendFunc(GLenum source, GLenum destination)
+    {
+        setBlendFuncSeparate(source, destination, source, destination);
+    }
+
+    void setBlendFuncSeparate(GLenum sourceRgb, GLenum destinationRgb, GLenum sourceAlpha, GLenum destinationAlpha)
+    {
+        if (blendFunc[0] == sourceRgb && blendFunc[1] == destinationRgb && blendFunc[2] == sourceAlpha && blendFunc[3] == destinationAlpha)
+        {
+            changes.changesDropped++;
+            return;
+        }
+        blendFunc[0] = sourceRgb;
+        blendFunc[1] = destinationRgb;
+        blendFunc[2] = sourceAlpha;
+        blendFunc[3] = destinationAlpha;
+        changes.changesIssued++;
+        glBlendFuncSeparate(sourceRgb, destinationRgb, sourceAlpha, destinationAlpha);
+    }
+
+    void setCullFace(bool enabled)
+    {
+        setCapability(GL_CULL_FACE, cullFace, enabled);
+    }
+
+    void setCullMode(GLenum mode)
+    {
+        if (change(cullMode, mode))
+            glCullFace(mode);
+    }
+
+    void setFrontFace(GLenum mode)
+    {
+        if (change(currentFrontFace, mode))
+            glFrontFace(mode);
+    }
+
+    // Winding of front faces, without a glGet round trip
+    GLenum frontFace() const
+    {
+        return currentFrontFace != UNKNOWN ? currentFrontFace : GL_CCW;
+    }
+
+    // Deleting an object unbinds it from the current context, and its name may be handed out again
+    void forgetTexture(GLuint texture)
+    {
+        for (unsigned int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++)
+        {
+            for (GLuint& binding : textures[unit])
+            {
+                if (binding == texture)
+                    binding = 0;
+            }
+        }
+    }
+
+    void forgetVertexArray(GLuint vertexArray)
+    {
+        if (currentVertexArray == vertexArray)
+            currentVertexArray = 0;
+    }
+
+    // After code outside the tracker has changed the context: the next request for each piece of state is issued
+    void invalidate()
+    {
+        currentProgram = currentVertexArray = activeUnit = UNKNOWN;
+        for (unsigned int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++)
+            textures[unit][0] = textures[unit][1] = UNKNOWN;
+        depthTest = depthFunc = blend = cullFace = cullMode = currentFrontFace = UNKNOWN;
+        blendFunc[0] = blendFunc[1] = blendFunc[2] = blendFunc[3] = UNKNOWN;
+    }
+
+    // Counters of the frame in progress and of the last one
+    const GLStateStats& frameStats() const
+    {
+        return changes;
+    }
+
+    const GLStateStats& lastFrameStats() const
+    {
+        return lastChanges;
+    }
+
+    // Close the frame's counters, once per frame after the last draw
+    void endFrame()
+    {
+        lastChanges = changes;
+        changes = GLStateStats();
+    }
+
+private:
+    static const GLuint UNKNOWN = ~0u;
+
+    // A fresh context's defaults
+    GLuint currentProgram = 0;
+    GLuint currentVertexArray = 0;
+    GLuint activeUnit = 0;
+    GLuint textures[GL_STATE_TEXTURE_UNITS][2] = {};    // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP
+    GLuint depthTest = GL_FALSE;
+    GLuint depthFunc = GL_LESS;
+    GLuint blend = GL_FALSE;
+    GLuint blendFunc[4] = { GL_ONE, GL_ZERO, GL_ONE, GL_ZERO };
+    GLuint cullFace = GL_FALSE;
+    GLuint cullMode = GL_BACK;
+    GLuint currentFrontFace = GL_CCW;
+
+    GLStateStats changes;
+    GLStateStats lastChanges;
+
+    GLState() {}
+
+    // Record value, returning whether it differs from what's set (and so needs the GL call)
+    bool change(GLuint& current, GLuint value)
+    {
+        if (current == value)
+        {
+            changes.changesDropped++;
+            return false;
+        }
+        current = value;
+        changes.changesIssued++;
+        return true;
+    }
+
+    void setCapability(GLenum capability, GLuint& current, bool enabled)
+    {
+        if (!change(current, enabled ? GL_TRUE : GL_FALSE))
+            return;
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    // Shadow of a unit's binding for target, nullptr for untracked units and targets
+    GLuint* textureBinding(unsigned int unit, GLenum target)
+    {
+        if (unit >= GL_STATE_TEXTURE_UNITS)
+            return nullptr;
+        if (target == GL_TEXTURE_2D)
+            return &textures[unit][0];
+        if (target == GL_TEXTURE_CUBE_MAP)
+            return &textures[unit][1];
+        return nullptr;
+    }
+};
+#endif // MY_GL_STATE_H
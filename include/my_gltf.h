@@ -0,0 +1,410 @@
+#ifndef MY_GLTF_H
+#define MY_GLTF_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <my_asset_pack.h>
+#include <my_json.h>
+#include <my_mesh.h>
+#include <my_transform_hierarchy.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GLB (binary glTF 2.0) reader. The JSON chunk is parsed, the binary chunk stays mapped and every mesh points its
+// vertex and index ranges straight into it: uploading is one glBufferData per range, no Vertex is ever built
+//
+// Supported: indexed triangle primitives whose data lives in the GLB's own binary chunk, with float POSITION and
+// NORMAL and float or normalized unsigned byte/short TEXCOORD_0; the base colour texture, from a file next to the
+// GLB or embedded. Each primitive becomes a MeshData named after its node and placed by the node's world matrix,
+// whose origin is the pivot animated parts turn about
+
+const uint32_t GLB_MAGIC = 0x46546C67;          // "glTF"
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;     // "JSON"
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;      // "BIN\0"
+
+// Image stored inside the GLB, to be decoded under key (the texture path its meshes use)
+struct GlbEmbeddedImage
+{
+    std::string key;
+    size_t byteOffset;              // From the start of the binary chunk
+    size_t size;
+    const unsigned char* data;      // Set by loadGlb once the binary chunk is found
+};
+
+// Everything read from one GLB, meshes point into file so it must stay open until they are uploaded
+struct GlbScene
+{
+    AssetFile file;
+    std::vector<MeshData> meshes;
+    std::vector<GlbEmbeddedImage> images;
+    size_t nodeCount = 0;
+    size_t binaryBytes = 0;
+};
+
+// An accessor resolved to a byte range of the binary chunk
+struct GltfAccessor
+{
+    size_t offset = 0;          // From the start of the binary chunk
+    size_t stride = 0;
+    size_t count = 0;
+    GLenum type = 0;
+    int components = 0;
+    bool normalized = false;
+    size_t elementBytes = 0;
+    const JsonValue* json = nullptr;
+
+    size_t end() const
+    {
+        return count == 0 ? offset : offset + (count - 1) * stride + elementBytes;
+    }
+};
+
+// GL type and byte size of a glTF componentType (0 for unknown ones)
+GLenum gltfComponentType(int componentType, size_t& size)
+{
+    switch (componentType)
+    {
+    case 5120: size = 1; return GL_BYTE;
+    case 5121: size = 1; return GL_UNSIGNED_BYTE;
+    case 5122: size = 2; return GL_SHORT;
+    case 5123: size = 2; return GL_UNSIGNED_SHORT;
+    case 5125: size = 4; return GL_UNSIGNED_INT;
+    case 5126: size = 4; return GL_FLOAT;
+    default: size = 0; return 0;
+    }
+}
+
+int gltfTypeComponents(const std::string& type)
+{
+    if (type == "SCALAR")
+        return 1;
+    if (type.size() == 4 && type.compare(0, 3, "VEC") == 0 && type[3] >= '2' && type[3] <= '4')
+        return type[3] - '0';
+    return 0;
+}
+
+// Resolve accessor index against the binary chunk, checking every byte it covers lies inside it
+bool readGltfAccessor(const JsonValue& root, int index, size_t binaryBytes, GltfAccessor& accessor)
+{
+    const JsonValue* accessors = root.find("accessors");
+    const JsonValue* bufferViews = root.find("bufferViews");
+    if (!accessors || !bufferViews || index < 0 || static_cast<size_t>(index) >= accessors->size())
+        return false;
+    const JsonValue& json = (*accessors)[index];
+    int viewIndex = json.intOr("bufferView", -1);
+    if (json.find("sparse") || viewIndex < 0 || static_cast<size_t>(viewIndex) >= bufferViews->size())
+        return false;
+    const JsonValue& view = (*bufferViews)[viewIndex];
+    if (view.intOr("buffer", -1) != 0)
+        return false;   // Only the GLB's own binary chunk is mapped
+
+    size_t componentBytes = 0;
+    accessor.json = &json;
+    accessor.type = gltfComponentType(json.intOr("componentType", 0), componentBytes);
+    accessor.components = gltfTypeComponents(json.stringOr("type", ""));
+    accessor.normalized = json.find("normalized") && json.find("normalized")->boolean;
+    accessor.count = static_cast<size_t>(json.numberOr("count", 0));
+    accessor.elementBytes = componentBytes * accessor.components;
+    size_t viewStride = static_cast<size_t>(view.numberOr("byteStride", 0));
+    accessor.stride = viewStride != 0 ? viewStride : accessor.elementBytes;
+    accessor.offset = static_cast<size_t>(view.numberOr("byteOffset", 0)) + static_cast<size_t>(json.numberOr("byteOffset", 0));
+    size_t viewEnd = static_cast<size_t>(view.numberOr("byteOffset", 0)) + static_cast<size_t>(view.numberOr("byteLength", 0));
+    return accessor.type != 0 && accessor.components != 0 && accessor.count != 0 && accessor.offset % componentBytes == 0 &&
+        accessor.end() <= viewEnd && viewEnd <= binaryBytes;
+}
+
+// Local transform of a node, from its matrix or its translation/rotation/scale
+glm::mat4 gltfNodeMatrix(const JsonValue& node)
+{
+    const JsonValue* matrix = node.find("matrix");
+    if (matrix && matrix->size() == 16)
+    {
+        glm::mat4 result;
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+                result[column][row] = static_cast<float>((*matrix)[column * 4 + row].number);
+        }
+        return result;
+    }
+
+    glm::vec3 translation(0.0f), scale(1.0f);
+    glm::vec4 q(0.0f, 0.0f, 0.0f, 1.0f);    // x, y, z, w
+    const JsonValue* t = node.find("translation");
+    const JsonValue* r = node.find("rotation");
+    const JsonValue* s = node.find("scale");
+    if (t && t->size() == 3)
+        translation = glm::vec3(static_cast<float>((*t)[0].number), static_cast<float>((*t)[1].number), static_cast<float>((*t)[2].number));
+    if (r && r->size() == 4)
+    {
+        for (int i = 0; i < 4; i++)
+            q[i] = static_cast<float>((*r)[i].number);
+    }
+    if (s && s->size() == 3)
+        scale = glm::vec3(static_cast<float>((*s)[0].number), static_cast<float>((*s)[1].number), static_cast<float>((*s)[2].number));
+
+    // T * R * S, R from the unit quaternion
+    glm::mat4 result = quaternionMatrix(q);
+    result[0] = result[0] * scale.x;
+    result[1] = result[1] * scale.y;
+    result[2] = result[2] * scale.z;
+    result[3] = glm::vec4(translation, 1.0f);
+    return result;
+}
+
+// Texture path for a material's base colour: a file next to the GLB, or a key for an embedded image
+// (added to scene.images once), empty if the material has none
+std::string gltfBaseColorTexture(const JsonValue& root, int materialIndex, const std::string& path, GlbScene& scene, size_t binaryBytes)
+{
+    const JsonValue* materials = root.find("materials");
+    if (!materials || materialIndex < 0 || static_cast<size_t>(materialIndex) >= materials->size())
+        return std::string();
+    const JsonValue* pbr = (*materials)[materialIndex].find("pbrMetallicRoughness");
+    const JsonValue* baseColor = pbr ? pbr->find("baseColorTexture") : nullptr;
+    const JsonValue* textures = root.find("textures");
+    const JsonValue* images = root.find("images");
+    int textureIndex = baseColor ? baseColor->intOr("index", -1) : -1;
+    if (!textures || !images || textureIndex < 0 || static_cast<size_t>(textureIndex) >= textures->size())
+        return std::string();
+    int imageIndex = (*textures)[textureIndex].intOr("source", -1);
+    if (imageIndex < 0 || static_cast<size_t>(imageIndex) >= images->size())
+        return std::string();
+    const JsonValue& image = (*images)[imageIndex];
+
+    std::string uri = image.stringOr("uri", "");
+    if (uri.compare(0, 5, "data:") == 0)
+    {
+        std::cout << "WARNING::GLB:: Data URI images aren't supported, image " << imageIndex << " in " << path << std::endl;
+        return std::string();
+    }
+    if (!uri.empty())
+    {
+        size_t slash = path.find_last_of("/\\");
+        return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + uri;
+    }
+
+    // Embedded: the image's bufferView holds the encoded file
+    std::string key = path + "#image" + std::to_string(imageIndex);
+    for (const GlbEmbeddedImage& embedded : scene.images)
+    {
+        if (embedded.key == key)
+            return key;
+    }
+    const JsonValue* bufferViews = root.find("bufferViews");
+    int viewIndex = image.intOr("bufferView", -1);
+    if (!bufferViews || viewIndex < 0 || static_cast<size_t>(viewIndex) >= bufferViews->size())
+        return std::string();
+    const JsonValue& view = (*bufferViews)[viewIndex];
+    size_t offset = static_cast<size_t>(view.numberOr("byteOffset", 0));
+    size_t length = static_cast<size_t>(view.numberOr("byteLength", 0));
+    if (view.intOr("buffer", -1) != 0 || offset + length > binaryBytes)
+        return std::string();
+    scene.images.push_back({ key, offset, length, nullptr });
+    return key;
+}
+
+// World matrix of every node, parents before children (nodes outside any hierarchy are their own roots)
+std::vector<glm::mat4> gltfWorldMatrices(const JsonValue& nodes)
+{
+    size_t count = nodes.size();
+    std::vector<int> parents(count, -1);
+    for (size_t i = 0; i < count; i++)
+    {
+        const JsonValue* children = nodes[i].find("children");
+        for (size_t c = 0; children && c < children->size(); c++)
+        {
+            int child = static_cast<int>((*children)[c].number);
+            if (child >= 0 && static_cast<size_t>(child) < count && parents[child] == -1 && static_cast<size_t>(child) != i)
+                parents[child] = static_cast<int>(i);
+        }
+    }
+
+    std::vector<glm::mat4> world(count);
+    std::vector<int> state(count, 0);     // 0 pending, 1 in progress, 2 done
+    for (size_t i = 0; i < count; i++)
+    {
+        // Walk up to the first resolved ancestor, then resolve back down
+        std::vector<size_t> chain;
+        size_t node = i;
+        while (state[node] == 0)
+        {
+            state[node] = 1;
+            chain.push_back(node);
+            if (parents[node] < 0)
+                break;
+            node = static_cast<size_t>(parents[node]);
+        }
+        for (size_t c = chain.size(); c-- > 0;)
+        {
+            size_t current = chain[c];
+            glm::mat4 local = gltfNodeMatrix(nodes[current]);
+            int parent = parents[current];
+            world[current] = parent >= 0 && state[parent] == 2 ? world[parent] * local : local;   // Cycles are cut at the repeat
+            state[current] = 2;
+        }
+    }
+    return world;
+}
+
+// Build one MeshData per triangle primitive of every node that has a mesh
+bool loadGlb(const std::string& path, GlbScene& scene)
+{
+    if (!scene.file.open(path))
+    {
+        std::cout << "ERROR::GLB:: Could not open " << path << std::endl;
+        return false;
+    }
+
+    // Header and chunks, all little-endian
+    const unsigned char* base = scene.file.data();
+    size_t size = scene.file.size();
+    uint32_t header[5] = {};
+    if (size >= sizeof(header))
+        memcpy(header, base, sizeof(header));
+    if (size < sizeof(header) || header[0] != GLB_MAGIC || header[1] != 2 || header[2] > size || header[4] != GLB_CHUNK_JSON ||
+        20 + static_cast<size_t>(header[3]) > header[2])
+    {
+        std::cout << "ERROR::GLB:: Not a glTF 2.0 binary: " << path << std::endl;
+        return false;
+    }
+    size_t length = header[2];
+    const char* jsonText = reinterpret_cast<const char*>(base + 20);
+    size_t jsonBytes = header[3];
+
+    const unsigned char* binary = nullptr;
+    size_t binaryBytes = 0;
+    size_t binaryChunk = (20 + jsonBytes + 3) & ~static_cast<size_t>(3);
+    if (binaryChunk + 8 <= length)
+    {
+        uint32_t chunk[2];
+        memcpy(chunk, base + binaryChunk, sizeof(chunk));
+        if (chunk[1] == GLB_CHUNK_BIN && binaryChunk + 8 + chunk[0] <= length)
+        {
+            binary = base + binaryChunk + 8;
+            binaryBytes = chunk[0];
+        }
+    }
+    scene.binaryBytes = binaryBytes;
+
+    JsonValue root;
+    JsonParser parser(jsonText, jsonBytes);
+    if (!parser.parse(root) || root.type != JSON_OBJECT)
+    {
+        std::cout << "ERROR::GLB:: Bad JSON chunk in " << path << ": " << parser.error() << std::endl;
+        return false;
+    }
+
+    const JsonValue* nodes = root.find("nodes");
+    const JsonValue* meshes = root.find("meshes");
+    if (!nodes || !meshes)
+        return true;    // Valid, just empty
+    scene.nodeCount = nodes->size();
+    std::vector<glm::mat4> world = gltfWorldMatrices(*nodes);
+
+    for (size_t n = 0; n < nodes->size(); n++)
+    {
+        const JsonValue& node = (*nodes)[n];
+        int meshIndex = node.intOr("mesh", -1);
+        if (meshIndex < 0 || static_cast<size_t>(meshIndex) >= meshes->size())
+            continue;
+        const JsonValue& mesh = (*meshes)[meshIndex];
+        const JsonValue* primitives = mesh.find("primitives");
+        std::string name = node.stringOr("name", mesh.stringOr("name", "node" + std::to_string(n)));
+        const glm::mat4& nodeMatrix = world[n];
+        float nodeScale = std::max(glm::length(glm::vec3(nodeMatrix[0])), std::max(glm::length(glm::vec3(nodeMatrix[1])), glm::length(glm::vec3(nodeMatrix[2]))));
+
+        for (size_t p = 0; primitives && p < primitives->size(); p++)
+        {
+            const JsonValue& primitive = (*primitives)[p];
+            const JsonValue* attributes = primitive.find("attributes");
+            GltfAccessor position, normal, texCoords, indices;
+            bool hasNormal = attributes && attributes->find("NORMAL");
+            bool hasTexCoords = attributes && attributes->find("TEXCOORD_0");
+            if (primitive.intOr("mode", 4) != 4 || !attributes ||
+                !readGltfAccessor(root, attributes->intOr("POSITION", -1), binaryBytes, position) ||
+                !readGltfAccessor(root, primitive.intOr("indices", -1), binaryBytes, indices) ||
+                (hasNormal && !readGltfAccessor(root, attributes->intOr("NORMAL", -1), binaryBytes, normal)) ||
+                (hasTexCoords && !readGltfAccessor(root, attributes->intOr("TEXCOORD_0", -1), binaryBytes, texCoords)))
+            {
+                std::cout << "WARNING::GLB:: Skipping primitive " << p << " of " << name << " (not indexed triangles in the binary chunk)" << std::endl;
+                continue;
+            }
+            if (position.type != GL_FLOAT || position.components != 3 || (hasNormal && (normal.type != GL_FLOAT || normal.components != 3)) ||
+                (hasTexCoords && (texCoords.components != 2 || (texCoords.type != GL_FLOAT && !texCoords.normalized))) ||
+                indices.components != 1 || indices.stride != indices.elementBytes ||
+                (indices.type != GL_UNSIGNED_BYTE && indices.type != GL_UNSIGNED_SHORT && indices.type != GL_UNSIGNED_INT))
+            {
+                std::cout << "WARNING::GLB:: Skipping primitive " << p << " of " << name << " (unsupported attribute formats)" << std::endl;
+                continue;
+            }
+
+            // One vertex range spanning every attribute, the streams are offsets into it
+            size_t start = position.offset;
+            size_t end = position.end();
+            for (const GltfAccessor* attribute : { &normal, &texCoords })
+            {
+                if (attribute->json)
+                {
+                    start = std::min(start, attribute->offset);
+                    end = std::max(end, attribute->end());
+                }
+            }
+
+            MeshData meshData;
+            meshData.meshName = name;
+            meshData.vertexFormat = VERTEX_FORMAT_STREAMS;
+            meshData.cachedVertices = binary + start;
+            meshData.cachedVertexBytes = end - start;
+            meshData.cachedVertexCount = position.count;
+            meshData.cachedIndices = binary + indices.offset;
+            meshData.cachedIndexCount = indices.count;
+            meshData.indexType = indices.type;
+            auto toStream = [start](const GltfAccessor& accessor)
+            {
+                VertexStream stream;
+                if (!accessor.json)
+                    return stream;
+                stream.offset = static_cast<uint32_t>(accessor.offset - start);
+                stream.stride = static_cast<uint32_t>(accessor.stride);
+                stream.type = accessor.type;
+                stream.components = accessor.components;
+                stream.normalized = accessor.normalized;
+                return stream;
+            };
+            meshData.streams.position = toStream(position);
+            meshData.streams.normal = toStream(normal);
+            meshData.streams.texCoords = toStream(texCoords);
+            meshData.nodeMatrix = nodeMatrix;
+            meshData.placedByNode = true;
+
+            // Bounds from the accessor's required min/max, in model space
+            const JsonValue* minimum = position.json->find("min");
+            const JsonValue* maximum = position.json->find("max");
+            if (minimum && maximum && minimum->size() == 3 && maximum->size() == 3)
+            {
+                glm::vec3 low(static_cast<float>((*minimum)[0].number), static_cast<float>((*minimum)[1].number), static_cast<float>((*minimum)[2].number));
+                glm::vec3 high(static_cast<float>((*maximum)[0].number), static_cast<float>((*maximum)[1].number), static_cast<float>((*maximum)[2].number));
+                meshData.boundsCenter = glm::vec3(nodeMatrix * glm::vec4((low + high) * 0.5f, 1.0f));
+                meshData.boundsRadius = glm::length(high - low) * 0.5f * nodeScale;
+            }
+
+            std::string texturePath = gltfBaseColorTexture(root, primitive.intOr("material", -1), path, scene, binaryBytes);
+            if (!texturePath.empty())
+                meshData.texturePaths.push_back(texturePath);
+            scene.meshes.push_back(std::move(meshData));
+        }
+    }
+
+    for (GlbEmbeddedImage& image : scene.images)
+        image.data = binary + image.byteOffset;
+    return true;
+}
+#endif // MY_GLTF_H
@@ -0,0 +1,89 @@
+#ifndef MY_IMPORT_PROFILE_H
+#define MY_IMPORT_PROFILE_H
+
+#include <assimp/config.h>
+#include <assimp/postprocess.h>
+
+#include <my_vertex.h>
+
+#include <iostream>
+#include <string>
+
+// Named import profiles: which vertex attributes the consuming shader reads, and from that the Assimp
+// post-processing steps worth running. Steps run one at a time so the import log can time each of them
+//
+//  legacy          every step the loader always used to request (tangents included, though Vertex can't hold them)
+//  lit_textured    normals + texcoords (vertexShader.vs)
+//  lit             normals only (cloudVertexShader.vs)
+//  unlit_textured  texcoords only
+//
+// Smooth normals are only generated when a profile needs normals and a mesh arrives without them
+struct ImportProfile
+{
+    const char* name;
+    unsigned int attributes;    // VERTEX_ATTRIBUTE_* read by the shader
+    unsigned int forcedSteps;   // Steps run regardless of need (legacy only)
+};
+
+const ImportProfile IMPORT_PROFILES[] =
+{
+    { "legacy", VERTEX_ATTRIBUTE_NORMAL | VERTEX_ATTRIBUTE_TEXCOORD, aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace },
+    { "lit_textured", VERTEX_ATTRIBUTE_NORMAL | VERTEX_ATTRIBUTE_TEXCOORD, 0 },
+    { "lit", VERTEX_ATTRIBUTE_NORMAL, 0 },
+    { "unlit_textured", VERTEX_ATTRIBUTE_TEXCOORD, 0 }
+};
+
+// Every step a profile may use, in the order Assimp's own pipeline runs them
+struct ImportStep
+{
+    unsigned int flag;
+    const char* name;
+};
+
+const ImportStep IMPORT_STEPS[] =
+{
+    { aiProcess_RemoveComponent, "RemoveComponent" },
+    { aiProcess_Triangulate, "Triangulate" },
+    { aiProcess_GenSmoothNormals, "GenSmoothNormals" },
+    { aiProcess_CalcTangentSpace, "CalcTangentSpace" },
+    { aiProcess_JoinIdenticalVertices, "JoinIdenticalVertices" },
+    { aiProcess_FlipUVs, "FlipUVs" }
+};
+
+// Steps the old fixed flag set ran for every model, used to report what a profile saves
+const unsigned int LEGACY_IMPORT_STEPS = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+// Look a profile up by name, unknown names fall back to legacy
+const ImportProfile& findImportProfile(const std::string& name)
+{
+    for (const ImportProfile& profile : IMPORT_PROFILES)
+    {
+        if (name == profile.name)
+            return profile;
+    }
+    std::cout << "WARNING::IMPORT_PROFILE:: Unknown profile " << name << ", using legacy" << std::endl;
+    return IMPORT_PROFILES[0];
+}
+
+// Unconditional steps for a profile (smooth normals are added on demand, see above)
+unsigned int importProfileSteps(const ImportProfile& profile)
+{
+    unsigned int steps = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | profile.forcedSteps;
+    if (profile.attributes & VERTEX_ATTRIBUTE_TEXCOORD)
+        steps |= aiProcess_FlipUVs;
+    if (~profile.attributes & (VERTEX_ATTRIBUTE_NORMAL | VERTEX_ATTRIBUTE_TEXCOORD))
+        steps |= aiProcess_RemoveComponent;
+    return steps;
+}
+
+// Components RemoveComponent strips before vertices are joined, so unused attributes can't keep vertices apart
+int importProfileRemovedComponents(const ImportProfile& profile)
+{
+    int components = 0;
+    if (!(profile.attributes & VERTEX_ATTRIBUTE_NORMAL))
+        components |= aiComponent_NORMALS;
+    if (!(profile.attributes & VERTEX_ATTRIBUTE_TEXCOORD))
+        components |= aiComponent_TEXCOORDS;
+    return components;
+}
+#endif // MY_IMPORT_PROFILE_H
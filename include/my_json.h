@@ -0,0 +1,268 @@
+#ifndef MY_JSON_H
+#define MY_JSON_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal read-only JSON document, enough for asset headers (e.g. the JSON chunk of a GLB)
+// Numbers are doubles and \u escapes outside ASCII are kept as-is, neither matters for the files we read
+
+enum JsonType
+{
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+class JsonValue
+{
+public:
+    JsonType type = JSON_NULL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> elements;                            // JSON_ARRAY
+    std::vector<std::pair<std::string, JsonValue>> members;     // JSON_OBJECT, in file order
+
+    // Member by key, nullptr when missing or this isn't an object
+    const JsonValue* find(const char* key) const
+    {
+        for (const auto& member : members)
+        {
+            if (member.first == key)
+                return &member.second;
+        }
+        return nullptr;
+    }
+
+    // Array element count (0 for anything else)
+    size_t size() const
+    {
+        return elements.size();
+    }
+
+    const JsonValue& operator[](size_t index) const
+    {
+        return elements[index];
+    }
+
+    // Typed member lookups with a fallback for missing or mistyped members
+    double numberOr(const char* key, double fallback) const
+    {
+        const JsonValue* value = find(key);
+        return value && value->type == JSON_NUMBER ? value->number : fallback;
+    }
+
+    int intOr(const char* key, int fallback) const
+    {
+        return static_cast<int>(numberOr(key, fallback));
+    }
+
+    std::string stringOr(const char* key, const std::string& fallback) const
+    {
+        const JsonValue* value = find(key);
+        return value && value->type == JSON_STRING ? value->string : fallback;
+    }
+};
+
+// Recursive descent over a text buffer, stops at the first error
+class JsonParser
+{
+public:
+    JsonParser(const char* text, size_t length) : cursor(text), end(text + length) {}
+
+    bool parse(JsonValue& value)
+    {
+        if (!parseValue(value, 0))
+            return false;
+        skipWhitespace();
+        return cursor == end || fail("trailing characters");
+    }
+
+    const std::string& error() const { return message; }
+
+private:
+    // Deeper nesting than any asset header needs, guards the stack against hostile files
+    static const int MAX_DEPTH = 64;
+
+    const char* cursor;
+    const char* end;
+    std::string message;
+
+    bool fail(const char* what)
+    {
+        if (message.empty())
+            message = what;
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+            cursor++;
+    }
+
+    bool consume(const char* literal)
+    {
+        size_t length = strlen(literal);
+        if (static_cast<size_t>(end - cursor) < length || memcmp(cursor, literal, length) != 0)
+            return false;
+        cursor += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if (depth > MAX_DEPTH)
+            return fail("nested too deeply");
+        skipWhitespace();
+        if (cursor == end)
+            return fail("unexpected end");
+
+        switch (*cursor)
+        {
+        case '{':
+            return parseObject(value, depth);
+        case '[':
+            return parseArray(value, depth);
+        case '"':
+            value.type = JSON_STRING;
+            return parseString(value.string);
+        case 't':
+        case 'f':
+            value.type = JSON_BOOL;
+            value.boolean = *cursor == 't';
+            return consume(value.boolean ? "true" : "false") || fail("bad literal");
+        case 'n':
+            value.type = JSON_NULL;
+            return consume("null") || fail("bad literal");
+        default:
+            return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth)
+    {
+        value.type = JSON_OBJECT;
+        cursor++;
+        skipWhitespace();
+        if (cursor < end && *cursor == '}')
+        {
+            cursor++;
+            return true;
+        }
+        while (true)
+        {
+            skipWhitespace();
+            std::pair<std::string, JsonValue> member;
+            if (cursor == end || *cursor != '"' || !parseString(member.first))
+                return fail("expected member name");
+            skipWhitespace();
+            if (cursor == end || *cursor++ != ':')
+                return fail("expected ':'");
+            if (!parseValue(member.second, depth + 1))
+                return false;
+            value.members.push_back(std::move(member));
+
+            skipWhitespace();
+            if (cursor == end)
+                return fail("unterminated object");
+            char next = *cursor++;
+            if (next == '}')
+                return true;
+            if (next != ',')
+                return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue& value, int depth)
+    {
+        value.type = JSON_ARRAY;
+        cursor++;
+        skipWhitespace();
+        if (cursor < end && *cursor == ']')
+        {
+            cursor++;
+            return true;
+        }
+        while (true)
+        {
+            value.elements.emplace_back();
+            if (!parseValue(value.elements.back(), depth + 1))
+                return false;
+
+            skipWhitespace();
+            if (cursor == end)
+                return fail("unterminated array");
+            char next = *cursor++;
+            if (next == ']')
+                return true;
+            if (next != ',')
+                return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseString(std::string& out)
+    {
+        cursor++;
+        while (cursor < end && *cursor != '"')
+        {
+            char c = *cursor++;
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (cursor == end)
+                break;
+            char escaped = *cursor++;
+            switch (escaped)
+            {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u':
+            {
+                if (end - cursor < 4)
+                    return fail("bad escape");
+                unsigned long code = strtoul(std::string(cursor, 4).c_str(), nullptr, 16);
+                cursor += 4;
+                if (code < 0x80)
+                    out += static_cast<char>(code);
+                else
+                    out += "\\u" + std::string(cursor - 4, 4);
+                break;
+            }
+            default: out += escaped; break;
+            }
+        }
+        if (cursor == end)
+            return fail("unterminated string");
+        cursor++;
+        return true;
+    }
+
+    bool parseNumber(JsonValue& value)
+    {
+        // strtod needs a terminator, numbers are short so copy the candidate characters out
+        const char* start = cursor;
+        while (cursor < end && (strchr("+-.eE", *cursor) || (*cursor >= '0' && *cursor <= '9')))
+            cursor++;
+        if (cursor == start)
+            return fail("unexpected character");
+        std::string text(start, cursor);
+        char* parsedEnd = nullptr;
+        value.type = JSON_NUMBER;
+        value.number = strtod(text.c_str(), &parsedEnd);
+        return parsedEnd == text.c_str() + text.size() || fail("bad number");
+    }
+};
+#endif // MY_JSON_H
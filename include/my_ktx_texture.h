@@ -0,0 +1,115 @@
+#ifndef MY_KTX_TEXTURE_H
+#define MY_KTX_TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <my_asset_pack.h>
+#include <my_gl_state.h>
+#include <my_texture_codec.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// S3TC is an extension (GL_EXT_texture_compression_s3tc), glad is generated for core only
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Whether the driver takes S3TC data directly (checked once, needs a current context)
+bool s3tcSupported()
+{
+    static int supported = -1;
+    if (supported < 0)
+    {
+        supported = 0;
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        for (GLint i = 0; i < extensionCount; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+                supported = 1;
+        }
+        if (!supported)
+            std::cout << "WARNING::KTX:: No S3TC support, cooked textures are decompressed on load" << std::endl;
+    }
+    return supported == 1;
+}
+
+// Whether a cooked file exists for this source (see tools/texture_cooker.cpp)
+bool hasCookedTexture(const std::string& cookedPath)
+{
+    return !cookedPath.empty() && assetExists(cookedPath);
+}
+
+// Upload a cooked KTX file (2D or cubemap) with all of its mips, returns 0 on failure
+// The data goes straight from the mapped file to the driver, nothing is decoded unless S3TC is missing
+unsigned int loadKtxTexture(const std::string& path, size_t& residentBytes)
+{
+    AssetFile file(path);
+    KtxTexture ktx;
+    if (!file.isOpen() || !parseKtx(file.data(), file.size(), ktx))
+    {
+        std::cout << "ERROR::KTX:: Failed to read " << path << " (missing, truncated or not BC1/BC3)" << std::endl;
+        return 0;
+    }
+
+    bool withAlpha = ktx.internalFormat == KTX_COMPRESSED_RGBA_S3TC_DXT5;
+
+    GLenum target = ktx.faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    bool compressed = s3tcSupported();
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    GLState::instance().bindTexture(target, textureID);
+    residentBytes = 0;
+    for (int mip = 0; mip < ktx.mipLevels; mip++)
+    {
+        for (int face = 0; face < ktx.faces; face++)
+        {
+            const KtxTexture::Level& level = ktx.levels[mip * ktx.faces + face];
+            GLenum faceTarget = ktx.faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+            if (compressed)
+            {
+                glCompressedTexImage2D(faceTarget, mip, ktx.internalFormat, level.width, level.height, 0, static_cast<GLsizei>(level.size), level.data);
+                residentBytes += level.size;
+            }
+            else
+            {
+                MipLevel pixels = decompressLevel(level.data, level.width, level.height, withAlpha);
+                glTexImage2D(faceTarget, mip, withAlpha ? GL_RGBA : GL_RGB, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data.data());
+                residentBytes += pixels.data.size();
+            }
+        }
+    }
+
+    // The cooked chain is complete, so the mips can actually be sampled
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, ktx.mipLevels - 1);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (target == GL_TEXTURE_CUBE_MAP)
+    {
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    else
+    {
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+    GLState::instance().bindTexture(target, 0);
+    return textureID;
+}
+
+// Upload the cooked version of a source texture if there is one, 0 otherwise
+unsigned int loadCookedTexture(const std::string& sourcePath, size_t& residentBytes)
+{
+    std::string cookedPath = cookedTexturePath(sourcePath);
+    return hasCookedTexture(cookedPath) ? loadKtxTexture(cookedPath, residentBytes) : 0;
+}
+#endif // MY_KTX_TEXTURE_H
@@ -6,24 +6,205 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <my_gl_object.h>
+#include <my_gl_state.h>
 #include <my_shader.h>
+#include <my_vertex.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
-struct Vertex 
-{
-    glm::vec3 Position;
-    glm::vec3 Normal;
-    glm::vec2 TexCoords;
-};
-
 struct Texture 
 {
     unsigned int id;
     std::string path;
 };
 
+// Index buffer element type for a mesh: 16-bit whenever every vertex is addressable with it
+GLenum chooseIndexType(size_t vertexCount)
+{
+    return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t indexTypeSize(GLenum indexType)
+{
+    if (indexType == GL_UNSIGNED_BYTE)
+        return sizeof(uint8_t);     // Only read straight from files (see my_gltf.h), never produced here
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+}
+
+// Vertex layout of interleaved Vertex/PackedVertex data for the bound VAO/VBO
+void setupInterleavedAttributes(VertexFormat vertexFormat)
+{
+    if (vertexFormat == VERTEX_FORMAT_PACKED)
+    {
+        // Normalized integers, the shader applies the mesh's scale/offset and decodes the normal
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+        return;
+    }
+
+    // Vertex positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+
+    // Vertex normals
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+
+    // Vertex texture coords
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+}
+
+// Detail levels per mesh, the full resolution one included
+const int MAX_MESH_LODS = 4;
+
+// One level of detail: a range of the mesh's index buffer and the geometric error it carries (model units)
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+};
+
+// Another mesh drawn with this one's buffers (see my_mesh_instancing.h)
+// transform takes this mesh's vertices onto the copy's, mirrored means it flips handedness (and so winding)
+struct MeshInstance
+{
+    std::string meshName;
+    glm::mat4 transform;
+    bool mirrored;
+    int hierarchyNode = -1;     // Node that moves the copy (see Model's hierarchy), bound at load
+};
+
+// CPU-side mesh produced by Model's import phase, turned into a Mesh on the GL thread
+struct MeshData
+{
+    std::string meshName;
+    std::vector<std::string> texturePaths;
+    std::vector<Vertex> vertices;
+
+    // Filled by quantize(), which also drops the float vertices
+    std::vector<PackedVertex> packedVertices;
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    VertexQuantization quantization;
+
+    // Import and processing work on 32-bit indices, selectIndexType() then narrows them if they fit
+    std::vector<unsigned int> indices;
+    std::vector<uint16_t> shortIndices;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // Index ranges of the detail levels, finest first (see generateMeshLods), and the bounds to project their error with
+    std::vector<MeshLod> lods;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+
+    // Congruent copies folded into this mesh at import, drawn instanced with its buffers and detail levels
+    std::vector<MeshInstance> instances;
+
+    // Set instead of the vectors above when the mesh comes from a mapped mesh cache or GLB
+    const void* cachedVertices = nullptr;
+    size_t cachedVertexCount = 0;
+    const void* cachedIndices = nullptr;
+    size_t cachedIndexCount = 0;
+
+    // VERTEX_FORMAT_STREAMS: attribute layout within the cachedVertexBytes at cachedVertices
+    VertexStreams streams;
+    size_t cachedVertexBytes = 0;
+
+    // Meshes from a scene graph (GLB) keep their vertices in node space, nodeMatrix places them in the model
+    glm::mat4 nodeMatrix = glm::mat4(1.0f);
+    bool placedByNode = false;
+
+    MeshData() {}
+
+    // Import results are handed on by moving, a copy would duplicate every vertex
+    MeshData(const MeshData&) = delete;
+    MeshData& operator=(const MeshData&) = delete;
+    MeshData(MeshData&&) = default;
+    MeshData& operator=(MeshData&&) = default;
+
+    // Move the indices to 16-bit storage when the mesh is small enough, once processing is done
+    void selectIndexType()
+    {
+        indexType = chooseIndexType(vertexCount());
+        if (indexType == GL_UNSIGNED_SHORT)
+        {
+            shortIndices.assign(indices.begin(), indices.end());
+            std::vector<unsigned int>().swap(indices);
+        }
+    }
+
+    // Switch to the packed vertex format, returns the error it introduced
+    QuantizationError quantize()
+    {
+        packedVertices = quantizeVertices(vertices.data(), vertices.size(), quantization);
+        QuantizationError error = measureQuantizationError(vertices.data(), packedVertices.data(), vertices.size(), quantization);
+        vertexFormat = VERTEX_FORMAT_PACKED;
+        std::vector<Vertex>().swap(vertices);
+        return error;
+    }
+
+    // Vertices of vertexFormat, wherever they live
+    const void* vertexData() const
+    {
+        if (cachedVertices)
+            return cachedVertices;
+        return vertexFormat == VERTEX_FORMAT_PACKED ? static_cast<const void*>(packedVertices.data()) : static_cast<const void*>(vertices.data());
+    }
+
+    size_t vertexCount() const
+    {
+        if (cachedVertices)
+            return cachedVertexCount;
+        return vertexFormat == VERTEX_FORMAT_PACKED ? packedVertices.size() : vertices.size();
+    }
+
+    size_t vertexBytes() const
+    {
+        return vertexFormat == VERTEX_FORMAT_STREAMS ? cachedVertexBytes : vertexCount() * vertexFormatStride(vertexFormat);
+    }
+
+    // Indices of indexType, wherever they live
+    const void* indexData() const
+    {
+        if (cachedIndices)
+            return cachedIndices;
+        return indexType == GL_UNSIGNED_SHORT ? static_cast<const void*>(shortIndices.data()) : static_cast<const void*>(indices.data());
+    }
+
+    size_t indexCount() const
+    {
+        if (cachedIndices)
+            return cachedIndexCount;
+        return indexType == GL_UNSIGNED_SHORT ? shortIndices.size() : indices.size();
+    }
+
+    size_t indexBytes() const
+    {
+        return indexCount() * indexTypeSize(indexType);
+    }
+};
+
+// What a Mesh keeps in RAM once its geometry is on the GPU
+enum GeometryResidency
+{
+    RESIDENCY_KEEP_ALL = 0,                 // Full vertices and indices
+    RESIDENCY_COLLISION_PROXY = 1,          // Positions and triangles of the full mesh only (collisionPositions/collisionIndices)
+    RESIDENCY_FREE_AFTER_UPLOAD = 2,        // Nothing
+    RESIDENCY_COARSE_COLLISION_PROXY = 3    // Same from the coarsest LOD: smaller, but up to its error off the drawn surface
+};
+
 // Enum for 6 DoF pose indexing
 enum
 {
@@ -35,37 +216,105 @@ enum
     rZ = 5
 };
 
-enum
-{
-    x_axis = 0,
-    y_axis = 1,
-    z_axis = 2
-};
-
 class Mesh
 {
 public:
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<Vertex> vertices;                   // Float meshes (any format: vertexAt)
+    std::vector<PackedVertex> packedVertices;       // Packed meshes (see vertexFormat)
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    VertexQuantization quantization;
+    std::vector<unsigned int> indices;      // 32-bit meshes
+    std::vector<uint16_t> shortIndices;     // 16-bit meshes (see indexType)
+    GLenum indexType = GL_UNSIGNED_INT;
+    std::vector<MeshLod> lods;              // Always at least the full mesh
+    int lodLevel = 0;                       // Level draw() uses (see selectLod)
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+    GeometryResidency residency = RESIDENCY_KEEP_ALL;
+    std::vector<glm::vec3> collisionPositions;      // Collision proxy residencies only
+    std::vector<unsigned int> collisionIndices;     // Triangles into collisionPositions
+    size_t gpuBytes = 0;                            // Vertex + index buffer size
+    size_t gpuVertexBytes = 0;                      // Vertex buffer size, not counting streamed meshes
+    size_t gpuIndexBytes = 0;
+    std::vector<MeshInstance> instances;            // Copies sharing these buffers (see drawInstanced)
+    VertexStreams streams;                          // VERTEX_FORMAT_STREAMS only
+    glm::mat4 nodeMatrix = glm::mat4(1.0f);         // Node to model space, placedByNode meshes only
+    bool placedByNode = false;
     std::vector<Texture> textures;
     glm::mat4 meshMatrix;
     std::string meshName;
+    int hierarchyNode = -1;                         // Node that moves the mesh (see Model's hierarchy), bound at load
     float mesh6DoF[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
     float initRad = 0.0f;
     float initRot = 0.0f;
 
-    // Init the mesh
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, const std::vector<Texture>& textures)
+    // Init the mesh, taking over the vectors (indices are narrowed to 16 bits if the vertices allow it)
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
-        setupMesh();
+        this->vertices = std::move(vertices);
+        this->indexType = chooseIndexType(this->vertices.size());
+        if (indexType == GL_UNSIGNED_SHORT)
+            this->shortIndices.assign(indices.begin(), indices.end());
+        else
+            this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->lods.push_back({ 0, static_cast<uint32_t>(indexCount()), 0.0f });
+        setupMesh(vertexData(), vertexBytes(), indexData(), indexBytes());
 
         // Init mesh matrix to identity
         this->meshMatrix = glm::mat4(1);
     }
 
+    // Init the mesh from an import result, taking over its vectors
+    // Without uploadNow the GPU side is left empty until attachBuffers() (see UploadWorker)
+    // The CPU copy is trimmed to the residency policy as soon as the GPU has it
+    // Mapped geometry (mesh cache, GLB) uploads straight from the mapping, which must stay open until then, and only
+    // what the residency policy keeps is copied out of it
+    Mesh(MeshData&& data, std::vector<Texture> textures, bool uploadNow = true, GeometryResidency residency = RESIDENCY_KEEP_ALL)
+    {
+        this->residency = residency;
+        this->vertexFormat = data.vertexFormat;
+        this->quantization = data.quantization;
+        this->indexType = data.indexType;
+        this->streams = data.streams;
+        this->nodeMatrix = data.nodeMatrix;
+        this->placedByNode = data.placedByNode;
+        uint32_t fullIndexCount = static_cast<uint32_t>(data.indexCount());
+        bool mapped = data.cachedVertices != nullptr;
+
+        // Keep a CPU copy for wall constraints, in vertexFormat: packed meshes fill packedVertices and leave vertices
+        // empty, so read it through vertexCount()/vertexAt()
+        if (vertexFormat != VERTEX_FORMAT_STREAMS)
+            takeGeometry(data);
+        this->textures = std::move(textures);
+        this->meshName = std::move(data.meshName);
+        this->lods = std::move(data.lods);
+        if (this->lods.empty())
+            this->lods.push_back({ 0, fullIndexCount, 0.0f });
+        if (mapped && keepsCollisionProxy() && vertexFormat != VERTEX_FORMAT_STREAMS)
+            buildCollisionProxy(data.vertexData(), data.vertexCount(), data.indexData());
+        this->boundsCenter = data.boundsCenter;
+        this->boundsRadius = data.boundsRadius;
+        this->instances = std::move(data.instances);
+        if (uploadNow)
+        {
+            if (mapped)
+                setupMesh(data.vertexData(), data.vertexBytes(), data.indexData(), data.indexBytes());
+            else
+                setupMesh(vertexData(), vertexBytes(), indexData(), indexBytes());
+            applyResidency();
+        }
+
+        // Init mesh matrix to identity
+        this->meshMatrix = glm::mat4(1);
+    }
+
+    // Owns its GL objects, so moves only
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+
     // Update mesh matrix
     void updateModelMatrix()
     {
@@ -76,115 +325,399 @@ public:
         meshMatrix = glm::rotate(meshMatrix, mesh6DoF[rZ], glm::vec3(0.0f, 0.0f, 1.0f));                // Rotate around Z-axis    
     }
 
-    // Draw the mesh
-    void draw(Shader& shader)
+    // Adopt vertex/index buffers filled elsewhere (e.g. by an UploadWorker) and build the VAO for them
+    // VAOs aren't shared between contexts, so this must run on the render thread
+    void attachBuffers(unsigned int vertexBuffer, size_t vertexBytes, unsigned int indexBuffer, size_t indexBytes)
     {
-        // If multiple textures for this mesh, loop through
-        for (unsigned int i = 0; i < static_cast<unsigned int>(textures.size()); i++)
+        VBO.reset(vertexBuffer);
+        EBO.reset(indexBuffer);
+        VAO.create();
+        GLState::instance().bindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+        setupVertexAttributes();
+        setupInstanceAttributes();
+        GLState::instance().bindVertexArray(0);
+        if (vertexFormat != VERTEX_FORMAT_STREAMS)
         {
-            // Active proper texture unit before binding
-            glActiveTexture(GL_TEXTURE0 + i); 
- 
-            // Set the sampler to the correct texture unit
-            shader.setInt("textureDiffuse" + std::to_string(i), i);
-
-            // Bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            gpuVertexBytes = vertexBytes;
+            gpuIndexBytes = indexBytes;
         }
+        gpuBytes = vertexBytes + indexBytes;
+        applyResidency();
+    }
 
-        // Draw
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // Set active back to 0
-        glActiveTexture(GL_TEXTURE0);
+    // Whether draws need the per-instance matrix: copies share the buffers, or a scene node places the mesh
+    bool drawsInstanced() const
+    {
+        return !instances.empty() || placedByNode;
     }
 
-    // Draw the mesh with hierarchy
-    void drawHierarchy(Shader& shader, glm::mat4& modelMat, float& rot, glm::vec3 meshOffset, int axis)
+    // Whether the GPU side exists yet
+    bool isUploaded() const
     {
-        glm::mat4 model = modelMat;
-        glm::mat4 trans = glm::mat4(1);
-        trans = glm::translate(trans, meshOffset);
-        switch (axis)
-        {
-        case x_axis:
-            trans = glm::rotate(trans, glm::radians(rot), glm::vec3(1.0f, 0.0f, 0.0f));
-            break;
+        return static_cast<bool>(VAO);
+    }
 
-        case y_axis:
-            trans = glm::rotate(trans, glm::radians(rot), glm::vec3(0.0f, 1.0f, 0.0f));
-            break;
+    // Vertex and index buffer names, for copying the geometry into a MeshBatch
+    GLuint vertexBuffer() const
+    {
+        return VBO.get();
+    }
 
-        case z_axis:
-            trans = glm::rotate(trans, glm::radians(rot), glm::vec3(0.0f, 0.0f, 1.0f));
-            break;
+    GLuint indexBuffer() const
+    {
+        return EBO.get();
+    }
 
-        default:
-            break;
-        }
-        trans = glm::translate(trans, -meshOffset);
-        shader.setMat4("model", model * trans);
+    // Delete the GL objects once a MeshBatch holds a copy of the geometry, the mesh can't be drawn on its own after
+    void releaseBuffers()
+    {
+        VAO.reset();
+        VBO.reset();
+        EBO.reset();
+        gpuBytes = gpuVertexBytes = gpuIndexBytes = 0;
+    }
 
-        // If multiple textures for this mesh, loop through
+    // Bind each texture to its unit and point the matching sampler at it
+    void bindTextures(Shader& shader)
+    {
         for (unsigned int i = 0; i < static_cast<unsigned int>(textures.size()); i++)
         {
-            // Active proper texture unit before binding
-            glActiveTexture(GL_TEXTURE0 + i);
+            shader.setInt(shader.textureDiffuseLocation(i), i);
+            GLState::instance().bindTexture(i, GL_TEXTURE_2D, textures[i].id);
+        }
+    }
+
+    // CPU copy of the vertices, of vertexFormat
+    const void* vertexData() const
+    {
+        return vertexFormat == VERTEX_FORMAT_PACKED ? static_cast<const void*>(packedVertices.data()) : static_cast<const void*>(vertices.data());
+    }
+
+    size_t vertexBytes() const
+    {
+        return vertexFormat == VERTEX_FORMAT_PACKED ? packedVertices.size() * sizeof(PackedVertex) : vertices.size() * sizeof(Vertex);
+    }
+
+    // Vertices in the CPU copy, whichever the format
+    size_t vertexCount() const
+    {
+        return vertexFormat == VERTEX_FORMAT_PACKED ? packedVertices.size() : vertices.size();
+    }
+
+    // A vertex of the CPU copy in full precision, dequantized like the vertex shader does for packed meshes
+    Vertex vertexAt(size_t index) const
+    {
+        return vertexFormat == VERTEX_FORMAT_PACKED ? dequantizeVertex(packedVertices[index], quantization) : vertices[index];
+    }
+
+    // CPU copy of the indices, of indexType
+    const void* indexData() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? static_cast<const void*>(shortIndices.data()) : static_cast<const void*>(indices.data());
+    }
+
+    size_t indexCount() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? shortIndices.size() : indices.size();
+    }
+
+    size_t indexBytes() const
+    {
+        return indexCount() * indexTypeSize(indexType);
+    }
+
+    // RAM held by the full vertex/index copies and by the collision proxy
+    size_t cpuGeometryBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + packedVertices.capacity() * sizeof(PackedVertex) +
+            indices.capacity() * sizeof(unsigned int) + shortIndices.capacity() * sizeof(uint16_t);
+    }
+
+    size_t collisionBytes() const
+    {
+        return collisionPositions.capacity() * sizeof(glm::vec3) + collisionIndices.capacity() * sizeof(unsigned int);
+    }
+
+    // Detail level the collision proxy is built from, and how far off the drawn surface that leaves it (model units)
+    size_t collisionLod() const
+    {
+        return residency == RESIDENCY_COARSE_COLLISION_PROXY ? lods.size() - 1 : 0;
+    }
 
-            // Set the sampler to the correct texture unit
-            shader.setInt("textureDiffuse" + std::to_string(i), i);
+    float collisionError() const
+    {
+        return keepsCollisionProxy() ? lods[collisionLod()].error : 0.0f;
+    }
 
-            // Bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    // Pick the detail level for the next draws, pixelsPerUnit being how many screen pixels one model unit covers
+    void selectLod(float pixelsPerUnit, float pixelThreshold = 1.0f, float hysteresis = 0.25f)
+    {
+        int level = 0;
+        for (int i = 1; i < static_cast<int>(lods.size()); i++)
+        {
+            // Coarser levels must get well under the threshold before switching, finer ones are kept until well over it
+            float limit = pixelThreshold * (i <= lodLevel ? 1.0f + hysteresis : 1.0f - hysteresis);
+            if (lods[i].error * pixelsPerUnit > limit)
+                break;
+            level = i;
         }
+        lodLevel = level;
+    }
 
-        // Draw
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    // Draw the mesh
+    void draw(Shader& shader)
+    {
+        bindTextures(shader);
 
-        // Set active back to 0
-        glActiveTexture(GL_TEXTURE0);
+        // Draw, the VAO and textures stay bound for the next draw to reuse or replace
+        setVertexFormatUniforms(shader);
+        GLState::instance().bindVertexArray(VAO.get());
+        drawLod();
+    }
+
+    // Draw this mesh once per matrix (model space, applied before the shader's model matrix) in a single call per
+    // handedness: mirrored copies wind their triangles the other way, so they go in a second call with the front face flipped
+    void drawInstanced(Shader& shader, const std::vector<glm::mat4>& matrices, const std::vector<glm::mat4>& mirroredMatrices)
+    {
+        bindTextures(shader);
 
-        // Reset model matrix
-        shader.setMat4("model", modelMat);
+        // Both batches in one upload, orphaning last frame's storage
+        size_t total = matrices.size() + mirroredMatrices.size();
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.get());
+        glBufferData(GL_ARRAY_BUFFER, total * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, matrices.size() * sizeof(glm::mat4), matrices.data());
+        glBufferSubData(GL_ARRAY_BUFFER, matrices.size() * sizeof(glm::mat4), mirroredMatrices.size() * sizeof(glm::mat4), mirroredMatrices.data());
+
+        // Draw
+        setVertexFormatUniforms(shader);
+        shader.setBool(shader.drawUniforms.instanced, true);
+        GLState& state = GLState::instance();
+        state.bindVertexArray(VAO.get());
+        if (!matrices.empty())
+        {
+            pointInstanceAttributes(0);
+            drawLodInstanced(static_cast<GLsizei>(matrices.size()));
+        }
+        if (!mirroredMatrices.empty())
+        {
+            GLenum frontFace = state.frontFace();
+            state.setFrontFace(frontFace == GL_CCW ? GL_CW : GL_CCW);
+            pointInstanceAttributes(matrices.size() * sizeof(glm::mat4));
+            drawLodInstanced(static_cast<GLsizei>(mirroredMatrices.size()));
+            state.setFrontFace(frontFace);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        shader.setBool(shader.drawUniforms.instanced, false);
     }
 
 private:
-    unsigned int VAO, VBO, EBO;
+    GLVertexArray VAO;
+    GLBuffer VBO, EBO;
+    GLBuffer instanceBuffer;    // Per-instance model matrices, meshes with instances only
 
     // Setup
-    void setupMesh()
+    void setupMesh(const void* vertexData, size_t vertexBytes, const void* indexData, size_t indexBytes)
     {
         // Create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        VAO.create();
+        VBO.create();
+        EBO.create();
 
         // Bind VAO
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        GLState::instance().bindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
 
         // EBO
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW);
+        if (vertexFormat != VERTEX_FORMAT_STREAMS)
+        {
+            gpuVertexBytes = vertexBytes;
+            gpuIndexBytes = indexBytes;
+        }
+        gpuBytes = vertexBytes + indexBytes;
 
-        // Vertex positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        setupVertexAttributes();
+        setupInstanceAttributes();
+        GLState::instance().bindVertexArray(0);
+    }
 
-        // Vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        
-        // Vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    // Take over an import result's vectors. A mapped mesh cache can't be moved from, it's copied only when the
+    // residency policy keeps the full geometry (the collision proxy is built straight from the mapping)
+    void takeGeometry(MeshData& data)
+    {
+        if (data.cachedVertices && residency != RESIDENCY_KEEP_ALL)
+            return;
+        if (data.cachedVertices)
+        {
+            if (vertexFormat == VERTEX_FORMAT_PACKED)
+                this->packedVertices.assign(static_cast<const PackedVertex*>(data.cachedVertices), static_cast<const PackedVertex*>(data.cachedVertices) + data.cachedVertexCount);
+            else
+                this->vertices.assign(static_cast<const Vertex*>(data.cachedVertices), static_cast<const Vertex*>(data.cachedVertices) + data.cachedVertexCount);
+        }
+        else
+        {
+            this->vertices = std::move(data.vertices);
+            this->packedVertices = std::move(data.packedVertices);
+        }
+        if (data.cachedIndices)
+        {
+            if (indexType == GL_UNSIGNED_SHORT)
+                this->shortIndices.assign(static_cast<const uint16_t*>(data.cachedIndices), static_cast<const uint16_t*>(data.cachedIndices) + data.cachedIndexCount);
+            else
+                this->indices.assign(static_cast<const unsigned int*>(data.cachedIndices), static_cast<const unsigned int*>(data.cachedIndices) + data.cachedIndexCount);
+        }
+        else
+        {
+            this->indices = std::move(data.indices);
+            this->shortIndices = std::move(data.shortIndices);
+        }
+    }
+
+    // Drop whatever the residency policy doesn't keep, once the buffers hold the data
+    void applyResidency()
+    {
+        if (residency == RESIDENCY_KEEP_ALL)
+            return;
+        if (keepsCollisionProxy() && collisionIndices.empty() && vertexCount() > 0)
+            buildCollisionProxy(vertexData(), vertexCount(), indexData());
+
+        std::vector<Vertex>().swap(vertices);
+        std::vector<PackedVertex>().swap(packedVertices);
+        std::vector<unsigned int>().swap(indices);
+        std::vector<uint16_t>().swap(shortIndices);
+    }
+
+    bool keepsCollisionProxy() const
+    {
+        return residency == RESIDENCY_COLLISION_PROXY || residency == RESIDENCY_COARSE_COLLISION_PROXY;
+    }
+
+    // Float positions of the vertices the proxy's detail level uses, welded by value (corners split for their normals
+    // or UVs become one), and its triangles remapped onto them
+    // Reads vertices and indices of vertexFormat/indexType, the mesh's own CPU copy or a mapping's
+    void buildCollisionProxy(const void* vertexData, size_t vertexCount, const void* indexData)
+    {
+        const MeshLod& lod = lods[collisionLod()];
+        auto indexAt = [&](uint32_t i) -> unsigned int
+        {
+            return indexType == GL_UNSIGNED_SHORT ? static_cast<const uint16_t*>(indexData)[i] : static_cast<const unsigned int*>(indexData)[i];
+        };
+
+        // Positions of the vertices the level uses
+        std::vector<unsigned int> remap(vertexCount, UINT32_MAX);
+        std::vector<glm::vec3> used;
+        for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; i++)
+        {
+            unsigned int vertex = indexAt(i);
+            if (remap[vertex] == UINT32_MAX)
+            {
+                remap[vertex] = static_cast<unsigned int>(used.size());
+                used.push_back(vertexFormat == VERTEX_FORMAT_PACKED
+                    ? dequantizeVertex(static_cast<const PackedVertex*>(vertexData)[vertex], quantization).Position
+                    : static_cast<const Vertex*>(vertexData)[vertex].Position);
+            }
+        }
+
+        // Weld equal positions: sorted, each run of equal ones becomes one proxy vertex
+        std::vector<unsigned int> order(used.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = static_cast<unsigned int>(i);
+        auto less = [&](unsigned int a, unsigned int b)
+        {
+            const glm::vec3& p = used[a];
+            const glm::vec3& q = used[b];
+            return p.x != q.x ? p.x < q.x : (p.y != q.y ? p.y < q.y : p.z < q.z);
+        };
+        std::sort(order.begin(), order.end(), less);
+        std::vector<unsigned int> welded(used.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (i == 0 || less(order[i - 1], order[i]))
+                collisionPositions.push_back(used[order[i]]);
+            welded[order[i]] = static_cast<unsigned int>(collisionPositions.size() - 1);
+        }
+
+        collisionIndices.reserve(lod.indexCount);
+        for (uint32_t i = lod.firstIndex; i < lod.firstIndex + lod.indexCount; i++)
+            collisionIndices.push_back(welded[remap[indexAt(i)]]);
+        collisionPositions.shrink_to_fit();
+    }
 
-        glBindVertexArray(0);
+    // Issue the draw for the selected detail level, VAO bound
+    void drawLod()
+    {
+        const MeshLod& lod = lods[lodLevel];
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lod.indexCount), indexType, (void*)(lod.firstIndex * indexTypeSize(indexType)));
+    }
+
+    void drawLodInstanced(GLsizei instanceCount)
+    {
+        const MeshLod& lod = lods[lodLevel];
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(lod.indexCount), indexType, (void*)(lod.firstIndex * indexTypeSize(indexType)), instanceCount);
+    }
+
+    // Per-instance matrix (locations 3-6, one column each) for the bound VAO, meshes drawn instanced only
+    void setupInstanceAttributes()
+    {
+        if (!drawsInstanced())
+            return;
+        instanceBuffer.create();
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer.get());
+        pointInstanceAttributes(0);
+        for (GLuint column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
+    }
+
+    // Aim the instance matrix at a byte offset into instanceBuffer (bound to GL_ARRAY_BUFFER), so batches can share it
+    void pointInstanceAttributes(size_t offset)
+    {
+        for (GLuint column = 0; column < 4; column++)
+            glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + column * sizeof(glm::vec4)));
+    }
+
+    // Tell the vertex shader how to read this mesh's attributes (shared shaders see both formats)
+    void setVertexFormatUniforms(Shader& shader)
+    {
+        const DrawUniforms& uniforms = shader.drawUniforms;
+        shader.setBool(uniforms.quantized, vertexFormat == VERTEX_FORMAT_PACKED);
+        if (vertexFormat == VERTEX_FORMAT_PACKED)
+        {
+            shader.setVec3(uniforms.positionOffset, quantization.positionOffset);
+            shader.setVec3(uniforms.positionScale, quantization.positionScale);
+            shader.setVec2(uniforms.texCoordOffset, quantization.texCoordOffset);
+            shader.setVec2(uniforms.texCoordScale, quantization.texCoordScale);
+        }
+    }
+
+    // Vertex layout for the bound VAO/VBO
+    void setupVertexAttributes()
+    {
+        if (vertexFormat == VERTEX_FORMAT_STREAMS)
+        {
+            // Attribute arrays as the file stores them
+            setupStreamAttribute(0, streams.position);
+            setupStreamAttribute(1, streams.normal);
+            setupStreamAttribute(2, streams.texCoords);
+            return;
+        }
+
+        setupInterleavedAttributes(vertexFormat);
+    }
+
+    // One attribute array of a streamed mesh, left disabled (reading the GL default) when the mesh lacks it
+    void setupStreamAttribute(GLuint location, const VertexStream& stream)
+    {
+        if (stream.type == 0)
+            return;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, stream.components, stream.type, stream.normalized ? GL_TRUE : GL_FALSE, stream.stride, (void*)(size_t)stream.offset);
     }
 };
 #endif
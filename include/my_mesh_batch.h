@@ -0,0 +1,335 @@
+#ifndef MY_MESH_BATCH_H
+#define MY_MESH_BATCH_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <my_gl_object.h>
+#include <my_gl_state.h>
+#include <my_mesh.h>
+#include <my_shader.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Binding point of the ModelParts uniform block (FrameData has FRAME_UNIFORMS_BINDING, 0)
+const GLuint MODEL_PARTS_BINDING = 1;
+
+// Parts one MeshBatch holds, the size of the ModelParts array in the vertex shaders (128 * 112 bytes fits the
+// 16 KB every implementation allows for a uniform block). Meshes past it are drawn on their own
+const unsigned int MAX_BATCH_PARTS = 128;
+
+// A merged mesh as the vertex shaders read it from ModelParts, indexed by the part index each vertex carries
+struct BatchPart
+{
+    glm::mat4 transform = glm::mat4(1.0f);                              // Applied before the model matrix
+    glm::vec4 positionOffset = glm::vec4(0.0f);                         // Quantization of packed vertices (xyz)
+    glm::vec4 positionScale = glm::vec4(1.0f);
+    glm::vec4 texCoordTransform = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);    // Offset xy, scale zw
+};
+static_assert(sizeof(BatchPart) == 112, "BatchPart must match the std140 layout of ModelPart");
+
+// glMultiDrawElementsIndirect's command layout (GL 4.3)
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// A model's static meshes copied into one vertex and one index buffer, each at its own base vertex and first index,
+// and drawn with one multi-draw per material instead of a VAO bind and a draw per mesh
+// Every vertex carries its part index, so moving parts still get their own transform (setTransform) in the same draw
+// GL 4.3 contexts take the commands from an indirect buffer, 3.3 ones pass them to glMultiDrawElementsBaseVertex
+// Render thread only, like the meshes' own GL objects
+class MeshBatch
+{
+public:
+    // Merge the meshes that can share a layout: uploaded, not drawn instanced and not streamed (their attribute layouts
+    // are per mesh), all of the first one's vertex format. The geometry is copied on the GPU, the merged meshes' own
+    // buffers are deleted. Returns whether anything was merged (it takes two meshes to save a draw)
+    bool build(std::vector<Mesh>& meshes)
+    {
+        std::vector<size_t> candidates;
+        for (size_t i = 0; i < meshes.size() && candidates.size() < MAX_BATCH_PARTS; i++)
+        {
+            const Mesh& mesh = meshes[i];
+            if (!mesh.isUploaded() || mesh.drawsInstanced() || mesh.vertexFormat == VERTEX_FORMAT_STREAMS)
+                continue;
+            if (candidates.empty())
+                vertexFormat = mesh.vertexFormat;
+            if (mesh.vertexFormat == vertexFormat)
+                candidates.push_back(i);
+        }
+        if (candidates.size() < 2)
+            return false;
+
+        // Lay the parts out back to back, index ranges aligned to their element size so firstIndex is exact
+        size_t stride = vertexFormatStride(vertexFormat);
+        size_t vertexBytes = 0, indexBytes = 0;
+        partOfMesh.assign(meshes.size(), -1);
+        for (size_t meshIndex : candidates)
+        {
+            const Mesh& mesh = meshes[meshIndex];
+            BatchRange range;
+            range.mesh = meshIndex;
+            range.baseVertex = static_cast<GLint>(vertexBytes / stride);
+            range.indexOffset = (indexBytes + 3) & ~static_cast<size_t>(3);
+            vertexBytes += mesh.gpuVertexBytes;
+            indexBytes = range.indexOffset + mesh.gpuIndexBytes;
+
+            BatchPart part;
+            if (vertexFormat == VERTEX_FORMAT_PACKED)
+            {
+                const VertexQuantization& quantization = mesh.quantization;
+                part.positionOffset = glm::vec4(quantization.positionOffset, 0.0f);
+                part.positionScale = glm::vec4(quantization.positionScale, 1.0f);
+                part.texCoordTransform = glm::vec4(quantization.texCoordOffset.x, quantization.texCoordOffset.y, quantization.texCoordScale.x, quantization.texCoordScale.y);
+            }
+            partOfMesh[meshIndex] = static_cast<int>(ranges.size());
+            ranges.push_back(range);
+            parts.push_back(part);
+        }
+
+        // Copy the geometry over without a round trip through RAM
+        VBO.create();
+        EBO.create();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO.get());
+        glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+        for (const BatchRange& range : ranges)
+        {
+            const Mesh& mesh = meshes[range.mesh];
+            glBindBuffer(GL_COPY_READ_BUFFER, mesh.vertexBuffer());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, range.baseVertex * stride, mesh.gpuVertexBytes);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO.get());
+        glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+        for (const BatchRange& range : ranges)
+        {
+            const Mesh& mesh = meshes[range.mesh];
+            glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBuffer());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, range.indexOffset, mesh.gpuIndexBytes);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        // Part index of every vertex (location 7), the shaders look the part's transform and quantization up with it
+        std::vector<uint16_t> vertexParts(vertexBytes / stride);
+        for (size_t part = 0; part < ranges.size(); part++)
+        {
+            size_t first = ranges[part].baseVertex;
+            size_t count = meshes[ranges[part].mesh].gpuVertexBytes / stride;
+            std::fill(vertexParts.begin() + first, vertexParts.begin() + first + count, static_cast<uint16_t>(part));
+        }
+        partIndexBuffer.create();
+        glBindBuffer(GL_ARRAY_BUFFER, partIndexBuffer.get());
+        glBufferData(GL_ARRAY_BUFFER, vertexParts.size() * sizeof(uint16_t), vertexParts.data(), GL_STATIC_DRAW);
+
+        VAO.create();
+        GLState::instance().bindVertexArray(VAO.get());
+        glEnableVertexAttribArray(7);
+        glVertexAttribIPointer(7, 1, GL_UNSIGNED_SHORT, sizeof(uint16_t), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        setupInterleavedAttributes(vertexFormat);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+        GLState::instance().bindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        partBuffer.create();
+        glBindBuffer(GL_UNIFORM_BUFFER, partBuffer.get());
+        glBufferData(GL_UNIFORM_BUFFER, MAX_BATCH_PARTS * sizeof(BatchPart), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, parts.size() * sizeof(BatchPart), parts.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // One multi-draw per material (same textures) and index type
+        for (size_t part = 0; part < ranges.size(); part++)
+        {
+            const Mesh& mesh = meshes[ranges[part].mesh];
+            size_t group = 0;
+            while (group < groups.size() && !sameMaterial(meshes[groups[group].mesh], mesh))
+                group++;
+            if (group == groups.size())
+                groups.push_back({ ranges[part].mesh, mesh.indexType, {} });
+            groups[group].parts.push_back(part);
+        }
+
+        useIndirect = GLAD_GL_VERSION_4_3 != 0;
+        if (useIndirect)
+            indirectBuffer.create();
+
+        bufferBytes = vertexBytes + indexBytes + vertexParts.size() * sizeof(uint16_t) + MAX_BATCH_PARTS * sizeof(BatchPart) +
+            (useIndirect ? ranges.size() * sizeof(DrawElementsIndirectCommand) : 0);
+
+        for (const BatchRange& range : ranges)
+            meshes[range.mesh].releaseBuffers();
+
+        std::cout << "Mesh batch: merged " << ranges.size() << " meshes into " << groups.size() << " draw(s)"
+            << (useIndirect ? " (indirect)" : "") << std::endl;
+        return true;
+    }
+
+    // Whether meshes[meshIndex] is drawn by the batch rather than on its own
+    bool contains(size_t meshIndex) const
+    {
+        return meshIndex < partOfMesh.size() && partOfMesh[meshIndex] >= 0;
+    }
+
+    // Transform of a merged mesh within the model (identity until set), uploaded with the next draw if it changed
+    void setTransform(size_t meshIndex, const glm::mat4& transform)
+    {
+        BatchPart& part = parts[partOfMesh[meshIndex]];
+        if (part.transform != transform)
+        {
+            part.transform = transform;
+            partsDirty = true;
+        }
+    }
+
+    // Draw every merged mesh at its selected detail level, the model uniform already set
+    void draw(Shader& shader, std::vector<Mesh>& meshes)
+    {
+        if (ranges.empty())
+            return;
+
+        if (partsDirty)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, partBuffer.get());
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, parts.size() * sizeof(BatchPart), parts.data());
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            partsDirty = false;
+        }
+        glBindBufferBase(GL_UNIFORM_BUFFER, MODEL_PARTS_BINDING, partBuffer.get());
+
+        shader.setBool(shader.drawUniforms.merged, true);
+        shader.setBool(shader.drawUniforms.quantized, vertexFormat == VERTEX_FORMAT_PACKED);
+        GLState::instance().bindVertexArray(VAO.get());
+        if (useIndirect)
+            drawIndirect(shader, meshes);
+        else
+            drawMulti(shader, meshes);
+        shader.setBool(shader.drawUniforms.merged, false);
+    }
+
+    // Draw calls per frame and meshes they cover
+    size_t drawCount() const
+    {
+        return groups.size();
+    }
+
+    size_t partCount() const
+    {
+        return ranges.size();
+    }
+
+    // Size of every buffer the batch owns: merged vertices and indices, part indices, the uniform block and draw commands
+    size_t gpuBytes() const
+    {
+        return bufferBytes;
+    }
+
+private:
+    // Where a merged mesh's geometry landed
+    struct BatchRange
+    {
+        size_t mesh;
+        GLint baseVertex;
+        size_t indexOffset;     // Bytes
+    };
+
+    // Parts drawn together: same textures (those of mesh) and index type
+    struct BatchGroup
+    {
+        size_t mesh;
+        GLenum indexType;
+        std::vector<size_t> parts;
+    };
+
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    std::vector<BatchRange> ranges;
+    std::vector<BatchPart> parts;
+    std::vector<BatchGroup> groups;
+    std::vector<int> partOfMesh;        // Part index by mesh index, -1 for meshes drawn on their own
+    bool partsDirty = false;
+    bool useIndirect = false;
+    size_t bufferBytes = 0;
+
+    GLVertexArray VAO;
+    GLBuffer VBO, EBO;
+    GLBuffer partIndexBuffer;       // Part index per vertex
+    GLBuffer partBuffer;            // ModelParts uniform block
+    GLBuffer indirectBuffer;        // GL 4.3 only
+
+    // Per-frame draw arguments, kept to reuse their storage
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    std::vector<DrawElementsIndirectCommand> commands;
+
+    static bool sameMaterial(const Mesh& a, const Mesh& b)
+    {
+        if (a.indexType != b.indexType || a.textures.size() != b.textures.size())
+            return false;
+        for (size_t i = 0; i < a.textures.size(); i++)
+        {
+            if (a.textures[i].id != b.textures[i].id)
+                return false;
+        }
+        return true;
+    }
+
+    void drawMulti(Shader& shader, std::vector<Mesh>& meshes)
+    {
+        for (const BatchGroup& group : groups)
+        {
+            counts.clear();
+            offsets.clear();
+            baseVertices.clear();
+            size_t indexSize = indexTypeSize(group.indexType);
+            for (size_t part : group.parts)
+            {
+                const BatchRange& range = ranges[part];
+                const Mesh& mesh = meshes[range.mesh];
+                const MeshLod& lod = mesh.lods[mesh.lodLevel];
+                counts.push_back(static_cast<GLsizei>(lod.indexCount));
+                offsets.push_back((void*)(range.indexOffset + lod.firstIndex * indexSize));
+                baseVertices.push_back(range.baseVertex);
+            }
+            meshes[group.mesh].bindTextures(shader);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), group.indexType, offsets.data(), static_cast<GLsizei>(counts.size()), baseVertices.data());
+        }
+    }
+
+    // Every group's commands in one upload, each group then draws its slice of the buffer
+    void drawIndirect(Shader& shader, std::vector<Mesh>& meshes)
+    {
+        commands.clear();
+        for (const BatchGroup& group : groups)
+        {
+            size_t indexSize = indexTypeSize(group.indexType);
+            for (size_t part : group.parts)
+            {
+                const BatchRange& range = ranges[part];
+                const Mesh& mesh = meshes[range.mesh];
+                const MeshLod& lod = mesh.lods[mesh.lodLevel];
+                commands.push_back({ lod.indexCount, 1, static_cast<GLuint>(range.indexOffset / indexSize + lod.firstIndex), range.baseVertex, 0 });
+            }
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.get());
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+        size_t first = 0;
+        for (const BatchGroup& group : groups)
+        {
+            meshes[group.mesh].bindTextures(shader);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, group.indexType, (void*)(first * sizeof(DrawElementsIndirectCommand)), static_cast<GLsizei>(group.parts.size()), 0);
+            first += group.parts.size();
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+};
+#endif // MY_MESH_BATCH_H
@@ -0,0 +1,408 @@
+#ifndef MY_MESH_CACHE_H
+#define MY_MESH_CACHE_H
+
+#include <my_asset_pack.h>
+#include <my_mesh.h>
+#include <my_mesh_codec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Binary mesh cache written next to a source model (e.g. "models/spitfire.obj.meshcache")
+// Layout: header | mesh table | texture table | instance table | string table | 16-byte aligned vertex/index blobs
+// Blobs are raw, or encoded with my_mesh_codec.h when the cache was written compressed
+// Bump the version whenever Vertex, PackedVertex, MeshLod or the layout below changes
+const char MESH_CACHE_MAGIC[8] = { 'M', 'E', 'S', 'H', 'C', 'C', 'H', '\0' };
+const uint32_t MESH_CACHE_VERSION = 7;
+const char* const MESH_CACHE_EXTENSION = ".meshcache";
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexSize;        // sizeof(Vertex) when written
+    uint64_t sourceHash;        // Hash of the OBJ and its MTL files
+    uint32_t importFlags;       // Assimp post-processing flags used
+    uint32_t processFlags;      // Our own post-import steps (e.g. MODEL_PROCESS_OPTIMIZE)
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t instanceCount;
+    uint32_t stringTableSize;
+};
+
+struct MeshCacheEntry
+{
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint32_t nameOffset;        // Into string table
+    uint32_t nameLength;
+    uint32_t firstTexture;      // Into texture table
+    uint32_t textureCount;
+    uint32_t indexSize;         // 2 or 4 bytes per index
+    uint32_t vertexFormat;      // VertexFormat
+    VertexQuantization quantization;
+    uint32_t lodCount;          // Levels used in lods, 0 for none
+    MeshLod lods[MAX_MESH_LODS];
+    float boundsCenter[3];
+    float boundsRadius;
+    uint32_t firstInstance;     // Into instance table
+    uint32_t instanceCount;
+    uint64_t vertexEncodedSize; // Bytes of the encoded blobs, 0 when stored raw
+    uint64_t indexEncodedSize;
+};
+
+struct MeshCacheString
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+// A MeshInstance
+struct MeshCacheInstance
+{
+    uint32_t nameOffset;        // Into string table
+    uint32_t nameLength;
+    float transform[16];        // Column major
+    uint32_t mirrored;
+};
+
+// A mesh inside a mapped cache, pointers are valid while the cache stays open
+struct CachedMeshView
+{
+    std::string meshName;
+    std::vector<std::string> texturePaths;
+    const void* vertices;
+    size_t vertexCount;
+    VertexFormat vertexFormat;
+    VertexQuantization quantization;
+    const void* indices;
+    size_t indexCount;
+    GLenum indexType;
+    std::vector<MeshLod> lods;
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    std::vector<MeshInstance> instances;
+
+    // Set when vertices/indices point at encoded streams to decode (see my_mesh_codec.h)
+    size_t vertexEncodedSize;
+    size_t indexEncodedSize;
+};
+
+// FNV-1a over a block of bytes
+uint64_t hashBytes(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Material libraries an OBJ's "mtllib" lines reference, as paths relative to the OBJ's directory
+std::vector<std::string> findMaterialLibraries(const std::string& path, const unsigned char* data, size_t size)
+{
+    std::string directory;
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos)
+        directory = path.substr(0, slash + 1);
+
+    std::vector<std::string> libraries;
+    const char* text = reinterpret_cast<const char*>(data);
+    const char* end = text + size;
+    const char* line = text;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+
+        if (lineEnd - line > 7 && strncmp(line, "mtllib ", 7) == 0)
+        {
+            std::string mtlName(line + 7, lineEnd);
+            while (!mtlName.empty() && (mtlName.back() == '\r' || mtlName.back() == ' '))
+                mtlName.pop_back();
+            libraries.push_back(directory + mtlName);
+        }
+        line = lineEnd + 1;
+    }
+    return libraries;
+}
+
+// Hash a model file and, for OBJs, the MTL files it references (texture paths come from those)
+uint64_t hashModelSources(const std::string& path)
+{
+    AssetFile source(path);
+    if (!source.isOpen())
+        return 0;
+    uint64_t hash = hashBytes(source.data(), source.size());
+    for (const std::string& library : findMaterialLibraries(path, source.data(), source.size()))
+    {
+        AssetFile mtl(library);
+        if (mtl.isOpen())
+            hash = hashBytes(mtl.data(), mtl.size(), hash);
+    }
+    return hash;
+}
+
+class MeshCache
+{
+public:
+    // Map a cache file and validate it against the current source hash and import/process flags
+    bool open(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, unsigned int processFlags)
+    {
+        close();
+        if (!file.open(cachePath))
+            return false;
+
+        const unsigned char* base = file.data();
+        size_t size = file.size();
+        if (size < sizeof(MeshCacheHeader))
+            return fail();
+
+        MeshCacheHeader header;
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+            header.version != MESH_CACHE_VERSION ||
+            header.vertexSize != sizeof(Vertex) ||
+            header.sourceHash != sourceHash ||
+            header.importFlags != importFlags ||
+            header.processFlags != processFlags)
+            return fail();
+
+        // Tables directly follow the header
+        size_t meshTableOffset = sizeof(MeshCacheHeader);
+        size_t textureTableOffset = meshTableOffset + header.meshCount * sizeof(MeshCacheEntry);
+        size_t instanceTableOffset = textureTableOffset + header.textureCount * sizeof(MeshCacheString);
+        size_t stringTableOffset = instanceTableOffset + header.instanceCount * sizeof(MeshCacheInstance);
+        if (stringTableOffset + header.stringTableSize > size)
+            return fail();
+        const char* strings = reinterpret_cast<const char*>(base + stringTableOffset);
+
+        views.reserve(header.meshCount);
+        for (uint32_t i = 0; i < header.meshCount; i++)
+        {
+            MeshCacheEntry entry;
+            memcpy(&entry, base + meshTableOffset + i * sizeof(MeshCacheEntry), sizeof(entry));
+
+            // Bounds check everything before handing out pointers
+            if ((entry.indexSize != sizeof(uint16_t) && entry.indexSize != sizeof(unsigned int)) ||
+                (entry.vertexFormat != VERTEX_FORMAT_FLOAT && entry.vertexFormat != VERTEX_FORMAT_PACKED) ||
+                entry.vertexOffset + (entry.vertexEncodedSize != 0 ? entry.vertexEncodedSize : entry.vertexCount * vertexFormatStride(static_cast<VertexFormat>(entry.vertexFormat))) > size ||
+                entry.indexOffset + (entry.indexEncodedSize != 0 ? entry.indexEncodedSize : entry.indexCount * entry.indexSize) > size ||
+                entry.nameOffset + entry.nameLength > header.stringTableSize ||
+                entry.firstTexture + entry.textureCount > header.textureCount ||
+                entry.firstInstance + entry.instanceCount > header.instanceCount ||
+                entry.lodCount > static_cast<uint32_t>(MAX_MESH_LODS))
+                return fail();
+            for (uint32_t l = 0; l < entry.lodCount; l++)
+            {
+                if (static_cast<uint64_t>(entry.lods[l].firstIndex) + entry.lods[l].indexCount > entry.indexCount)
+                    return fail();
+            }
+
+            CachedMeshView view;
+            view.meshName.assign(strings + entry.nameOffset, entry.nameLength);
+            for (uint32_t t = 0; t < entry.textureCount; t++)
+            {
+                MeshCacheString path;
+                memcpy(&path, base + textureTableOffset + (entry.firstTexture + t) * sizeof(MeshCacheString), sizeof(path));
+                if (path.offset + path.length > header.stringTableSize)
+                    return fail();
+                view.texturePaths.emplace_back(strings + path.offset, path.length);
+            }
+            for (uint32_t n = 0; n < entry.instanceCount; n++)
+            {
+                MeshCacheInstance instance;
+                memcpy(&instance, base + instanceTableOffset + (entry.firstInstance + n) * sizeof(MeshCacheInstance), sizeof(instance));
+                if (instance.nameOffset + instance.nameLength > header.stringTableSize)
+                    return fail();
+                MeshInstance meshInstance;
+                meshInstance.meshName.assign(strings + instance.nameOffset, instance.nameLength);
+                memcpy(&meshInstance.transform, instance.transform, sizeof(instance.transform));
+                meshInstance.mirrored = instance.mirrored != 0;
+                view.instances.push_back(meshInstance);
+            }
+            view.vertices = base + entry.vertexOffset;
+            view.vertexCount = static_cast<size_t>(entry.vertexCount);
+            view.vertexFormat = static_cast<VertexFormat>(entry.vertexFormat);
+            view.quantization = entry.quantization;
+            view.indices = base + entry.indexOffset;
+            view.indexCount = static_cast<size_t>(entry.indexCount);
+            view.indexType = entry.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            view.lods.assign(entry.lods, entry.lods + entry.lodCount);
+            view.boundsCenter = glm::vec3(entry.boundsCenter[0], entry.boundsCenter[1], entry.boundsCenter[2]);
+            view.boundsRadius = entry.boundsRadius;
+            view.vertexEncodedSize = static_cast<size_t>(entry.vertexEncodedSize);
+            view.indexEncodedSize = static_cast<size_t>(entry.indexEncodedSize);
+            views.push_back(view);
+        }
+        return true;
+    }
+
+    void close()
+    {
+        views.clear();
+        file.close();
+    }
+
+    const std::vector<CachedMeshView>& meshes() const { return views; }
+
+private:
+    AssetFile file;
+    std::vector<CachedMeshView> views;
+
+    bool fail()
+    {
+        close();
+        return false;
+    }
+};
+
+// Pad the output stream to a 16-byte boundary
+void alignMeshCacheStream(std::ofstream& out, uint64_t& offset)
+{
+    static const char zeros[16] = {};
+    size_t padding = static_cast<size_t>((16 - (offset % 16)) % 16);
+    out.write(zeros, padding);
+    offset += padding;
+}
+
+// Write a cache for the given meshes, written to a temp file first so readers never see a partial cache
+// With compress the vertex and index blobs are encoded (see my_mesh_codec.h), smaller on disk but decoded on load
+bool writeMeshCache(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, unsigned int processFlags, const std::vector<MeshData>& meshes,
+    bool compress = false)
+{
+    MeshCacheHeader header;
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.sourceHash = sourceHash;
+    header.importFlags = importFlags;
+    header.processFlags = processFlags;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.textureCount = 0;
+
+    // Build string and texture tables
+    std::string strings;
+    std::vector<MeshCacheString> textures;
+    std::vector<MeshCacheInstance> instances;
+    std::vector<MeshCacheEntry> entries(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        entries[i].nameOffset = static_cast<uint32_t>(strings.size());
+        entries[i].nameLength = static_cast<uint32_t>(meshes[i].meshName.size());
+        strings += meshes[i].meshName;
+
+        entries[i].indexSize = static_cast<uint32_t>(indexTypeSize(meshes[i].indexType));
+        entries[i].vertexFormat = meshes[i].vertexFormat;
+        entries[i].quantization = meshes[i].quantization;
+        entries[i].lodCount = static_cast<uint32_t>(std::min(meshes[i].lods.size(), static_cast<size_t>(MAX_MESH_LODS)));
+        std::copy(meshes[i].lods.begin(), meshes[i].lods.begin() + entries[i].lodCount, entries[i].lods);
+        entries[i].boundsCenter[0] = meshes[i].boundsCenter.x;
+        entries[i].boundsCenter[1] = meshes[i].boundsCenter.y;
+        entries[i].boundsCenter[2] = meshes[i].boundsCenter.z;
+        entries[i].boundsRadius = meshes[i].boundsRadius;
+        entries[i].firstTexture = static_cast<uint32_t>(textures.size());
+        entries[i].textureCount = static_cast<uint32_t>(meshes[i].texturePaths.size());
+        for (const std::string& texturePath : meshes[i].texturePaths)
+        {
+            textures.push_back({ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(texturePath.size()) });
+            strings += texturePath;
+        }
+        entries[i].firstInstance = static_cast<uint32_t>(instances.size());
+        entries[i].instanceCount = static_cast<uint32_t>(meshes[i].instances.size());
+        for (const MeshInstance& meshInstance : meshes[i].instances)
+        {
+            MeshCacheInstance instance;
+            instance.nameOffset = static_cast<uint32_t>(strings.size());
+            instance.nameLength = static_cast<uint32_t>(meshInstance.meshName.size());
+            memcpy(instance.transform, &meshInstance.transform, sizeof(instance.transform));
+            instance.mirrored = meshInstance.mirrored ? 1 : 0;
+            instances.push_back(instance);
+            strings += meshInstance.meshName;
+        }
+    }
+    header.textureCount = static_cast<uint32_t>(textures.size());
+    header.instanceCount = static_cast<uint32_t>(instances.size());
+    header.stringTableSize = static_cast<uint32_t>(strings.size());
+
+    // Encode up front, the layout needs the sizes
+    std::vector<std::vector<unsigned char>> encodedVertices(meshes.size()), encodedIndices(meshes.size());
+    for (size_t i = 0; compress && i < meshes.size(); i++)
+    {
+        encodedVertices[i] = encodeVertexBuffer(meshes[i].vertexData(), meshes[i].vertexCount(), vertexFormatStride(meshes[i].vertexFormat));
+        encodedIndices[i] = encodeIndexBuffer(meshes[i].indexData(), meshes[i].indexCount(), entries[i].indexSize);
+    }
+
+    // Lay out the blobs after the tables
+    uint64_t offset = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry) +
+        textures.size() * sizeof(MeshCacheString) + instances.size() * sizeof(MeshCacheInstance) + strings.size();
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        offset += (16 - (offset % 16)) % 16;
+        entries[i].vertexOffset = offset;
+        entries[i].vertexCount = meshes[i].vertexCount();
+        entries[i].vertexEncodedSize = encodedVertices[i].size();
+        offset += compress ? encodedVertices[i].size() : meshes[i].vertexCount() * vertexFormatStride(meshes[i].vertexFormat);
+
+        offset += (16 - (offset % 16)) % 16;
+        entries[i].indexOffset = offset;
+        entries[i].indexCount = meshes[i].indexCount();
+        entries[i].indexEncodedSize = encodedIndices[i].size();
+        offset += compress ? encodedIndices[i].size() : meshes[i].indexCount() * entries[i].indexSize;
+    }
+
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cout << "ERROR::MESH_CACHE:: Could not write " << tempPath << std::endl;
+        return false;
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MeshCacheEntry));
+    out.write(reinterpret_cast<const char*>(textures.data()), textures.size() * sizeof(MeshCacheString));
+    out.write(reinterpret_cast<const char*>(instances.data()), instances.size() * sizeof(MeshCacheInstance));
+    out.write(strings.data(), strings.size());
+
+    uint64_t written = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry) +
+        textures.size() * sizeof(MeshCacheString) + instances.size() * sizeof(MeshCacheInstance) + strings.size();
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const MeshData& mesh = meshes[i];
+        alignMeshCacheStream(out, written);
+        size_t vertexBytes = compress ? encodedVertices[i].size() : mesh.vertexCount() * vertexFormatStride(mesh.vertexFormat);
+        out.write(compress ? reinterpret_cast<const char*>(encodedVertices[i].data()) : static_cast<const char*>(mesh.vertexData()), vertexBytes);
+        written += vertexBytes;
+
+        alignMeshCacheStream(out, written);
+        size_t indexBytes = compress ? encodedIndices[i].size() : mesh.indexCount() * indexTypeSize(mesh.indexType);
+        out.write(compress ? reinterpret_cast<const char*>(encodedIndices[i].data()) : static_cast<const char*>(mesh.indexData()), indexBytes);
+        written += indexBytes;
+    }
+    out.close();
+    if (!out)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    // Replace any stale cache
+    if (!replaceFile(tempPath, cachePath))
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+#endif // MY_MESH_CACHE_H
@@ -0,0 +1,317 @@
+#ifndef MY_MESH_CODEC_H
+#define MY_MESH_CODEC_H
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Lossless compression of vertex and index buffers, used by compressed mesh caches (see Model::compressMeshCache)
+//
+// Vertices: blocks of up to VERTEX_CODEC_BLOCK vertices, each byte position of the vertex stored as its own plane
+// (byte-transposed). Every plane is filtered into zigzagged deltas against the previous vertex, then bit-packed in
+// groups of 16 at 0, 2, 4 or 8 bits with a 2-bit width code per group. Quantized vertices (16-bit positions, octahedral
+// normals) give small deltas once the optimizer has put neighbours next to each other, so most groups pack at 2-4 bits
+// Decoding is branch-light and vectorized: unpack, unzigzag and prefix-sum 16 bytes at a time, then transpose 4 planes
+// back into vertices per store (SSE2, with a scalar path for other targets)
+//
+// Indices: delta against the previous index, zigzagged and written as a LEB128 varint, vertex-cache-ordered
+// triangle lists mostly take one byte per index
+const unsigned char VERTEX_CODEC_HEADER = 0xA1;
+const unsigned char INDEX_CODEC_HEADER = 0xE1;
+const size_t VERTEX_CODEC_BLOCK = 256;      // Vertices per block, a multiple of VERTEX_CODEC_GROUP
+const size_t VERTEX_CODEC_GROUP = 16;
+const size_t VERTEX_CODEC_MAX_STRIDE = 256;
+
+// Map small signed byte deltas to small unsigned values: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+unsigned char zigzagByte(unsigned char delta)
+{
+    return static_cast<unsigned char>((delta << 1) ^ (static_cast<signed char>(delta) >> 7));
+}
+
+unsigned char unzigzagByte(unsigned char value)
+{
+    return static_cast<unsigned char>((value >> 1) ^ (0 - (value & 1)));
+}
+
+// Width code of a group: 0, 2, 4 or 8 bits per value
+int vertexGroupBitsCode(const unsigned char* values)
+{
+    unsigned char largest = *std::max_element(values, values + VERTEX_CODEC_GROUP);
+    return largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+}
+
+// Payload bytes of a group with the given width code
+size_t vertexGroupBytes(int bitsCode)
+{
+    static const size_t sizes[4] = { 0, 4, 8, 16 };
+    return sizes[bitsCode];
+}
+
+// Encode count vertices of stride bytes (at most VERTEX_CODEC_MAX_STRIDE)
+std::vector<unsigned char> encodeVertexBuffer(const void* vertices, size_t count, size_t stride)
+{
+    std::vector<unsigned char> out;
+    out.push_back(VERTEX_CODEC_HEADER);
+    const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+    std::vector<unsigned char> last(stride, 0);
+    unsigned char deltas[VERTEX_CODEC_BLOCK];
+
+    for (size_t first = 0; first < count; first += VERTEX_CODEC_BLOCK)
+    {
+        size_t blockCount = std::min(VERTEX_CODEC_BLOCK, count - first);
+        size_t groupCount = (blockCount + VERTEX_CODEC_GROUP - 1) / VERTEX_CODEC_GROUP;
+        for (size_t k = 0; k < stride; k++)
+        {
+            unsigned char previous = last[k];
+            for (size_t v = 0; v < blockCount; v++)
+            {
+                unsigned char value = bytes[(first + v) * stride + k];
+                deltas[v] = zigzagByte(static_cast<unsigned char>(value - previous));
+                previous = value;
+            }
+            std::fill(deltas + blockCount, deltas + groupCount * VERTEX_CODEC_GROUP, 0);
+            last[k] = previous;
+
+            // Width codes of the plane's groups first, four to a byte, then their payloads
+            size_t header = out.size();
+            out.resize(out.size() + (groupCount + 3) / 4, 0);
+            for (size_t g = 0; g < groupCount; g++)
+            {
+                const unsigned char* values = deltas + g * VERTEX_CODEC_GROUP;
+                int bitsCode = vertexGroupBitsCode(values);
+                out[header + g / 4] |= static_cast<unsigned char>(bitsCode << ((g % 4) * 2));
+                if (bitsCode == 1)
+                {
+                    for (size_t j = 0; j < 4; j++)
+                        out.push_back(static_cast<unsigned char>(values[4 * j] << 6 | values[4 * j + 1] << 4 | values[4 * j + 2] << 2 | values[4 * j + 3]));
+                }
+                else if (bitsCode == 2)
+                {
+                    for (size_t j = 0; j < 8; j++)
+                        out.push_back(static_cast<unsigned char>(values[2 * j] << 4 | values[2 * j + 1]));
+                }
+                else if (bitsCode == 3)
+                    out.insert(out.end(), values, values + VERTEX_CODEC_GROUP);
+            }
+        }
+    }
+    return out;
+}
+
+// Expand one group into 16 plane bytes continuing from last
+void decodeVertexGroupScalar(const unsigned char* data, int bitsCode, unsigned char& last, unsigned char* out)
+{
+    for (size_t i = 0; i < VERTEX_CODEC_GROUP; i++)
+    {
+        unsigned char value = 0;
+        if (bitsCode == 1)
+            value = (data[i / 4] >> (6 - 2 * (i % 4))) & 3;
+        else if (bitsCode == 2)
+            value = (data[i / 2] >> (4 - 4 * (i % 2))) & 15;
+        else if (bitsCode == 3)
+            value = data[i];
+        last = static_cast<unsigned char>(last + unzigzagByte(value));
+        out[i] = last;
+    }
+}
+
+#ifdef MESH_CODEC_SSE2
+void decodeVertexGroupSse(const unsigned char* data, int bitsCode, unsigned char& last, unsigned char* out)
+{
+    __m128i values;
+    if (bitsCode == 0)
+        values = _mm_setzero_si128();
+    else if (bitsCode == 1)
+    {
+        int32_t packed;
+        memcpy(&packed, data, sizeof(packed));
+        __m128i x = _mm_cvtsi32_si128(packed);
+        __m128i mask = _mm_set1_epi8(3);
+        __m128i a = _mm_and_si128(_mm_srli_epi16(x, 6), mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+        __m128i c = _mm_and_si128(_mm_srli_epi16(x, 2), mask);
+        __m128i d = _mm_and_si128(x, mask);
+        values = _mm_unpacklo_epi16(_mm_unpacklo_epi8(a, b), _mm_unpacklo_epi8(c, d));
+    }
+    else if (bitsCode == 2)
+    {
+        __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+        __m128i mask = _mm_set1_epi8(15);
+        values = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), mask), _mm_and_si128(x, mask));
+    }
+    else
+        values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+    // Unzigzag, then a running sum over the 16 deltas in four shifted adds
+    __m128i one = _mm_set1_epi8(1);
+    values = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(values, 1), _mm_set1_epi8(0x7F)), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(values, one)));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 1));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 2));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 4));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 8));
+    values = _mm_add_epi8(values, _mm_set1_epi8(static_cast<char>(last)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), values);
+    last = out[VERTEX_CODEC_GROUP - 1];
+}
+
+// Interleave four planes back into 16 vertices, 4 bytes each at dest (+ stride per vertex)
+void transposeVertexPlanesSse(const unsigned char* planes, size_t planeStride, unsigned char* dest, size_t stride, size_t vertexCount)
+{
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + planeStride));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + 2 * planeStride));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + 3 * planeStride));
+    __m128i ab0 = _mm_unpacklo_epi8(a, b), ab1 = _mm_unpackhi_epi8(a, b);
+    __m128i cd0 = _mm_unpacklo_epi8(c, d), cd1 = _mm_unpackhi_epi8(c, d);
+
+    alignas(16) unsigned char quads[64];
+    _mm_store_si128(reinterpret_cast<__m128i*>(quads), _mm_unpacklo_epi16(ab0, cd0));
+    _mm_store_si128(reinterpret_cast<__m128i*>(quads + 16), _mm_unpackhi_epi16(ab0, cd0));
+    _mm_store_si128(reinterpret_cast<__m128i*>(quads + 32), _mm_unpacklo_epi16(ab1, cd1));
+    _mm_store_si128(reinterpret_cast<__m128i*>(quads + 48), _mm_unpackhi_epi16(ab1, cd1));
+    for (size_t v = 0; v < vertexCount; v++)
+        memcpy(dest + v * stride, quads + v * 4, 4);
+}
+#endif
+
+// Decode into count vertices of stride bytes, false if the data is malformed or doesn't match count
+// useSimd picks the vectorized path where the target has one
+bool decodeVertexBuffer(void* vertices, size_t count, size_t stride, const unsigned char* data, size_t size, bool useSimd = true)
+{
+    if (size < 1 || data[0] != VERTEX_CODEC_HEADER || stride == 0 || stride > VERTEX_CODEC_MAX_STRIDE)
+        return false;
+#ifdef MESH_CODEC_SSE2
+    bool simd = useSimd;
+#else
+    bool simd = false;
+    (void)useSimd;
+#endif
+    const unsigned char* p = data + 1;
+    const unsigned char* end = data + size;
+    unsigned char* dest = static_cast<unsigned char*>(vertices);
+    std::vector<unsigned char> last(stride, 0);
+    std::vector<unsigned char> planes(stride * VERTEX_CODEC_BLOCK);
+
+    for (size_t first = 0; first < count; first += VERTEX_CODEC_BLOCK)
+    {
+        size_t blockCount = std::min(VERTEX_CODEC_BLOCK, count - first);
+        size_t groupCount = (blockCount + VERTEX_CODEC_GROUP - 1) / VERTEX_CODEC_GROUP;
+        for (size_t k = 0; k < stride; k++)
+        {
+            const unsigned char* header = p;
+            p += (groupCount + 3) / 4;
+            if (p > end)
+                return false;
+            unsigned char* plane = planes.data() + k * VERTEX_CODEC_BLOCK;
+            for (size_t g = 0; g < groupCount; g++)
+            {
+                int bitsCode = (header[g / 4] >> ((g % 4) * 2)) & 3;
+                size_t payload = vertexGroupBytes(bitsCode);
+                if (payload > static_cast<size_t>(end - p))
+                    return false;
+#ifdef MESH_CODEC_SSE2
+                // The 2-bit path reads exactly 4 bytes and the 4-bit path 8, so nothing past the payload
+                if (simd)
+                    decodeVertexGroupSse(p, bitsCode, last[k], plane + g * VERTEX_CODEC_GROUP);
+                else
+#endif
+                    decodeVertexGroupScalar(p, bitsCode, last[k], plane + g * VERTEX_CODEC_GROUP);
+                p += payload;
+            }
+        }
+
+        // Back from planes to vertices
+        unsigned char* blockDest = dest + first * stride;
+        size_t k = 0;
+#ifdef MESH_CODEC_SSE2
+        if (simd)
+        {
+            for (; k + 4 <= stride; k += 4)
+            {
+                for (size_t v = 0; v < blockCount; v += VERTEX_CODEC_GROUP)
+                    transposeVertexPlanesSse(planes.data() + k * VERTEX_CODEC_BLOCK + v, VERTEX_CODEC_BLOCK, blockDest + v * stride + k, stride,
+                        std::min(VERTEX_CODEC_GROUP, blockCount - v));
+            }
+        }
+#endif
+        for (; k < stride; k++)
+        {
+            const unsigned char* plane = planes.data() + k * VERTEX_CODEC_BLOCK;
+            for (size_t v = 0; v < blockCount; v++)
+                blockDest[v * stride + k] = plane[v];
+        }
+    }
+    return p == end;
+}
+
+// Encode count indices of indexSize bytes (2 or 4)
+std::vector<unsigned char> encodeIndexBuffer(const void* indices, size_t count, size_t indexSize)
+{
+    std::vector<unsigned char> out;
+    out.reserve(count + 1);
+    out.push_back(INDEX_CODEC_HEADER);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t index;
+        if (indexSize == sizeof(uint16_t))
+            index = static_cast<const uint16_t*>(indices)[i];
+        else
+            index = static_cast<const uint32_t*>(indices)[i];
+        uint32_t delta = index - previous;
+        uint32_t value = (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+        previous = index;
+
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+    return out;
+}
+
+// Decode count indices of indexSize bytes, false if the data is malformed or doesn't match count
+bool decodeIndexBuffer(void* indices, size_t count, size_t indexSize, const unsigned char* data, size_t size)
+{
+    if (size < 1 || data[0] != INDEX_CODEC_HEADER || (indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t)))
+        return false;
+    const unsigned char* p = data + 1;
+    const unsigned char* end = data + size;
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        // One byte covers deltas of -64..63, take that path without the loop
+        uint32_t value;
+        if (p < end && *p < 0x80)
+            value = *p++;
+        else
+        {
+            value = 0;
+            for (int shift = 0; ; shift += 7)
+            {
+                if (p == end || shift > 28)
+                    return false;
+                unsigned char byte = *p++;
+                value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if (byte < 0x80)
+                    break;
+            }
+        }
+        previous += (value >> 1) ^ (0 - (value & 1));
+        if (indexSize == sizeof(uint16_t))
+            static_cast<uint16_t*>(indices)[i] = static_cast<uint16_t>(previous);
+        else
+            static_cast<uint32_t*>(indices)[i] = previous;
+    }
+    return p == end;
+}
+#endif // MY_MESH_CODEC_H
@@ -0,0 +1,452 @@
+#ifndef MY_MESH_INSTANCING_H
+#define MY_MESH_INSTANCING_H
+
+#include <my_mesh.h>
+#include <my_mesh_cache.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Finds imported meshes that are copies of another one up to a rotation, translation or mirror
+// (e.g. wheel1/wheel2) so they can share its buffers and be drawn as instances of it
+//
+// Meshes are bucketed by a hash of what such a transform can't change (triangle and position counts, textures, the
+// quantized distances of the positions from their centroid), compared by a canonical signature (sorted distances of
+// the distinct positions from their centroid), and only then matched:
+// two anchor positions are paired by their distances, the transform is solved from them and every position,
+// the surface and the corner normals are checked against it
+//
+// Copies exported separately rarely agree on more than that: quads get split along the other diagonal, UV seams
+// land elsewhere and smoothing drifts by a few degrees, so triangles are compared as surfaces and normals loosely
+// Texcoords are compared too, copies laid out on their own part of a texture only fold when the caller allows it
+
+// Matching tolerances: positions as a fraction of the mesh radius, normals as 1 - cosine (about 10 degrees), texcoords in UV units
+const float INSTANCE_POSITION_TOLERANCE = 1e-4f;
+const float INSTANCE_NORMAL_TOLERANCE = 0.015f;
+const float INSTANCE_TEXCOORD_TOLERANCE = 1e-4f;
+
+// Anchor pairings tried per mesh pair before giving up (symmetric parts have many equivalent ones)
+const int INSTANCE_MAX_ANCHOR_TRIES = 256;
+
+// One entry per distinct position: copies often split vertices along different UV seams, so congruence is
+// decided on positions and triangles, with the per-corner attributes compared afterwards
+struct WeldedMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> vertexPosition;   // Per vertex, into positions
+    glm::vec3 centroid = glm::vec3(0.0f);
+    std::vector<float> distances;               // Per position, from the centroid
+    std::vector<float> sortedDistances;         // Canonical signature
+};
+
+WeldedMesh weldMeshPositions(const std::vector<Vertex>& vertices)
+{
+    WeldedMesh welded;
+    std::vector<unsigned int> order(vertices.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = static_cast<unsigned int>(i);
+    auto less = [&](unsigned int a, unsigned int b)
+    {
+        const glm::vec3& p = vertices[a].Position;
+        const glm::vec3& q = vertices[b].Position;
+        return p.x != q.x ? p.x < q.x : (p.y != q.y ? p.y < q.y : p.z < q.z);
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    welded.vertexPosition.resize(vertices.size());
+    glm::dvec3 sum(0.0);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (i == 0 || less(order[i - 1], order[i]))
+        {
+            welded.positions.push_back(vertices[order[i]].Position);
+            sum += glm::dvec3(vertices[order[i]].Position);
+        }
+        welded.vertexPosition[order[i]] = static_cast<unsigned int>(welded.positions.size() - 1);
+    }
+    if (welded.positions.empty())
+        return welded;
+
+    welded.centroid = glm::vec3(sum / static_cast<double>(welded.positions.size()));
+    welded.distances.resize(welded.positions.size());
+    for (size_t i = 0; i < welded.positions.size(); i++)
+        welded.distances[i] = glm::length(welded.positions[i] - welded.centroid);
+    welded.sortedDistances = welded.distances;
+    std::sort(welded.sortedDistances.begin(), welded.sortedDistances.end());
+    return welded;
+}
+
+// Bins of the canonical signature's radius and mean distance, on a log scale so a bin spans the same fraction of
+// any mesh size (about 0.3%, well over INSTANCE_POSITION_TOLERANCE). A copy can still land in the next bin, so
+// lookups probe the neighbouring ones too
+const float INSTANCE_BINS_PER_OCTAVE = 256.0f;
+
+std::array<int, 2> meshShapeBins(const WeldedMesh& welded)
+{
+    if (welded.sortedDistances.empty())
+        return { 0, 0 };
+    double sum = 0.0;
+    for (float distance : welded.sortedDistances)
+        sum += distance;
+    float radius = std::max(welded.sortedDistances.back(), 1e-12f);
+    float mean = std::max(static_cast<float>(sum / welded.sortedDistances.size()), 1e-12f);
+    return { static_cast<int>(std::floor(std::log2(radius) * INSTANCE_BINS_PER_OCTAVE)),
+        static_cast<int>(std::floor(std::log2(mean) * INSTANCE_BINS_PER_OCTAVE)) };
+}
+
+// Bucket key: triangle and distinct position counts, textures and the quantized centroid distances of the positions,
+// none of which a rigid or mirror transform changes
+uint64_t meshShapeHash(const MeshData& mesh, const WeldedMesh& welded, int radiusBin, int meanBin)
+{
+    uint64_t counts[2] = { mesh.indices.size(), welded.positions.size() };
+    int64_t quantized[2] = { radiusBin, meanBin };
+    uint64_t hash = hashBytes(reinterpret_cast<const unsigned char*>(counts), sizeof(counts));
+    hash = hashBytes(reinterpret_cast<const unsigned char*>(quantized), sizeof(quantized), hash);
+    for (const std::string& texturePath : mesh.texturePaths)
+        hash = hashBytes(reinterpret_cast<const unsigned char*>(texturePath.data()), texturePath.size(), hash);
+    return hash;
+}
+
+// Point lookup within a tolerance, on a grid of tolerance-sized cells
+class PositionGrid
+{
+public:
+    PositionGrid(const std::vector<glm::vec3>& positions, float tolerance)
+        : cellSize(tolerance * 2.0f)
+    {
+        for (size_t i = 0; i < positions.size(); i++)
+            cells[cellKey(cellOf(positions[i]))].push_back(static_cast<unsigned int>(i));
+    }
+
+    // Calls visit(index) for every position that may lie within the tolerance of p, until it returns true
+    template <typename Visitor>
+    bool find(const glm::vec3& p, Visitor visit) const
+    {
+        glm::ivec3 cell = cellOf(p);
+        for (int x = -1; x <= 1; x++)
+        {
+            for (int y = -1; y <= 1; y++)
+            {
+                for (int z = -1; z <= 1; z++)
+                {
+                    auto found = cells.find(cellKey(cell + glm::ivec3(x, y, z)));
+                    if (found == cells.end())
+                        continue;
+                    for (unsigned int index : found->second)
+                    {
+                        if (visit(index))
+                            return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    float cellSize;
+    std::unordered_map<uint64_t, std::vector<unsigned int>> cells;
+
+    glm::ivec3 cellOf(const glm::vec3& p) const
+    {
+        return glm::ivec3(static_cast<int>(std::floor(p.x / cellSize)), static_cast<int>(std::floor(p.y / cellSize)), static_cast<int>(std::floor(p.z / cellSize)));
+    }
+
+    static uint64_t cellKey(const glm::ivec3& cell)
+    {
+        return (static_cast<uint64_t>(cell.x & 0x1FFFFF) << 42) | (static_cast<uint64_t>(cell.y & 0x1FFFFF) << 21) | static_cast<uint64_t>(cell.z & 0x1FFFFF);
+    }
+};
+
+// Whether p lies on triangle (a, b, c), edges and corners included
+bool pointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float tolerance)
+{
+    glm::vec3 normal = glm::cross(b - a, c - a);
+    float area = glm::length(normal);
+    if (area == 0.0f || std::fabs(glm::dot(p - a, normal)) > tolerance * area)
+        return false;
+    float edgeTolerance = -1e-4f * area;
+    return glm::dot(glm::cross(b - a, p - a), normal) >= edgeTolerance * area &&
+        glm::dot(glm::cross(c - b, p - b), normal) >= edgeTolerance * area &&
+        glm::dot(glm::cross(a - c, p - c), normal) >= edgeTolerance * area;
+}
+
+// Whether the centre of every triangle in from lies on a triangle of onto sharing one of its positions and facing the same way
+// Two triangulations of the same surface cover each other both ways even where quads were split along different diagonals
+bool trianglesCovered(const std::vector<std::array<unsigned int, 3>>& from, const std::vector<std::array<unsigned int, 3>>& onto,
+    const std::vector<glm::vec3>& positions, float tolerance)
+{
+    std::vector<std::vector<unsigned int>> incident(positions.size());
+    for (size_t t = 0; t < onto.size(); t++)
+    {
+        for (unsigned int id : onto[t])
+            incident[id].push_back(static_cast<unsigned int>(t));
+    }
+
+    for (const std::array<unsigned int, 3>& triangle : from)
+    {
+        const glm::vec3& p0 = positions[triangle[0]];
+        const glm::vec3& p1 = positions[triangle[1]];
+        const glm::vec3& p2 = positions[triangle[2]];
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        if (glm::length(normal) == 0.0f)
+            continue;   // Degenerate, covers nothing
+        glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+
+        bool covered = false;
+        for (int c = 0; c < 3 && !covered; c++)
+        {
+            for (unsigned int t : incident[triangle[c]])
+            {
+                const glm::vec3& q0 = positions[onto[t][0]];
+                const glm::vec3& q1 = positions[onto[t][1]];
+                const glm::vec3& q2 = positions[onto[t][2]];
+                if (glm::dot(normal, glm::cross(q1 - q0, q2 - q0)) > 0.0f && pointOnTriangle(center, q0, q1, q2, tolerance))
+                {
+                    covered = true;
+                    break;
+                }
+            }
+        }
+        if (!covered)
+            return false;
+    }
+    return true;
+}
+
+// Whether linear (applied around the centroids) maps a's positions, surface and corner normals onto b's
+// sameTexCoords is cleared if b has texcoords a doesn't
+bool verifyMeshCongruence(const MeshData& a, const MeshData& b, const WeldedMesh& weldedA, const WeldedMesh& weldedB,
+    const PositionGrid& gridB, const glm::mat3& linear, float tolerance, bool mirrored, bool& sameTexCoords)
+{
+    // Positions, one to one
+    std::vector<unsigned int> mapping(weldedA.positions.size());
+    std::vector<bool> used(weldedB.positions.size(), false);
+    for (size_t i = 0; i < weldedA.positions.size(); i++)
+    {
+        glm::vec3 position = linear * (weldedA.positions[i] - weldedA.centroid) + weldedB.centroid;
+        bool matched = gridB.find(position, [&](unsigned int j)
+        {
+            if (used[j] || glm::length(weldedB.positions[j] - position) > tolerance)
+                return false;
+            used[j] = true;
+            mapping[i] = j;
+            return true;
+        });
+        if (!matched)
+            return false;
+    }
+
+    // Surface, with a's triangles in b's positions (wound the other way round when mirrored)
+    std::vector<std::array<unsigned int, 3>> trianglesA, trianglesB;
+    for (size_t t = 0; t + 2 < a.indices.size(); t += 3)
+    {
+        unsigned int i0 = mapping[weldedA.vertexPosition[a.indices[t]]];
+        unsigned int i1 = mapping[weldedA.vertexPosition[a.indices[t + 1]]];
+        unsigned int i2 = mapping[weldedA.vertexPosition[a.indices[t + 2]]];
+        trianglesA.push_back(mirrored ? std::array<unsigned int, 3>{ i0, i2, i1 } : std::array<unsigned int, 3>{ i0, i1, i2 });
+    }
+    for (size_t t = 0; t + 2 < b.indices.size(); t += 3)
+        trianglesB.push_back({ weldedB.vertexPosition[b.indices[t]], weldedB.vertexPosition[b.indices[t + 1]], weldedB.vertexPosition[b.indices[t + 2]] });
+    if (!trianglesCovered(trianglesA, trianglesB, weldedB.positions, tolerance) || !trianglesCovered(trianglesB, trianglesA, weldedB.positions, tolerance))
+        return false;
+
+    // Corner attributes: every vertex of b has one of a at the same position with the same normal, and the same texcoords if possible
+    std::vector<std::vector<unsigned int>> verticesA(weldedB.positions.size());
+    for (size_t i = 0; i < a.vertices.size(); i++)
+        verticesA[mapping[weldedA.vertexPosition[i]]].push_back(static_cast<unsigned int>(i));
+    sameTexCoords = true;
+    for (size_t j = 0; j < b.vertices.size(); j++)
+    {
+        const Vertex& vertexB = b.vertices[j];
+        bool normalMatched = false;
+        bool texCoordsMatched = false;
+        for (unsigned int i : verticesA[weldedB.vertexPosition[j]])
+        {
+            glm::vec3 normal = linear * a.vertices[i].Normal;
+            float lengths = glm::length(normal) * glm::length(vertexB.Normal);
+            if (lengths > 0.0f ? glm::dot(normal, vertexB.Normal) < (1.0f - INSTANCE_NORMAL_TOLERANCE) * lengths : glm::length(normal) != glm::length(vertexB.Normal))
+                continue;
+            normalMatched = true;
+            if (glm::length(vertexB.TexCoords - a.vertices[i].TexCoords) <= INSTANCE_TEXCOORD_TOLERANCE)
+            {
+                texCoordsMatched = true;
+                break;
+            }
+        }
+        if (!normalMatched)
+            return false;
+        sameTexCoords = sameTexCoords && texCoordsMatched;
+    }
+    return true;
+}
+
+// Find a rotation/reflection plus translation taking mesh a exactly onto mesh b
+// transform maps a's vertices onto b's, mirrored says whether it flips handedness (and so winding),
+// sameTexCoords whether b's texcoords are a's too (when they aren't, b drawn with a's buffers is textured like a)
+// weldedA and weldedB are weldMeshPositions of the meshes' vertices
+bool findMeshCongruence(const MeshData& a, const MeshData& b, const WeldedMesh& weldedA, const WeldedMesh& weldedB,
+    glm::mat4& transform, bool& mirrored, bool& sameTexCoords)
+{
+    if (a.vertices.size() < 3 || a.indices.size() != b.indices.size() || a.texturePaths != b.texturePaths)
+        return false;
+
+    // Canonical signature: same distinct positions at the same distances from the centroid
+    size_t positionCount = weldedA.positions.size();
+    if (positionCount < 3 || positionCount != weldedB.positions.size())
+        return false;
+    float radius = weldedA.sortedDistances.back();
+    float tolerance = std::max(radius * INSTANCE_POSITION_TOLERANCE, 1e-6f);
+    for (size_t i = 0; i < positionCount; i++)
+    {
+        if (std::fabs(weldedA.sortedDistances[i] - weldedB.sortedDistances[i]) > tolerance)
+            return false;
+    }
+
+    // First anchor: the position away from the centroid whose distance the fewest others share
+    const std::vector<float>& sortedA = weldedA.sortedDistances;
+    size_t anchor1 = 0;
+    size_t fewest = SIZE_MAX;
+    for (size_t i = 0; i < positionCount; i++)
+    {
+        float distance = weldedA.distances[i];
+        if (distance < radius * 0.25f)
+            continue;
+        size_t sharing = std::upper_bound(sortedA.begin(), sortedA.end(), distance + tolerance) - std::lower_bound(sortedA.begin(), sortedA.end(), distance - tolerance);
+        if (sharing < fewest || (sharing == fewest && distance > weldedA.distances[anchor1]))
+        {
+            fewest = sharing;
+            anchor1 = i;
+        }
+    }
+
+    // Second anchor: furthest off the centroid-anchor1 line
+    glm::vec3 u1 = weldedA.positions[anchor1] - weldedA.centroid;
+    size_t anchor2 = 0;
+    float widest = 0.0f;
+    for (size_t i = 0; i < positionCount; i++)
+    {
+        float width = glm::length(glm::cross(u1, weldedA.positions[i] - weldedA.centroid));
+        if (width > widest)
+        {
+            widest = width;
+            anchor2 = i;
+        }
+    }
+    if (widest <= tolerance * glm::length(u1))
+        return false;   // Every position on one line, no frame to solve for
+    glm::vec3 u2 = weldedA.positions[anchor2] - weldedA.centroid;
+    glm::mat3 frameA(u1, u2, glm::normalize(glm::cross(u1, u2)));
+    glm::mat3 inverseFrameA = glm::inverse(frameA);
+    float anchorSpan = glm::length(u2 - u1);
+
+    // Pair the anchors with b's positions at the same distances, solve and verify
+    PositionGrid gridB(weldedB.positions, tolerance);
+    int tries = 0;
+    for (size_t j1 = 0; j1 < positionCount; j1++)
+    {
+        if (std::fabs(weldedB.distances[j1] - weldedA.distances[anchor1]) > tolerance)
+            continue;
+        glm::vec3 v1 = weldedB.positions[j1] - weldedB.centroid;
+        for (size_t j2 = 0; j2 < positionCount; j2++)
+        {
+            if (std::fabs(weldedB.distances[j2] - weldedA.distances[anchor2]) > tolerance ||
+                std::fabs(glm::length(weldedB.positions[j2] - weldedB.positions[j1]) - anchorSpan) > tolerance)
+                continue;
+            glm::vec3 v2 = weldedB.positions[j2] - weldedB.centroid;
+            glm::vec3 normalB = glm::cross(v1, v2);
+            if (glm::length(normalB) == 0.0f)
+                continue;
+            normalB = glm::normalize(normalB);
+
+            // The anchors fix two axes, the third is either way round: rotation or mirror
+            for (float handedness : { 1.0f, -1.0f })
+            {
+                glm::mat3 linear = glm::mat3(v1, v2, normalB * handedness) * inverseFrameA;
+                glm::mat3 orthogonality = glm::transpose(linear) * linear;
+                bool orthonormal = true;
+                for (int c = 0; c < 3; c++)
+                {
+                    for (int r = 0; r < 3; r++)
+                        orthonormal = orthonormal && std::fabs(orthogonality[c][r] - (c == r ? 1.0f : 0.0f)) < 1e-3f;
+                }
+
+                if (orthonormal && verifyMeshCongruence(a, b, weldedA, weldedB, gridB, linear, tolerance, handedness < 0.0f, sameTexCoords))
+                {
+                    mirrored = handedness < 0.0f;
+                    transform = glm::translate(glm::mat4(1.0f), weldedB.centroid) * glm::mat4(linear) * glm::translate(glm::mat4(1.0f), -weldedA.centroid);
+                    return true;
+                }
+                if (++tries >= INSTANCE_MAX_ANCHOR_TRIES)
+                    return false;
+            }
+        }
+    }
+    return false;
+}
+
+bool findMeshCongruence(const MeshData& a, const MeshData& b, glm::mat4& transform, bool& mirrored, bool& sameTexCoords)
+{
+    return findMeshCongruence(a, b, weldMeshPositions(a.vertices), weldMeshPositions(b.vertices), transform, mirrored, sameTexCoords);
+}
+
+// Fold every mesh that copies an earlier one into that mesh's instance list, removing it from meshes
+// Without requireSameTexCoords, copies whose UVs were laid out separately fold too and take the source's texturing
+// Returns the vertex/index bytes no longer uploaded
+size_t shareDuplicateMeshes(std::vector<MeshData>& meshes, bool requireSameTexCoords = true)
+{
+    std::map<uint64_t, std::vector<size_t>> buckets;
+    std::vector<WeldedMesh> welded(meshes.size());
+    std::vector<bool> folded(meshes.size(), false);
+    size_t savedBytes = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        welded[i] = weldMeshPositions(meshes[i].vertices);
+        std::array<int, 2> bins = meshShapeBins(welded[i]);
+        for (int x = -1; x <= 1 && !folded[i]; x++)
+        {
+            for (int y = -1; y <= 1 && !folded[i]; y++)
+            {
+                auto bucket = buckets.find(meshShapeHash(meshes[i], welded[i], bins[0] + x, bins[1] + y));
+                if (bucket == buckets.end())
+                    continue;
+                for (size_t source : bucket->second)
+                {
+                    glm::mat4 transform;
+                    bool mirrored, sameTexCoords;
+                    if (findMeshCongruence(meshes[source], meshes[i], welded[source], welded[i], transform, mirrored, sameTexCoords) &&
+                        (sameTexCoords || !requireSameTexCoords))
+                    {
+                        meshes[source].instances.push_back({ meshes[i].meshName, transform, mirrored });
+                        folded[i] = true;
+                        savedBytes += meshes[i].vertices.size() * sizeof(Vertex) + meshes[i].indices.size() * sizeof(unsigned int);
+                        break;
+                    }
+                }
+            }
+        }
+        if (!folded[i])
+            buckets[meshShapeHash(meshes[i], welded[i], bins[0], bins[1])].push_back(i);
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (folded[i])
+            continue;
+        if (kept != i)
+            meshes[kept] = std::move(meshes[i]);
+        kept++;
+    }
+    meshes.resize(kept);
+    return savedBytes;
+}
+#endif // MY_MESH_INSTANCING_H
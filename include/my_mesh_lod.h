@@ -0,0 +1,302 @@
+#ifndef MY_MESH_LOD_H
+#define MY_MESH_LOD_H
+
+#include <my_mesh.h>
+#include <my_mesh_optimizer.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Level of detail: a quadric error metric simplifier run at import time (selection lives in Mesh::selectLod)
+// Every level indexes the mesh's one vertex buffer, so LODs only cost extra indices
+
+// Triangle count of each level relative to the previous one, and how much a level has to shrink to be kept
+const float LOD_REDUCTION = 0.5f;
+const float LOD_MINIMUM_GAIN = 0.9f;
+
+// Symmetric 4x4 plane quadric (Garland & Heckbert), upper triangle only
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    void addPlane(const glm::vec3& normal, float distance)
+    {
+        double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+        b2 += b * b; bc += b * c; bd += b * d;
+        c2 += c * c; cd += c * d;
+        d2 += d * d;
+    }
+
+    void add(const Quadric& o)
+    {
+        a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+        b2 += o.b2; bc += o.bc; bd += o.bd;
+        c2 += o.c2; cd += o.cd;
+        d2 += o.d2;
+    }
+
+    // Sum of squared distances from p to every plane in the quadric
+    double evaluate(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+            b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+            c2 * z * z + 2 * cd * z + d2;
+    }
+};
+
+// Bounding sphere of a mesh (centre of the bounding box, radius to the furthest vertex)
+void computeMeshBounds(const std::vector<Vertex>& vertices, glm::vec3& center, float& radius)
+{
+    center = glm::vec3(0.0f);
+    radius = 0.0f;
+    if (vertices.empty())
+        return;
+
+    glm::vec3 minimum = vertices[0].Position, maximum = vertices[0].Position;
+    for (const Vertex& vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.Position);
+        maximum = glm::max(maximum, vertex.Position);
+    }
+    center = (minimum + maximum) * 0.5f;
+    for (const Vertex& vertex : vertices)
+        radius = std::max(radius, glm::length(vertex.Position - center));
+}
+
+// Collapse edges onto one of their endpoints until the mesh is down to targetIndexCount indices or nothing
+// can collapse without flipping a triangle. Surviving vertices keep their attributes, so the result indexes
+// the same vertex buffer. Vertices on open borders or attribute seams (several vertices at one position)
+// never move. Returns the new triangle list, error is the largest collapse cost as a distance (model units)
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount, float& error)
+{
+    error = 0.0f;
+    size_t vertexCount = vertices.size();
+    size_t triangleCount = indices.size() / 3;
+
+    // Vertices sharing a position form one surface point
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3& p) const
+        {
+            uint32_t bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+    struct PositionEqual
+    {
+        bool operator()(const glm::vec3& a, const glm::vec3& b) const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+    std::unordered_map<glm::vec3, unsigned int, PositionHash, PositionEqual> positionIds;
+    std::vector<unsigned int> positionId(vertexCount);
+    std::vector<unsigned int> positionUses;
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        auto inserted = positionIds.emplace(vertices[v].Position, static_cast<unsigned int>(positionUses.size()));
+        if (inserted.second)
+            positionUses.push_back(0);
+        positionId[v] = inserted.first->second;
+        positionUses[positionId[v]]++;
+    }
+
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t v = 0; v < vertexCount; v++)
+        locked[v] = positionUses[positionId[v]] > 1;
+
+    // Open border edges (by position, so seams don't count) lock both ends
+    std::unordered_map<uint64_t, int> edgeUses;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t a = positionId[indices[t * 3 + k]], b = positionId[indices[t * 3 + (k + 1) % 3]];
+            edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+            uint64_t pa = positionId[a], pb = positionId[b];
+            if (edgeUses[std::min(pa, pb) << 32 | std::max(pa, pb)] == 1)
+                locked[a] = locked[b] = true;
+        }
+    }
+
+    // Plane quadrics, accumulated per position so seam vertices agree
+    std::vector<Quadric> positionQuadrics(positionUses.size());
+    std::vector<unsigned int> triangles(indices);
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const glm::vec3& p0 = vertices[triangles[t * 3]].Position;
+        glm::vec3 normal = glm::cross(vertices[triangles[t * 3 + 1]].Position - p0, vertices[triangles[t * 3 + 2]].Position - p0);
+        float length = glm::length(normal);
+        if (length > 0.0f)
+        {
+            normal /= length;
+            for (int k = 0; k < 3; k++)
+                positionQuadrics[positionId[triangles[t * 3 + k]]].addPlane(normal, -glm::dot(normal, p0));
+        }
+        for (int k = 0; k < 3; k++)
+            vertexTriangles[triangles[t * 3 + k]].push_back(static_cast<unsigned int>(t));
+    }
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        quadrics[v] = positionQuadrics[positionId[v]];
+
+    // Candidate collapses, invalidated lazily through per-vertex versions
+    struct Collapse
+    {
+        double cost;
+        unsigned int from, to;
+        unsigned int fromVersion, toVersion;
+        bool operator<(const Collapse& o) const { return cost > o.cost; }
+    };
+    std::priority_queue<Collapse> queue;
+    std::vector<unsigned int> version(vertexCount, 0);
+    std::vector<bool> collapsed(vertexCount, false);
+    std::vector<bool> triangleAlive(triangleCount, true);
+    size_t aliveIndices = indices.size();
+
+    auto pushCollapse = [&](unsigned int from, unsigned int to)
+    {
+        if (locked[from] || from == to)
+            return;
+        Quadric combined = quadrics[from];
+        combined.add(quadrics[to]);
+        queue.push({ std::max(0.0, combined.evaluate(vertices[to].Position)), from, to, version[from], version[to] });
+    };
+    auto pushVertexEdges = [&](unsigned int vertex)
+    {
+        for (unsigned int t : vertexTriangles[vertex])
+        {
+            if (!triangleAlive[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int other = triangles[t * 3 + k];
+                pushCollapse(vertex, other);
+                pushCollapse(other, vertex);
+            }
+        }
+    };
+    for (size_t v = 0; v < vertexCount; v++)
+        pushVertexEdges(static_cast<unsigned int>(v));
+
+    while (aliveIndices > targetIndexCount && !queue.empty())
+    {
+        Collapse collapse = queue.top();
+        queue.pop();
+        unsigned int from = collapse.from, to = collapse.to;
+        if (collapsed[from] || collapsed[to] || collapse.fromVersion != version[from] || collapse.toVersion != version[to])
+            continue;
+
+        // Reject collapses that flip or degenerate a triangle that survives them
+        bool valid = true;
+        for (unsigned int t : vertexTriangles[from])
+        {
+            if (!triangleAlive[t])
+                continue;
+            unsigned int* corners = &triangles[t * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+                continue;
+
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++)
+            {
+                before[k] = vertices[corners[k]].Position;
+                after[k] = corners[k] == from ? vertices[to].Position : before[k];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+            {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid)
+            continue;
+
+        // Move from's triangles onto to, the ones spanning the edge disappear
+        for (unsigned int t : vertexTriangles[from])
+        {
+            if (!triangleAlive[t])
+                continue;
+            unsigned int* corners = &triangles[t * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+            {
+                triangleAlive[t] = false;
+                aliveIndices -= 3;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                if (corners[k] == from)
+                    corners[k] = to;
+            }
+            vertexTriangles[to].push_back(t);
+        }
+        collapsed[from] = true;
+        quadrics[to].add(quadrics[from]);
+        version[to]++;
+        error = std::max(error, static_cast<float>(std::sqrt(collapse.cost)));
+        pushVertexEdges(to);
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(aliveIndices);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (triangleAlive[t])
+            result.insert(result.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+    }
+    return result;
+}
+
+// Build up to MAX_MESH_LODS levels, each about half the triangles of the last, appended to meshData.indices
+// Each level is simplified from the previous one and cache-optimized on its own; stops once a level
+// barely shrinks (seams and borders stay put, so some meshes bottom out early)
+void generateMeshLods(MeshData& meshData)
+{
+    meshData.lods.clear();
+    meshData.lods.push_back({ 0, static_cast<uint32_t>(meshData.indices.size()), 0.0f });
+
+    std::vector<unsigned int> previous(meshData.indices);
+    float previousError = 0.0f;
+    while (static_cast<int>(meshData.lods.size()) < MAX_MESH_LODS)
+    {
+        size_t target = static_cast<size_t>(previous.size() / 3 * LOD_REDUCTION) * 3;
+        float levelError;
+        std::vector<unsigned int> level = simplifyMesh(meshData.vertices, previous, target, levelError);
+        if (level.empty() || level.size() > previous.size() * LOD_MINIMUM_GAIN)
+            break;
+
+        optimizeVertexCache(level, meshData.vertices.size());
+        previousError = std::max(previousError, levelError);
+        meshData.lods.push_back({ static_cast<uint32_t>(meshData.indices.size()), static_cast<uint32_t>(level.size()), previousError });
+        meshData.indices.insert(meshData.indices.end(), level.begin(), level.end());
+        previous.swap(level);
+    }
+}
+
+// Screen pixels covered by one model unit at a given distance, for a vertical field of view in radians
+float projectedPixelsPerUnit(float distance, float fovY, float viewportHeight)
+{
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f) * std::max(distance, 1e-4f));
+}
+#endif // MY_MESH_LOD_H
@@ -0,0 +1,341 @@
+#ifndef MY_MESH_OPTIMIZER_H
+#define MY_MESH_OPTIMIZER_H
+
+#include <my_mesh.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Post-import index/vertex reordering: vertex cache locality (Forsyth), overdraw (cluster sort)
+// and vertex fetch locality, plus the cache statistics to check the result against
+// Pure CPU, runs in Model's import phase and the result is what the mesh cache stores
+
+// Post-transform cache the statistics are simulated with (FIFO, typical of real hardware)
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// Larger LRU cache the Forsyth scores are tuned for
+const int FORSYTH_CACHE_SIZE = 32;
+
+struct VertexCacheStats
+{
+    float acmr = 0.0f;  // Average cache miss ratio: transformed vertices per triangle (0.5 ideal, 3 worst)
+    float atvr = 0.0f;  // Average transformed vertex ratio: transformed vertices per unique vertex (1 ideal)
+    size_t transformedVertices = 0;
+    size_t uniqueVertices = 0;
+};
+
+// Simulate a FIFO post-transform cache over a triangle list
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0)
+        return stats;
+
+    // Timestamp of each vertex's entry into the cache, a vertex is resident while it's within cacheSize misses
+    std::vector<size_t> cachedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t misses = 0;
+    size_t uniqueVertices = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int index = indices[i];
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            uniqueVertices++;
+        }
+        if (cachedAt[index] == 0 || misses - cachedAt[index] >= cacheSize)
+        {
+            misses++;
+            cachedAt[index] = misses;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / (indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / uniqueVertices;
+    stats.transformedVertices = misses;
+    stats.uniqueVertices = uniqueVertices;
+    return stats;
+}
+
+// Forsyth's vertex score: recently used vertices and vertices with few triangles left score high
+float forsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The last triangle's vertices get a fixed score so it isn't immediately reused
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (cachePosition - 3) / static_cast<float>(FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+// Reorder triangles for post-transform cache reuse (Tom Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Triangle adjacency per vertex (offsets into one flat list)
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices)
+        remaining[index]++;
+    std::vector<size_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<size_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t scanCursor = 0;
+    long long bestTriangle = -1;
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Nothing adjacent to the cache: take the next unemitted triangle in input order
+        if (bestTriangle < 0)
+        {
+            while (emitted[scanCursor])
+                scanCursor++;
+            bestTriangle = static_cast<long long>(scanCursor);
+        }
+
+        size_t triangle = static_cast<size_t>(bestTriangle);
+        emitted[triangle] = true;
+        const unsigned int* corners = &indices[triangle * 3];
+        output.insert(output.end(), corners, corners + 3);
+
+        // Detach the triangle from its vertices
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int vertex = corners[k];
+            unsigned int* begin = &adjacency[adjacencyOffset[vertex]];
+            unsigned int* end = begin + remaining[vertex];
+            std::iter_swap(std::find(begin, end, static_cast<unsigned int>(triangle)), end - 1);
+            remaining[vertex]--;
+        }
+
+        // New cache: this triangle's vertices first, then the old contents minus those
+        nextCache.assign(corners, corners + 3);
+        for (unsigned int vertex : cache)
+        {
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                nextCache.push_back(vertex);
+        }
+        if (nextCache.size() > static_cast<size_t>(FORSYTH_CACHE_SIZE))
+        {
+            // Evicted vertices only need a rescore
+            for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); i++)
+            {
+                unsigned int vertex = nextCache[i];
+                vertexScore[vertex] = forsythVertexScore(-1, remaining[vertex]);
+                for (size_t a = 0; a < remaining[vertex]; a++)
+                {
+                    unsigned int t = adjacency[adjacencyOffset[vertex] + a];
+                    triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                }
+            }
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+
+        // Rescore the cache and pick the best triangle touching it
+        for (size_t i = 0; i < cache.size(); i++)
+            vertexScore[cache[i]] = forsythVertexScore(static_cast<int>(i), remaining[cache[i]]);
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (unsigned int vertex : cache)
+        {
+            for (size_t a = 0; a < remaining[vertex]; a++)
+            {
+                unsigned int t = adjacency[adjacencyOffset[vertex] + a];
+                triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+    indices.swap(output);
+}
+
+// Reorder clusters of the cache-optimized triangle list so outward-facing surfaces draw first,
+// which approximates front-to-back from any viewpoint (Tipsify-style). Clusters split where the
+// simulated cache restarts, so the order within each stays cache friendly; the result is kept
+// only if the ACMR stays within threshold of the input's
+void optimizeOverdraw(std::vector<unsigned int>& indices, const Vertex* vertices, size_t vertexCount, float threshold = 1.05f)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Cluster boundaries: a triangle that misses on all three vertices starts a new cluster
+    const size_t minimumClusterSize = 32;
+    std::vector<size_t> clusterStarts(1, 0);
+    std::vector<size_t> cachedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        int triangleMisses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int index = indices[t * 3 + k];
+            if (cachedAt[index] == 0 || misses - cachedAt[index] >= VERTEX_CACHE_SIZE)
+            {
+                misses++;
+                cachedAt[index] = misses;
+                triangleMisses++;
+            }
+        }
+        if (triangleMisses == 3 && t - clusterStarts.back() >= minimumClusterSize)
+            clusterStarts.push_back(t);
+    }
+    clusterStarts.push_back(triangleCount);
+    if (clusterStarts.size() <= 2)
+        return;
+
+    // Area-weighted centroid and normal per cluster
+    size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<glm::vec3> clusterCentroid(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusterCount, 0.0f);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+        {
+            const glm::vec3& a = vertices[indices[t * 3]].Position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 normal = glm::cross(b - a, p - a);
+            float area = glm::length(normal);
+            clusterCentroid[c] += (a + b + p) * (area / 3.0f);
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+        }
+        meshCentroid += clusterCentroid[c];
+        meshArea += clusterArea[c];
+        if (clusterArea[c] > 0.0f)
+            clusterCentroid[c] /= clusterArea[c];
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Sort by how far each cluster faces out from the centre, most outward first
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float normalLength = glm::length(clusterNormal[c]);
+        sortKey[c] = normalLength > 0.0f ? glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c] / normalLength) : 0.0f;
+    }
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (size_t c : order)
+        sorted.insert(sorted.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+
+    float before = analyzeVertexCache(indices.data(), indices.size(), vertexCount).acmr;
+    float after = analyzeVertexCache(sorted.data(), sorted.size(), vertexCount).acmr;
+    if (after <= before * threshold)
+        indices.swap(sorted);
+}
+
+// Reorder vertices into first-use order so fetches walk memory forwards, unreferenced vertices are dropped
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const unsigned int unassigned = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unassigned);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == unassigned)
+        {
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+// Before/after statistics of one optimizeMesh call (or a sum of them, see add)
+struct MeshOptimizationReport
+{
+    size_t triangles = 0;
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t missesBefore = 0;
+    size_t missesAfter = 0;
+
+    void add(const MeshOptimizationReport& other)
+    {
+        triangles += other.triangles;
+        verticesBefore += other.verticesBefore;
+        verticesAfter += other.verticesAfter;
+        missesBefore += other.missesBefore;
+        missesAfter += other.missesAfter;
+    }
+
+    float acmrBefore() const { return triangles ? static_cast<float>(missesBefore) / triangles : 0.0f; }
+    float acmrAfter() const { return triangles ? static_cast<float>(missesAfter) / triangles : 0.0f; }
+    float atvrBefore() const { return verticesBefore ? static_cast<float>(missesBefore) / verticesBefore : 0.0f; }
+    float atvrAfter() const { return verticesAfter ? static_cast<float>(missesAfter) / verticesAfter : 0.0f; }
+};
+
+// All three passes in order: vertex cache, overdraw, vertex fetch
+MeshOptimizationReport optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    MeshOptimizationReport report;
+    report.triangles = indices.size() / 3;
+    if (report.triangles == 0)
+        return report;
+
+    VertexCacheStats before = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    report.missesBefore = before.transformedVertices;
+    report.verticesBefore = before.uniqueVertices;
+
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices.data(), vertices.size());
+    optimizeVertexFetch(vertices, indices);
+
+    VertexCacheStats after = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    report.missesAfter = after.transformedVertices;
+    report.verticesAfter = after.uniqueVertices;
+    return report;
+}
+#endif // MY_MESH_OPTIMIZER_H
@@ -11,83 +11,925 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <my_asset_io.h>
+#include <my_async_io.h>
+#include <my_gltf.h>
+#include <my_gl_state.h>
+#include <my_import_profile.h>
+#include <my_ktx_texture.h>
 #include <my_mesh.h>
+#include <my_mesh_batch.h>
+#include <my_mesh_cache.h>
+#include <my_mesh_instancing.h>
+#include <my_mesh_lod.h>
+#include <my_mesh_optimizer.h>
+#include <my_obj_parser.h>
 #include <my_shader.h>
+#include <my_texture_cache.h>
+#include <my_transform_hierarchy.h>
+#include <my_upload_worker.h>
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
+// Decoded image waiting for upload
+struct TextureImage
+{
+    int width = 0;
+    int height = 0;
+    int numChannels = 0;
+    unsigned char* data = nullptr;
+};
+
 // Forward declare
 unsigned int loadTexture(const char* texturePath);
+unsigned int loadTexture(const char* texturePath, UploadWorker& worker);
+TextureImage decodeTexture(const char* texturePath);
+TextureImage decodeTextureMemory(const unsigned char* data, size_t size, const std::string& name);
+unsigned int uploadTexture(const TextureImage& image);
+GLenum textureImageFormat(const TextureImage& image);
+size_t textureImageBytes(const TextureImage& image);
+void freeTextureImage(TextureImage& image);
+
+// Post-import steps of our own (also stamped into mesh caches)
+const unsigned int MODEL_PROCESS_OPTIMIZE = 1 << 0;
+const unsigned int MODEL_PROCESS_QUANTIZE = 1 << 1;
+const unsigned int MODEL_PROCESS_LODS = 1 << 2;
+const unsigned int MODEL_PROCESS_NATIVE_OBJ = 1 << 3;
+const unsigned int MODEL_PROCESS_INSTANCING = 1 << 4;
+const unsigned int MODEL_PROCESS_INSTANCING_ANY_TEXCOORDS = 1 << 5;
+const unsigned int MODEL_PROCESS_COMPRESS = 1 << 6;
+
+// Decoded textures and the mapped mesh cache or GLB handed to an UploadWorker, kept alive until its last job is done
+// (mesh jobs read the mapping, or the Mesh's own CPU copy for freshly imported or decoded meshes)
+struct ModelUploadSource
+{
+    std::map<std::string, TextureImage> textures;
+    MeshCache cache;
+    AssetFile glb;
+
+    ~ModelUploadSource()
+    {
+        for (auto& texture : textures)
+            freeTextureImage(texture.second);
+    }
+};
+
+// Geometry memory of one Model (see Model::memoryStats)
+struct ModelMemoryStats
+{
+    size_t meshes = 0;
+    size_t instances = 0;           // Copies drawn with another mesh's buffers
+    size_t cpuGeometryBytes = 0;    // Full vertex/index copies kept in RAM
+    size_t collisionBytes = 0;      // Collision proxies
+    float collisionError = 0.0f;    // Largest distance of a proxy from its drawn mesh (coarse proxies only), model units
+    size_t gpuGeometryBytes = 0;    // Vertex/index buffers, the batch's included
+    size_t batchGpuBytes = 0;       // Buffers of the merged meshes' batch (see MeshBatch)
+};
 
 class Model
 {
 public:
-    // Public for wall constraints
+    // Public for wall constraints (full geometry or collision proxies, depending on residency)
     std::vector<Mesh> meshes;
 
+    // What every mesh keeps in RAM after its upload (see GeometryResidency)
+    // Set before uploading
+    GeometryResidency residency = RESIDENCY_KEEP_ALL;
+
+    // Reorder imported meshes for vertex cache, overdraw and fetch locality (see my_mesh_optimizer.h)
+    // Set before loading, the mesh cache is keyed on it
+    bool optimizeMeshes = true;
+
+    // Store vertices in the 16-byte packed format instead of 32-byte floats (see my_vertex.h)
+    // Set before loading, the mesh cache is keyed on it
+    bool quantizeVertices = false;
+
+    // Build simplified detail levels for every mesh, picked per frame by selectLods() (see my_mesh_lod.h)
+    // Set before loading, the mesh cache is keyed on it
+    bool generateLods = true;
+
+    // Import profile picking the Assimp steps and vertex attributes the model's shader needs (see my_import_profile.h)
+    // Set before loading, the mesh cache is keyed on it
+    std::string importProfile = "lit_textured";
+
+    // Also time the steps the profile skips so the log shows what each one saved
+    // Costs a second Assimp import per load, so it's for benchmarks (see tools/model_load_benchmark.cpp), not the app
+    bool measureImportSavings = false;
+
+    // Read .obj files with the native parallel parser instead of Assimp (see my_obj_parser.h)
+    // Set before loading, the mesh cache is keyed on it
+    bool nativeObjImport = false;
+
+    // Fold meshes that are rotated/mirrored copies of another into instances of it, sharing its buffers (see my_mesh_instancing.h)
+    // Set before loading, the mesh cache is keyed on it
+    bool shareInstances = true;
+
+    // Also fold copies whose texcoords differ (their own UV island in an atlas), drawing them textured like the original
+    // Set before loading, the mesh cache is keyed on it
+    bool shareInstancesAcrossTexCoords = false;
+
+    // Write the mesh cache with encoded vertex/index streams (see my_mesh_codec.h): a fraction of the size on disk
+    // and in the pack, decoded on the loader thread. Best with quantizeVertices, packed bytes delta-code well
+    // Set before loading, the mesh cache is keyed on it
+    bool compressMeshCache = false;
+
+    // Copy the static meshes into one buffer once the model is ready and draw them with a multi-draw per material
+    // (see my_mesh_batch.h), the shaders must bind the ModelParts block to MODEL_PARTS_BINDING
+    bool mergeMeshes = true;
+
+    // Production: never parse the source model, a missing or stale mesh cache fails the load instead
+    // The caches come from the asset cooker (see my_asset_cooker.h), which builds them with the same settings
+    bool requireCookedAssets = false;
+
+    // Empty model, filled by loadModelData() + uploadModelData() (see ModelLoader)
+    Model() {}
+
     // Constructor (expects a filepath to a 3D model)
-    Model(std::string const& objPath)
+    // With useMeshCache a binary cache is read from/written to objPath + ".meshcache"
+    Model(std::string const& objPath, bool useMeshCache = true)
     {
-        loadModel(objPath);
+        loadModelData(objPath, useMeshCache);
+        uploadModelData();
     }
 
-    // Draw the model (all its meshes)
-    void draw(Shader& shader)
+    // No copies: a copy's ~Model would release acquiredTextures a second time, and meshes own their GL objects
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // Give the shared textures back to the cache
+    ~Model()
     {
-        for (unsigned int i = 0; i < static_cast<unsigned int>(meshes.size()); i++)
-            meshes[i].draw(shader);
+        for (unsigned int textureID : acquiredTextures)
+            TextureCache::instance().release(textureID);
     }
 
-    // Draw the model (all its meshes) hierarchicaly
-    void drawHierarchy(Shader& shader, glm::mat4& modelMat, float& rot)
+    // CPU phase: import (or map the cache), read the rig and decode textures
+    // Makes no GL calls so it can run on a worker thread (not one of fileReader's)
+    // With a fileReader the textures are read in one batch, each decoded as soon as it arrives
+    void loadModelData(std::string const& objPath, bool useMeshCache = true, AsyncFileReader* fileReader = nullptr)
+    {
+        loadModel(objPath, useMeshCache);
+        pendingHierarchy.load(TransformHierarchy::rigPath(objPath));
+        decodeTextures(fileReader);
+    }
+
+    // Offline: import and process objPath into its mesh cache, keeping nothing (see my_asset_cooker.h)
+    // A cache that's already valid for the current settings is left as is
+    bool cookMeshCache(std::string const& objPath)
+    {
+        loadModel(objPath, true);
+        pendingMeshes.clear();
+        pendingCache.close();
+
+        MeshCache written;
+        return written.open(objPath + MESH_CACHE_EXTENSION, hashModelSources(objPath), importFlags(), processFlags());
+    }
+
+    // GL phase: upload textures and meshes from the CPU phase, must run on the context thread
+    void uploadModelData()
+    {
+        meshes.reserve(meshes.size() + pendingMeshes.size());
+        for (MeshData& meshData : pendingMeshes)
+        {
+            std::vector<Texture> textures;
+            for (const std::string& texturePath : meshData.texturePaths)
+            {
+                Texture texture;
+                texture.id = acquireTexture(texturePath);
+                texture.path = texturePath;
+                textures.push_back(texture);
+            }
+
+            meshes.emplace_back(std::move(meshData), std::move(textures), true, residency);
+        }
+
+        bindHierarchy();
+
+        // Done with the import results (and the cache or GLB mapping)
+        for (auto& pendingTexture : pendingTextures)
+            freeTextureImage(pendingTexture.second);
+        pendingMeshes.clear();
+        pendingTextures.clear();
+        pendingCache.close();
+        pendingGlb.close();
+    }
+
+    // GL phase through an UploadWorker: names are created here and the data streams in over the next
+    // frames, the model starts drawing once all of it has arrived (render thread, model must outlive the uploads)
+    void uploadModelDataAsync(UploadWorker& worker)
     {
-        for (unsigned int i = 0; i < static_cast<unsigned int>(meshes.size()); i++)
+        if (!worker.isRunning())
         {
-            if (meshes[i].meshName == "propeller")
+            uploadModelData();
+            return;
+        }
+
+        // Hand the decoded textures over to the worker's jobs
+        std::shared_ptr<ModelUploadSource> source = std::make_shared<ModelUploadSource>();
+        source->textures.swap(pendingTextures);
+        source->cache = std::move(pendingCache);
+        source->glb = std::move(pendingGlb);
+        ready = false;
+
+        meshes.reserve(meshes.size() + pendingMeshes.size());
+        for (MeshData& meshData : pendingMeshes)
+        {
+            std::vector<Texture> textures;
+            for (const std::string& texturePath : meshData.texturePaths)
             {
-                // Offset read off in blender file (y and z values swapped, z value inverted [old y value])
-                glm::vec3 propellerOffset(0.0f, 0.21443f, 3.382f);
-                meshes[i].drawHierarchy(shader, modelMat, rot, propellerOffset, z_axis);
+                Texture texture;
+                texture.id = acquireTextureAsync(texturePath, worker, source);
+                texture.path = texturePath;
+                textures.push_back(texture);
             }
-            else if (meshes[i].meshName == "wheel1")
+
+            // Mapped meshes (mesh cache, GLB) are read straight from the mapping the source keeps open
+            bool mapped = meshData.cachedVertices != nullptr;
+            const void* mappedVertices = meshData.vertexData();
+            const void* mappedIndices = meshData.indexData();
+            size_t vertexBytes = meshData.vertexBytes();
+            size_t indexBytes = meshData.indexBytes();
+            meshes.emplace_back(std::move(meshData), std::move(textures), false, residency);
+
+            // Jobs complete in order, so the index buffer's callback sees both buffers filled
+            // The others read the mesh's own CPU copy, whose storage doesn't move with the Mesh and is only
+            // trimmed to the residency policy once attachBuffers() runs
+            const Mesh& mesh = meshes.back();
+            GLuint buffers[2];
+            glGenBuffers(2, buffers);
+            size_t meshIndex = meshes.size() - 1;
+            pendingUploads++;
+            worker.queueBuffer(buffers[0], GL_ARRAY_BUFFER, mapped ? mappedVertices : mesh.vertexData(), vertexBytes, source);
+            worker.queueBuffer(buffers[1], GL_ELEMENT_ARRAY_BUFFER, mapped ? mappedIndices : mesh.indexData(), indexBytes, source,
+                [this, meshIndex, vertexBuffer = buffers[0], vertexBytes, indexBuffer = buffers[1], indexBytes]
+                {
+                    meshes[meshIndex].attachBuffers(vertexBuffer, vertexBytes, indexBuffer, indexBytes);
+                    pendingUploads--;
+                });
+        }
+
+        bindHierarchy();
+
+        // The cache mapping went to the source, the meshes' jobs read it
+        pendingMeshes.clear();
+    }
+
+    // Whether every mesh and texture has reached the GPU
+    bool isReady()
+    {
+        if (!ready && pendingUploads == 0)
+        {
+            ready = true;
+            for (unsigned int textureID : acquiredTextures)
+                ready = ready && TextureCache::instance().isReady(textureID);
+        }
+        return ready;
+    }
+
+    // Geometry memory summed over every mesh
+    ModelMemoryStats memoryStats() const
+    {
+        ModelMemoryStats stats;
+        stats.meshes = meshes.size();
+        for (const Mesh& mesh : meshes)
+        {
+            stats.instances += mesh.instances.size();
+            stats.cpuGeometryBytes += mesh.cpuGeometryBytes();
+            stats.collisionBytes += mesh.collisionBytes();
+            stats.collisionError = std::max(stats.collisionError, mesh.collisionError());
+            stats.gpuGeometryBytes += mesh.gpuBytes;
+        }
+        stats.batchGpuBytes = batch.gpuBytes();
+        stats.gpuGeometryBytes += stats.batchGpuBytes;
+        return stats;
+    }
+
+    void printMemoryStats(const std::string& name) const
+    {
+        static const char* residencyNames[] = { "keep all", "collision proxy", "free after upload", "coarse collision proxy" };
+        ModelMemoryStats stats = memoryStats();
+        std::cout << "Model memory: " << name << " (" << residencyNames[residency] << "), " << stats.meshes << " meshes (+" << stats.instances << " instances), "
+            << stats.gpuGeometryBytes / 1024 << " KB GPU (" << stats.batchGpuBytes / 1024 << " KB batched), " << stats.cpuGeometryBytes / 1024 << " KB CPU geometry, "
+            << stats.collisionBytes / 1024 << " KB collision proxy";
+        if (residency == RESIDENCY_COARSE_COLLISION_PROXY)
+            std::cout << " (up to " << stats.collisionError << " off the drawn surface)";
+        std::cout << std::endl;
+    }
+
+    // Pick every mesh's detail level from its projected size, call once per frame before drawing
+    // modelMat places the model in the world, fovY is the vertical field of view in radians
+    void selectLods(const glm::mat4& modelMat, const glm::vec3& cameraPosition, float fovY, float viewportHeight)
+    {
+        // Largest axis scale, so errors are never under-estimated
+        float scale = std::max(glm::length(glm::vec3(modelMat[0])), std::max(glm::length(glm::vec3(modelMat[1])), glm::length(glm::vec3(modelMat[2]))));
+        for (Mesh& mesh : meshes)
+        {
+            // Distance to the bounding sphere, not its centre, so large meshes don't drop detail right in front of the camera
+            glm::vec3 center = glm::vec3(modelMat * glm::vec4(mesh.boundsCenter, 1.0f));
+            float distance = glm::length(center - cameraPosition) - mesh.boundsRadius * scale;
+            mesh.selectLod(projectedPixelsPerUnit(distance, fovY, viewportHeight) * scale);
+        }
+    }
+
+    // Draw the model (all its meshes) at rest, the caller having set the model uniform
+    void draw(Shader& shader)
+    {
+        if (!isReady())
+            return;
+
+        drawMeshes(shader, nullptr);
+    }
+
+    // Draw the model (all its meshes) posed by its hierarchy, rot (degrees) driving the spin channel
+    // The caller sets modelMat as the model uniform, parts drawn on their own put their node's matrix on top of it
+    void drawHierarchy(Shader& shader, glm::mat4& modelMat, float& rot)
+    {
+        if (!isReady())
+            return;
+
+        hierarchy.setChannel(spinChannel, rot);
+        hierarchy.update();
+        drawMeshes(shader, &modelMat);
+    }
+
+    // Movable parts, from the model's rig file (see my_transform_hierarchy.h), bound to the meshes at load
+    // Channels other than spin can be driven with hierarchy.setChannel, resolving their index once with findChannel
+    TransformHierarchy hierarchy;
+
+private:
+    MeshBatch batch;
+    bool batchBuilt = false;
+    int spinChannel = -1;
+    TransformHierarchy pendingHierarchy;
+
+    // Merge the meshes on the first draw after they've all arrived (meshes added later are drawn on their own)
+    // Until then, e.g. while the loader is still importing or the upload worker streaming, every draw checks again
+    void prepareBatch()
+    {
+        if (!mergeMeshes || batchBuilt || meshes.empty())
+            return;
+        for (const Mesh& mesh : meshes)
+        {
+            if (!mesh.isUploaded())
+                return;
+        }
+        batchBuilt = true;
+        batch.build(meshes);
+    }
+
+    // Take over the rig read with the meshes and resolve every mesh, copy and channel name against it, once per load
+    void bindHierarchy()
+    {
+        if (pendingHierarchy.nodeCount() > 0)
+            hierarchy = std::move(pendingHierarchy);
+        pendingHierarchy = TransformHierarchy();
+        spinChannel = hierarchy.findChannel(HIERARCHY_SPIN_CHANNEL);
+        for (Mesh& mesh : meshes)
+        {
+            mesh.hierarchyNode = hierarchy.findMeshNode(mesh.meshName);
+
+            // Node-placed meshes (GLB) turn about their node's origin unless the rig gives a pivot
+            if (mesh.hierarchyNode >= 0 && mesh.placedByNode && !hierarchy.hasPivot(mesh.hierarchyNode))
+                hierarchy.setPivot(mesh.hierarchyNode, glm::vec3(mesh.nodeMatrix[3]));
+            for (MeshInstance& instance : mesh.instances)
+                instance.hierarchyNode = hierarchy.findMeshNode(instance.meshName);
+        }
+    }
+
+    // Merged meshes in the batch's draws, the rest one by one, posed by the hierarchy when modelMat is given
+    void drawMeshes(Shader& shader, const glm::mat4* modelMat)
+    {
+        prepareBatch();
+        bool posed = modelMat != nullptr;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            if (batch.contains(i))
+                batch.setTransform(i, posed && meshes[i].hierarchyNode >= 0 ? hierarchy.worldMatrix(meshes[i].hierarchyNode) : glm::mat4(1.0f));
+        }
+        batch.draw(shader, meshes);
+
+        // A posed part leaves its own matrix in the model uniform, it's only put back for the next part without one
+        GLint modelLocation = shader.drawUniforms.model;
+        bool modelMatSet = true;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            if (batch.contains(i))
+                continue;
+            Mesh& mesh = meshes[i];
+            if (posed && mesh.hierarchyNode >= 0 && !mesh.drawsInstanced())
             {
-                // Offset read off in blender file (y and z values swapped, z value inverted [old y value])
-                glm::vec3 wheel1Offset(0.611347f, -1.02468f, 1.54278f);
-                meshes[i].drawHierarchy(shader, modelMat, rot, wheel1Offset, x_axis);
+                shader.setMat4(modelLocation, *modelMat * hierarchy.worldMatrix(mesh.hierarchyNode));
+                modelMatSet = false;
             }
-            else if (meshes[i].meshName == "wheel2")
+            else if (!modelMatSet)
             {
-                // Offset read off in blender file (y and z values swapped, z value inverted [old y value])
-                glm::vec3 wheel2Offset(-0.611347f, -1.02468f, 1.54278f);
-                meshes[i].drawHierarchy(shader, modelMat, rot, wheel2Offset, x_axis);
+                shader.setMat4(modelLocation, *modelMat);
+                modelMatSet = true;
             }
+
+            if (mesh.drawsInstanced())
+                drawWithInstances(shader, mesh, posed);
             else
-                meshes[i].draw(shader);
+                mesh.draw(shader);
         }
     }
 
-private:
-    // Load a 3D model specified by path
-    void loadModel(std::string const& path)
+    // Draw a mesh and the copies sharing its buffers, each posed by its own node if it has one
+    void drawWithInstances(Shader& shader, Mesh& mesh, bool posed)
+    {
+        std::vector<glm::mat4> matrices, mirroredMatrices;
+        glm::mat4 self = posed && mesh.hierarchyNode >= 0 ? hierarchy.worldMatrix(mesh.hierarchyNode) : glm::mat4(1.0f);
+        if (mesh.placedByNode)
+            (glm::determinant(glm::mat3(mesh.nodeMatrix)) < 0.0f ? mirroredMatrices : matrices).push_back(self * mesh.nodeMatrix);
+        else
+            matrices.push_back(self);
+        for (const MeshInstance& instance : mesh.instances)
+        {
+            glm::mat4 pose = posed && instance.hierarchyNode >= 0 ? hierarchy.worldMatrix(instance.hierarchyNode) : glm::mat4(1.0f);
+            (instance.mirrored ? mirroredMatrices : matrices).push_back(pose * instance.transform);
+        }
+        mesh.drawInstanced(shader, matrices, mirroredMatrices);
+    }
+
+    // Import phase results waiting for uploadModelData()
+    std::vector<MeshData> pendingMeshes;
+    std::map<std::string, TextureImage> pendingTextures;
+    MeshCache pendingCache;
+    AssetFile pendingGlb;
+
+    // References held in the texture cache, one per mesh texture slot
+    std::vector<unsigned int> acquiredTextures;
+
+    // Async upload progress (see uploadModelDataAsync)
+    size_t pendingUploads = 0;
+    bool ready = true;
+
+    // Load a 3D model specified by path into pendingMeshes
+    void loadModel(std::string const& path, bool useMeshCache)
+    {
+        // GLBs are already in GPU layout: no cache and no processing, their meshes upload from the mapping
+        if (hasExtension(path, ".glb"))
+        {
+            loadGlbModel(path);
+            return;
+        }
+
+        // Try the binary mesh cache first, a valid one skips Assimp entirely
+        std::string cachePath = path + MESH_CACHE_EXTENSION;
+        uint64_t sourceHash = 0;
+        if (useMeshCache)
+        {
+            sourceHash = hashModelSources(path);
+            if (sourceHash != 0 && loadFromMeshCache(cachePath, sourceHash))
+                return;
+        }
+        if (requireCookedAssets)
+        {
+            std::cout << "ERROR::MODEL:: No valid mesh cache for " << path << ", run the asset cooker (not importing the source)" << std::endl;
+            return;
+        }
+
+        if (useNativeObjImport(path))
+        {
+            if (!parseObjFile(path, pendingMeshes, 0, findImportProfile(importProfile).attributes))
+                return;
+        }
+        else if (!importWithAssimp(path))
+            return;
+
+        // Before any per-mesh processing, folded copies don't need it
+        if (shareInstances)
+            sharePendingInstances(path);
+
+        if (optimizeMeshes)
+            optimizePendingMeshes(path);
+        for (MeshData& meshData : pendingMeshes)
+            computeMeshBounds(meshData.vertices, meshData.boundsCenter, meshData.boundsRadius);
+        if (generateLods)
+            generatePendingLods(path);
+        if (quantizeVertices)
+            quantizePendingMeshes(path);
+        for (MeshData& meshData : pendingMeshes)
+            meshData.selectIndexType();
+
+        // Save the result for the next launch (packed models are read-only, their cache is packed with them)
+        if (useMeshCache && sourceHash != 0 && !AssetPack::instance().contains(path) && !writeMeshCache(cachePath, sourceHash, importFlags(), processFlags(), pendingMeshes, compressMeshCache))
+            std::cout << "WARNING::MESH_CACHE:: Failed to write " << cachePath << std::endl;
+    }
+
+    // Read file through Assimp into pendingMeshes, running only the steps the import profile needs
+    // Steps are applied one at a time so the log can show what each of them cost
+    bool importWithAssimp(std::string const& path)
     {
-        // Read file
+        const ImportProfile& profile = findImportProfile(importProfile);
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        importer.SetIOHandler(new AssetIOSystem());
+        importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, importProfileRemovedComponents(profile));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        const aiScene* scene = importer.ReadFile(path, 0);
+        double parseTime = millisecondsSince(start);
         
         // Check for errors
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
             std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
-            return;
+            return false;
         }
 
+        // Normals are only generated for files that don't have them
+        unsigned int steps = importProfileSteps(profile);
+        if ((profile.attributes & VERTEX_ATTRIBUTE_NORMAL) && !sceneHasNormals(scene))
+            steps |= aiProcess_GenSmoothNormals;
+
+        std::ostringstream log;
+        log << std::fixed << std::setprecision(2) << "Import profile " << profile.name << ": " << path << " parse " << parseTime << " ms";
+        for (const ImportStep& step : IMPORT_STEPS)
+        {
+            if (!(steps & step.flag))
+                continue;
+            start = std::chrono::high_resolution_clock::now();
+            scene = importer.ApplyPostProcessing(step.flag);
+            log << ", " << step.name << " " << millisecondsSince(start) << " ms";
+            if (!scene)
+            {
+                std::cout << "ERROR::ASSIMP:: " << step.name << ": " << importer.GetErrorString() << std::endl;
+                return false;
+            }
+        }
+
+        // Steps the old fixed flag set would have run on top
+        unsigned int skipped = LEGACY_IMPORT_STEPS & ~steps;
+        if (skipped)
+        {
+            std::map<unsigned int, double> savings;
+            if (measureImportSavings)
+                savings = timeImportSteps(path, profile, skipped);
+            log << "; skipped";
+            for (const ImportStep& step : IMPORT_STEPS)
+            {
+                if (!(skipped & step.flag))
+                    continue;
+                log << " " << step.name;
+                if (savings.count(step.flag))
+                    log << " (saves " << savings[step.flag] << " ms)";
+            }
+        }
+        std::cout << log.str() << std::endl;
+
         // Process ASSIMP's root node recursively
+        pendingMeshes.reserve(scene->mNumMeshes);
         processNode(scene->mRootNode, scene);
+        return true;
+    }
+
+    // Replay a legacy import of path and time the given steps (the others run untimed to keep the input realistic)
+    std::map<unsigned int, double> timeImportSteps(std::string const& path, const ImportProfile& profile, unsigned int timedSteps)
+    {
+        std::map<unsigned int, double> times;
+        Assimp::Importer importer;
+        importer.SetIOHandler(new AssetIOSystem());
+        importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, importProfileRemovedComponents(profile));
+        if (!importer.ReadFile(path, 0))
+            return times;
+
+        unsigned int steps = LEGACY_IMPORT_STEPS | (importProfileSteps(profile) & aiProcess_RemoveComponent);
+        for (const ImportStep& step : IMPORT_STEPS)
+        {
+            if (!(steps & step.flag))
+                continue;
+            auto start = std::chrono::high_resolution_clock::now();
+            if (!importer.ApplyPostProcessing(step.flag))
+                break;
+            if (timedSteps & step.flag)
+                times[step.flag] = millisecondsSince(start);
+        }
+        return times;
+    }
+
+    static bool sceneHasNormals(const aiScene* scene)
+    {
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+        {
+            if (!scene->mMeshes[i]->HasNormals())
+                return false;
+        }
+        return true;
+    }
+
+    static double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Assimp steps stamped into the mesh cache, distinct per import profile
+    unsigned int importFlags() const
+    {
+        return importProfileSteps(findImportProfile(importProfile));
+    }
+
+    bool useNativeObjImport(std::string const& path) const
+    {
+        return nativeObjImport && hasExtension(path, ".obj");
+    }
+
+    // Case-insensitive file extension test, extension including the dot
+    static bool hasExtension(std::string const& path, const char* extension)
+    {
+        size_t length = strlen(extension);
+        if (path.size() < length)
+            return false;
+        for (size_t i = 0; i < length; i++)
+        {
+            if (std::tolower(static_cast<unsigned char>(path[path.size() - length + i])) != std::tolower(static_cast<unsigned char>(extension[i])))
+                return false;
+        }
+        return true;
+    }
+
+    unsigned int processFlags() const
+    {
+        return (optimizeMeshes ? MODEL_PROCESS_OPTIMIZE : 0) | (quantizeVertices ? MODEL_PROCESS_QUANTIZE : 0) |
+            (generateLods ? MODEL_PROCESS_LODS : 0) | (nativeObjImport ? MODEL_PROCESS_NATIVE_OBJ : 0) |
+            (shareInstances ? MODEL_PROCESS_INSTANCING : 0) | (shareInstancesAcrossTexCoords ? MODEL_PROCESS_INSTANCING_ANY_TEXCOORDS : 0) |
+            (compressMeshCache ? MODEL_PROCESS_COMPRESS : 0);
+    }
+
+    // Fold congruent copies into instances and report what they no longer upload
+    void sharePendingInstances(std::string const& path)
+    {
+        size_t meshCount = pendingMeshes.size();
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t savedBytes = shareDuplicateMeshes(pendingMeshes, !shareInstancesAcrossTexCoords);
+        std::cout << "Mesh instancing: " << path << " " << meshCount - pendingMeshes.size() << " of " << meshCount
+            << " meshes folded into instances, " << savedBytes / 1024 << " KB saved (" << millisecondsSince(start) << " ms)" << std::endl;
+    }
+
+    // Build the LOD chain of every imported mesh and report the triangle count at each level
+    void generatePendingLods(std::string const& path)
+    {
+        size_t levelTriangles[MAX_MESH_LODS] = {};
+        for (MeshData& meshData : pendingMeshes)
+        {
+            generateMeshLods(meshData);
+
+            // Meshes that bottom out early keep drawing their coarsest level
+            for (int level = 0; level < MAX_MESH_LODS; level++)
+                levelTriangles[level] += meshData.lods[std::min(level, static_cast<int>(meshData.lods.size()) - 1)].indexCount / 3;
+        }
+
+        std::cout << "Mesh LODs: " << path << " triangles";
+        for (int level = 0; level < MAX_MESH_LODS; level++)
+            std::cout << (level == 0 ? " " : " / ") << levelTriangles[level];
+        std::cout << std::endl;
+    }
+
+    // Run the mesh optimizer over every imported mesh and report the post-transform cache gain
+    void optimizePendingMeshes(std::string const& path)
+    {
+        MeshOptimizationReport report;
+        for (MeshData& meshData : pendingMeshes)
+            report.add(optimizeMesh(meshData.vertices, meshData.indices));
+
+        std::cout << "Mesh optimizer: " << path << " (" << report.triangles << " triangles) " << std::fixed << std::setprecision(3)
+            << "ACMR " << report.acmrBefore() << " -> " << report.acmrAfter() << ", "
+            << "ATVR " << report.atvrBefore() << " -> " << report.atvrAfter() << std::defaultfloat << std::endl;
+    }
+
+    // Switch every imported mesh to packed vertices and report the worst error any of them picked up
+    void quantizePendingMeshes(std::string const& path)
+    {
+        QuantizationError worst;
+        size_t vertexCount = 0;
+        for (MeshData& meshData : pendingMeshes)
+        {
+            vertexCount += meshData.vertices.size();
+            QuantizationError error = meshData.quantize();
+            worst.position = std::max(worst.position, error.position);
+            worst.positionRelative = std::max(worst.positionRelative, error.positionRelative);
+            worst.normalDegrees = std::max(worst.normalDegrees, error.normalDegrees);
+            worst.texCoord = std::max(worst.texCoord, error.texCoord);
+        }
+
+        std::cout << "Vertex quantization: " << path << " " << vertexCount * sizeof(Vertex) / 1024 << " KB -> "
+            << vertexCount * sizeof(PackedVertex) / 1024 << " KB, max error: position " << worst.position
+            << " (" << worst.positionRelative * 100.0f << "% of bounds), normal " << worst.normalDegrees
+            << " deg, texcoord " << worst.texCoord << std::endl;
+    }
+
+    // Point pendingMeshes at the buffers of a GLB, which stays mapped until the upload
+    // Embedded images are decoded here, decodeTextures() would look for them on disk
+    void loadGlbModel(std::string const& path)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        GlbScene scene;
+        if (!loadGlb(path, scene))
+            return;
+
+        for (const GlbEmbeddedImage& image : scene.images)
+        {
+            if (!TextureCache::instance().contains(image.key))
+                pendingTextures[image.key] = decodeTextureMemory(image.data, image.size, image.key);
+        }
+        size_t streamedBytes = 0;
+        for (MeshData& meshData : scene.meshes)
+            streamedBytes += meshData.vertexBytes() + meshData.indexBytes();
+
+        pendingMeshes = std::move(scene.meshes);
+        pendingGlb = std::move(scene.file);
+        std::cout << "GLB: " << path << " " << pendingMeshes.size() << " meshes from " << scene.nodeCount << " nodes, "
+            << streamedBytes / 1024 << " KB to upload from the mapping (" << millisecondsSince(start) << " ms)" << std::endl;
+    }
+
+    // Point pendingMeshes at a valid mesh cache, which stays mapped until the upload
+    bool loadFromMeshCache(std::string const& cachePath, uint64_t sourceHash)
+    {
+        if (!pendingCache.open(cachePath, sourceHash, importFlags(), processFlags()))
+            return false;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t encodedBytes = 0, decodedBytes = 0;
+        pendingMeshes.reserve(pendingCache.meshes().size());
+        for (const CachedMeshView& view : pendingCache.meshes())
+        {
+            MeshData meshData;
+            meshData.meshName = view.meshName;
+            meshData.texturePaths = view.texturePaths;
+            meshData.cachedVertices = view.vertices;
+            meshData.cachedVertexCount = view.vertexCount;
+            meshData.vertexFormat = view.vertexFormat;
+            meshData.quantization = view.quantization;
+            meshData.cachedIndices = view.indices;
+            meshData.cachedIndexCount = view.indexCount;
+            meshData.indexType = view.indexType;
+            meshData.lods = view.lods;
+            meshData.boundsCenter = view.boundsCenter;
+            meshData.boundsRadius = view.boundsRadius;
+            meshData.instances = view.instances;
+
+            // Compressed caches decode into owned buffers, which upload like freshly imported ones
+            if (view.vertexEncodedSize != 0 || view.indexEncodedSize != 0)
+            {
+                if (!decodeCachedMesh(view, meshData))
+                {
+                    std::cout << "WARNING::MESH_CACHE:: Corrupt compressed mesh " << view.meshName << ", importing the source instead" << std::endl;
+                    pendingMeshes.clear();
+                    pendingCache.close();
+                    return false;
+                }
+                encodedBytes += view.vertexEncodedSize + view.indexEncodedSize;
+                decodedBytes += meshData.vertexBytes() + meshData.indexBytes();
+            }
+            pendingMeshes.push_back(std::move(meshData));
+        }
+        if (encodedBytes != 0)
+            std::cout << "Mesh cache: decoded " << encodedBytes / 1024 << " KB into " << decodedBytes / 1024 << " KB of vertices and indices ("
+                << millisecondsSince(start) << " ms)" << std::endl;
+        return true;
+    }
+
+    // Expand a compressed cache entry into meshData's vertex and index vectors
+    static bool decodeCachedMesh(const CachedMeshView& view, MeshData& meshData)
+    {
+        const unsigned char* vertices = static_cast<const unsigned char*>(meshData.cachedVertices);
+        const unsigned char* indices = static_cast<const unsigned char*>(meshData.cachedIndices);
+        meshData.cachedVertices = nullptr;
+        meshData.cachedIndices = nullptr;
+
+        void* vertexData;
+        if (view.vertexFormat == VERTEX_FORMAT_PACKED)
+        {
+            meshData.packedVertices.resize(view.vertexCount);
+            vertexData = meshData.packedVertices.data();
+        }
+        else
+        {
+            meshData.vertices.resize(view.vertexCount);
+            vertexData = meshData.vertices.data();
+        }
+        void* indexData;
+        if (view.indexType == GL_UNSIGNED_SHORT)
+        {
+            meshData.shortIndices.resize(view.indexCount);
+            indexData = meshData.shortIndices.data();
+        }
+        else
+        {
+            meshData.indices.resize(view.indexCount);
+            indexData = meshData.indices.data();
+        }
+        return decodeVertexBuffer(vertexData, view.vertexCount, vertexFormatStride(view.vertexFormat), vertices, view.vertexEncodedSize) &&
+            decodeIndexBuffer(indexData, view.indexCount, indexTypeSize(view.indexType), indices, view.indexEncodedSize);
+    }
+
+    // Decode every texture the pending meshes use, once per path and only if the cache doesn't have it yet
+    // Cooked textures are never decoded, their compressed mips are uploaded as they are
+    void decodeTextures(AsyncFileReader* fileReader)
+    {
+        std::vector<std::string> texturePaths;
+        for (const MeshData& meshData : pendingMeshes)
+        {
+            for (const std::string& texturePath : meshData.texturePaths)
+            {
+                if (pendingTextures.find(texturePath) == pendingTextures.end() && !TextureCache::instance().contains(texturePath) &&
+                    !hasCookedTexture(cookedTexturePath(texturePath)) &&
+                    std::find(texturePaths.begin(), texturePaths.end(), texturePath) == texturePaths.end())
+                    texturePaths.push_back(texturePath);
+            }
+        }
+
+        if (requireCookedAssets)
+        {
+            for (const std::string& texturePath : texturePaths)
+                std::cout << "WARNING::MODEL:: " << texturePath << " isn't cooked, decoding the source" << std::endl;
+        }
+
+        std::vector<TextureImage> images(texturePaths.size());
+        if (fileReader)
+        {
+            fileReader->readBatch(texturePaths, [&images](size_t index, AssetBuffer& buffer)
+            {
+                if (buffer.ok)
+                    images[index] = decodeTextureMemory(buffer.data(), buffer.size(), buffer.path);
+                else
+                    std::cout << "Texture failed to load at path: " << buffer.path << std::endl;
+            })->wait();
+        }
+        else
+        {
+            for (size_t i = 0; i < texturePaths.size(); i++)
+                images[i] = decodeTexture(texturePaths[i].c_str());
+        }
+        for (size_t i = 0; i < texturePaths.size(); i++)
+            pendingTextures[texturePaths[i]] = images[i];
+    }
+
+    // Reference a texture through the cache, uploading the decoded image on a miss
+    unsigned int acquireTexture(const std::string& texturePath)
+    {
+        unsigned int textureID = TextureCache::instance().acquire(texturePath, [&](size_t& residentBytes)
+        {
+            unsigned int cookedTexture = loadCookedTexture(texturePath, residentBytes);
+            if (cookedTexture != 0)
+                return cookedTexture;
+
+            // Not decoded if it was resident during the CPU phase but has been released since
+            auto pending = pendingTextures.find(texturePath);
+            if (pending == pendingTextures.end())
+                pending = pendingTextures.emplace(texturePath, decodeTexture(texturePath.c_str())).first;
+
+            residentBytes = textureImageBytes(pending->second);
+            return uploadTexture(pending->second);
+        });
+        acquiredTextures.push_back(textureID);
+        return textureID;
+    }
+
+    // Reference a texture through the cache, on a miss its pixels are streamed in by the worker
+    unsigned int acquireTextureAsync(const std::string& texturePath, UploadWorker& worker, std::shared_ptr<ModelUploadSource> source)
+    {
+        bool queued = false;
+        unsigned int textureID = TextureCache::instance().acquire(texturePath, [&](size_t& residentBytes)
+        {
+            // Cooked mips are a fraction of the decoded size and need no mipmap generation, upload them in place
+            unsigned int cookedTexture = loadCookedTexture(texturePath, residentBytes);
+            if (cookedTexture != 0)
+                return cookedTexture;
+
+            auto pending = source->textures.find(texturePath);
+            if (pending == source->textures.end())
+                pending = source->textures.emplace(texturePath, decodeTexture(texturePath.c_str())).first;
+            const TextureImage& image = pending->second;
+
+            // Failed decodes still get an (empty) texture, like the synchronous path
+            GLuint newTexture;
+            glGenTextures(1, &newTexture);
+            if (image.data)
+            {
+                worker.queueTexture(newTexture, textureImageFormat(image), image.width, image.height, image.numChannels, image.data, source,
+                    [newTexture] { TextureCache::instance().markReady(newTexture); });
+                queued = true;
+            }
+
+            residentBytes = textureImageBytes(image);
+            return newTexture;
+        });
+        if (queued)
+            TextureCache::instance().setPending(textureID);
+
+        acquiredTextures.push_back(textureID);
+        return textureID;
     }
 
     // Processes a node recursively
@@ -97,19 +939,23 @@ private:
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
         {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            processMesh(mesh, scene, pendingMeshes.emplace_back());
         }
         // Recursively process children nodes
         for (unsigned int i = 0; i < node->mNumChildren; i++)
             processNode(node->mChildren[i], scene);
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    // Fill meshData in place, sized exactly up front so nothing reallocates
+    void processMesh(aiMesh* mesh, const aiScene* scene, MeshData& meshData)
     {
-        // Data to fill
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        std::vector<Vertex>& vertices = meshData.vertices;
+        std::vector<unsigned int>& indices = meshData.indices;
+        size_t indexCount = 0;
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+            indexCount += mesh->mFaces[i].mNumIndices;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(indexCount);
 
         // Loop through mesh's vertices
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -131,6 +977,8 @@ private:
                 vector.z = mesh->mNormals[i].z;
                 vertex.Normal = vector;
             }
+            else
+                vertex.Normal = glm::vec3(0.0f);
 
             // Texture (if it has)
             if (mesh->mTextureCoords[0])
@@ -150,7 +998,7 @@ private:
         // Loop through mesh's faces and retrieve the corresponding vertex indices
         for (unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];
 
             // Retrieve all indices of the face and store them in the indices vector
             for (unsigned int j = 0; j < face.mNumIndices; j++)
@@ -161,57 +1009,116 @@ private:
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         
         // Only using diffuse textures
-        std::vector<Texture> textureMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE);
-        textures.insert(textures.end(), textureMaps.begin(), textureMaps.end());
-
-        // Return a mesh object created from the extracted mesh data
-        Mesh tempMesh(vertices, indices, textures);
+        meshData.texturePaths = getMaterialTexturePaths(material, aiTextureType_DIFFUSE);
 
         // Set name if present
-        std::string meshName = std::string(mesh->mName.C_Str());
-        if (!meshName.empty())
-            tempMesh.meshName = meshName;
-
-        return tempMesh;
+        meshData.meshName = mesh->mName.C_Str();
     }
 
-    // Load materials
-    std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type)
+    // Texture paths of a material (decoded later, once per path)
+    std::vector<std::string> getMaterialTexturePaths(aiMaterial* mat, aiTextureType type)
     {
-        std::vector<Texture> textures;
+        std::vector<std::string> texturePaths;
         for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            Texture texture;
-            texture.id = loadTexture(str.C_Str());
-            texture.path = str.C_Str();
-            textures.push_back(texture);
+            texturePaths.push_back(str.C_Str());
         }
-        return textures;
+        return texturePaths;
     }
 };
 
+// Load a texture through the shared cache (release it with TextureCache::instance().release)
 unsigned int loadTexture(const char* texturePath)
+{
+    return TextureCache::instance().acquire(texturePath, [texturePath](size_t& residentBytes)
+    {
+        unsigned int cookedTexture = loadCookedTexture(texturePath, residentBytes);
+        if (cookedTexture != 0)
+            return cookedTexture;
+
+        stbi_set_flip_vertically_on_load(false);
+        TextureImage image = decodeTexture(texturePath);
+        unsigned int textureID = uploadTexture(image);
+        residentBytes = textureImageBytes(image);
+        freeTextureImage(image);
+
+        return textureID;
+    });
+}
+
+// Same, with the pixels streamed in by the worker: the texture is pending in the cache until they have arrived
+// Cooked textures still upload in place (their mips are a fraction of the decoded size and need no generation)
+unsigned int loadTexture(const char* texturePath, UploadWorker& worker)
+{
+    if (!worker.isRunning())
+        return loadTexture(texturePath);
+
+    bool queued = false;
+    unsigned int textureID = TextureCache::instance().acquire(texturePath, [&](size_t& residentBytes)
+    {
+        unsigned int cookedTexture = loadCookedTexture(texturePath, residentBytes);
+        if (cookedTexture != 0)
+            return cookedTexture;
+
+        // Freed once the worker's job is done with the pixels
+        std::shared_ptr<TextureImage> image(new TextureImage(decodeTexture(texturePath)), [](TextureImage* decoded)
+        {
+            freeTextureImage(*decoded);
+            delete decoded;
+        });
+
+        GLuint newTexture;
+        glGenTextures(1, &newTexture);
+        if (image->data)
+        {
+            worker.queueTexture(newTexture, textureImageFormat(*image), image->width, image->height, image->numChannels, image->data, image,
+                [newTexture] { TextureCache::instance().markReady(newTexture); });
+            queued = true;
+        }
+        residentBytes = textureImageBytes(*image);
+        return newTexture;
+    });
+    if (queued)
+        TextureCache::instance().setPending(textureID);
+    return textureID;
+}
+
+// Decode an image file from the asset pack or disk (thread safe, leaves stb's global vertical flip setting alone)
+TextureImage decodeTexture(const char* texturePath)
+{
+    AssetFile file(texturePath);
+    if (!file.isOpen())
+    {
+        std::cout << "Texture failed to load at path: " << texturePath << std::endl;
+        return TextureImage();
+    }
+    return decodeTextureMemory(file.data(), file.size(), texturePath);
+}
+
+// Decode an image held in memory, e.g. embedded in a GLB (thread safe like decodeTexture)
+TextureImage decodeTextureMemory(const unsigned char* data, size_t size, const std::string& name)
+{
+    TextureImage image;
+    image.data = stbi_load_from_memory(data, static_cast<int>(size), &image.width, &image.height, &image.numChannels, 0);
+    if (!image.data)
+        std::cout << "Texture failed to load at path: " << name << std::endl;
+
+    return image;
+}
+
+// Create a texture from a decoded image (a failed decode still gets a texture ID, like before)
+unsigned int uploadTexture(const TextureImage& image)
 {
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    stbi_set_flip_vertically_on_load(false);
-    int width, height, numChannels;
-    unsigned char* data = stbi_load(texturePath, &width, &height, &numChannels, 0);
-    if (data)
-    {
-        GLenum format = GL_RGB;
-        if (numChannels == 1)
-            format = GL_RED;
-        else if (numChannels == 3)
-            format = GL_RGB;
-        else if (numChannels == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    if (image.data)
+    {
+        GLenum format = textureImageFormat(image);
+        GLState::instance().bindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
         glGenerateMipmap(GL_TEXTURE_2D);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -219,11 +1126,34 @@ unsigned int loadTexture(const char* texturePath)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
-    else
-        std::cout << "Texture failed to load at path: " << texturePath << std::endl;
-
-    stbi_image_free(data);
 
     return textureID;
 }
+
+// GL pixel format matching an image's channel count
+GLenum textureImageFormat(const TextureImage& image)
+{
+    GLenum format = GL_RGB;
+    if (image.numChannels == 1)
+        format = GL_RED;
+    else if (image.numChannels == 3)
+        format = GL_RGB;
+    else if (image.numChannels == 4)
+        format = GL_RGBA;
+
+    return format;
+}
+
+// Approximate VRAM of an uploaded image, including its mip chain (about a third extra)
+size_t textureImageBytes(const TextureImage& image)
+{
+    size_t baseLevel = static_cast<size_t>(image.width) * image.height * image.numChannels;
+    return baseLevel + baseLevel / 3;
+}
+
+void freeTextureImage(TextureImage& image)
+{
+    stbi_image_free(image.data);
+    image.data = nullptr;
+}
 #endif // MY_MODEL_H
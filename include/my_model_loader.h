@@ -0,0 +1,116 @@
+#ifndef MY_MODEL_LOADER_H
+#define MY_MODEL_LOADER_H
+
+#include <my_async_io.h>
+#include <my_model.h>
+#include <my_thread_pool.h>
+#include <my_upload_worker.h>
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+// Loads models in parallel: the CPU phase (import, image decode) runs on a thread pool
+// and finished models queue up for their GL upload on the context thread
+// With an UploadWorker that upload is streamed in the background instead of done in place
+// With an AsyncFileReader each model's textures are read as one batch and decoded as they arrive
+class ModelLoader
+{
+public:
+    explicit ModelLoader(ThreadPool& pool, UploadWorker* uploadWorker = nullptr, AsyncFileReader* fileReader = nullptr)
+        : pool(pool)
+        , uploadWorker(uploadWorker)
+        , fileReader(fileReader)
+    {
+    }
+
+    // Start loading a model, which must stay alive until it has been uploaded
+    void load(Model& model, const std::string& path, bool useMeshCache = true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            outstanding++;
+        }
+
+        pool.submit([this, &model, path, useMeshCache]
+        {
+            try
+            {
+                model.loadModelData(path, useMeshCache, fileReader);
+            }
+            catch (const std::exception& e)
+            {
+                std::cout << "ERROR::MODEL_LOADER:: " << path << ": " << e.what() << std::endl;
+            }
+
+            // Queue for upload even on failure so finish() can't hang
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                readyModels.push_back(&model);
+            }
+            readyCondition.notify_one();
+        });
+    }
+
+    // Upload every model whose CPU phase has finished, returns how many were uploaded (GL thread only)
+    size_t uploadReady()
+    {
+        size_t uploaded = 0;
+        while (Model* model = popReady(false))
+        {
+            upload(*model);
+            uploaded++;
+        }
+        return uploaded;
+    }
+
+    // Block until every queued model is loaded, uploading each one as soon as it's ready (GL thread only)
+    // With an UploadWorker this only waits for the CPU phase, the data still arrives over the next frames
+    void finish()
+    {
+        while (Model* model = popReady(true))
+            upload(*model);
+    }
+
+    // True once nothing is being loaded or waiting for upload
+    bool idle()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return outstanding == 0;
+    }
+
+private:
+    ThreadPool& pool;
+    UploadWorker* uploadWorker;
+    AsyncFileReader* fileReader;
+    std::mutex mutex;
+    std::condition_variable readyCondition;
+    std::deque<Model*> readyModels;
+    size_t outstanding = 0;
+
+    void upload(Model& model)
+    {
+        if (uploadWorker)
+            model.uploadModelDataAsync(*uploadWorker);
+        else
+            model.uploadModelData();
+    }
+
+    // Next model ready for upload, optionally waiting while loads are still in flight
+    Model* popReady(bool wait)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wait)
+            readyCondition.wait(lock, [this] { return !readyModels.empty() || outstanding == 0; });
+        if (readyModels.empty())
+            return nullptr;
+
+        Model* model = readyModels.front();
+        readyModels.pop_front();
+        outstanding--;
+        return model;
+    }
+};
+#endif // MY_MODEL_LOADER_H
@@ -0,0 +1,49 @@
+#ifndef MY_MODEL_SETTINGS_H
+#define MY_MODEL_SETTINGS_H
+
+#include <my_model.h>
+
+#include <string>
+
+// 3D model name
+// "Spitfire Mk IXe" (https://skfb.ly/6txDP) 
+// by martinsifrar is licensed under 
+// Creative Commons Attribution (http://creativecommons.org/licenses/by/4.0/).
+#define PLANE_MODEL "models/spitfire.obj"
+#define CLOUD_MODEL "models/cloud.obj"
+
+// Load settings of the app's models that are baked into their mesh caches
+// Kept in one table so the asset cooker (see my_asset_cooker.h) builds exactly the caches the app asks for
+struct ModelSettings
+{
+    const char* path;
+    bool quantizeVertices;
+    bool nativeObjImport;
+    const char* importProfile;
+    bool shareInstancesAcrossTexCoords;
+    bool compressMeshCache;
+};
+
+const ModelSettings APP_MODEL_SETTINGS[] =
+{
+    { PLANE_MODEL, true, true, "lit_textured", false, true },  // wheel2 mirrors wheel1 but has its own UV island, so stays a mesh
+    { CLOUD_MODEL, true, true, "lit", false, true }
+};
+
+// Apply the settings listed for path, other models keep the Model defaults
+void applyModelSettings(Model& model, const std::string& path)
+{
+    std::string key = normalizeAssetPath(path);
+    for (const ModelSettings& settings : APP_MODEL_SETTINGS)
+    {
+        if (normalizeAssetPath(settings.path) != key)
+            continue;
+        model.quantizeVertices = settings.quantizeVertices;
+        model.nativeObjImport = settings.nativeObjImport;
+        model.importProfile = settings.importProfile;
+        model.shareInstancesAcrossTexCoords = settings.shareInstancesAcrossTexCoords;
+        model.compressMeshCache = settings.compressMeshCache;
+        return;
+    }
+}
+#endif // MY_MODEL_SETTINGS_H
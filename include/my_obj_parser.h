@@ -0,0 +1,490 @@
+#ifndef MY_OBJ_PARSER_H
+#define MY_OBJ_PARSER_H
+
+#include <my_asset_pack.h>
+#include <my_mesh.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Native OBJ/MTL reader, an alternative to Assimp for our Blender exports
+// The file is mapped, split into chunks at line boundaries and the chunks are parsed concurrently,
+// then merged into one MeshData per object/material pair with the same names and vertex conventions
+// Assimp gives us under the import profiles (triangulated, identical vertices joined, smooth normals
+// where missing, V flipped, attributes the shader doesn't read left out)
+
+// Chunks smaller than this aren't worth a thread
+const size_t OBJ_MIN_CHUNK_BYTES = 256 * 1024;
+
+// Corner component that the face didn't specify
+const int OBJ_NO_INDEX = INT_MIN;
+
+// Name Assimp gives faces that come before any "o" line
+const char* const OBJ_DEFAULT_OBJECT = "defaultobject";
+
+// One triangle corner, zero-based indices into the file's v/vt/vn lists
+struct ObjCorner
+{
+    int position;
+    int texCoord;
+    int normal;
+
+    bool operator==(const ObjCorner& o) const
+    {
+        return position == o.position && texCoord == o.texCoord && normal == o.normal;
+    }
+};
+
+struct ObjCornerHash
+{
+    size_t operator()(const ObjCorner& c) const
+    {
+        return (static_cast<size_t>(c.position) * 73856093u) ^ (static_cast<size_t>(c.texCoord) * 19349663u) ^ (static_cast<size_t>(c.normal) * 83492791u);
+    }
+};
+
+// A run of triangles in one chunk under the same "o" and "usemtl"
+// A chunk starting mid-object carries on with whatever the previous chunk ended on
+struct ObjGroup
+{
+    std::string objectName;
+    std::string material;
+    bool setsObject;
+    bool setsMaterial;
+    size_t firstCorner;
+};
+
+// Everything parsed out of one chunk, indices are still relative to the whole file
+struct ObjChunk
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<ObjCorner> corners;     // 3 per triangle
+    std::vector<ObjGroup> groups;
+    std::vector<std::string> materialLibraries;
+
+    // Corners that used negative (relative) indices, resolved against this chunk's counts only
+    // Bit 0/1/2 of the mask say which of position/texCoord/normal still need the chunk's base added
+    std::vector<std::pair<size_t, uint8_t>> relativeCorners;
+};
+
+const char* skipObjSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+// Rest of the line, without surrounding whitespace
+std::string readObjName(const char* p, const char* end)
+{
+    p = skipObjSpaces(p, end);
+    while (end > p && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+        end--;
+    return std::string(p, end);
+}
+
+// Whether the line at p starts with keyword followed by whitespace
+bool isObjKeyword(const char* p, const char* end, const char* keyword, size_t length)
+{
+    return static_cast<size_t>(end - p) > length && memcmp(p, keyword, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+}
+
+// Parse up to count floats, missing ones are left alone
+const char* parseObjFloats(const char* p, const char* end, float* values, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        p = skipObjSpaces(p, end);
+        if (p < end && *p == '+')
+            p++;
+        std::from_chars_result result = std::from_chars(p, end, values[i]);
+        if (result.ec != std::errc())
+            break;
+        p = result.ptr;
+    }
+    return p;
+}
+
+// Turn a 1-based (or negative, relative) OBJ index into a zero-based one, flagging relative ones
+int resolveObjIndex(int raw, size_t count, bool& relative)
+{
+    if (raw > 0)
+        return raw - 1;
+    if (raw < 0)
+    {
+        relative = true;
+        return static_cast<int>(count) + raw;
+    }
+    return OBJ_NO_INDEX;
+}
+
+// Parse one face line into fan-triangulated corners
+void parseObjFace(const char* p, const char* end, ObjChunk& chunk, std::vector<std::pair<ObjCorner, uint8_t>>& face)
+{
+    face.clear();
+    while (true)
+    {
+        p = skipObjSpaces(p, end);
+        int raw[3] = { 0, 0, 0 };
+        std::from_chars_result result = std::from_chars(p, end, raw[0]);
+        if (result.ec != std::errc())
+            break;
+        p = result.ptr;
+        for (int component = 1; component < 3 && p < end && *p == '/'; component++)
+        {
+            p++;
+            result = std::from_chars(p, end, raw[component]);
+            if (result.ec == std::errc())
+                p = result.ptr;
+        }
+
+        bool relative[3] = { false, false, false };
+        ObjCorner corner;
+        corner.position = resolveObjIndex(raw[0], chunk.positions.size(), relative[0]);
+        corner.texCoord = resolveObjIndex(raw[1], chunk.texCoords.size(), relative[1]);
+        corner.normal = resolveObjIndex(raw[2], chunk.normals.size(), relative[2]);
+        face.emplace_back(corner, static_cast<uint8_t>(relative[0] | relative[1] << 1 | relative[2] << 2));
+    }
+
+    for (size_t i = 1; i + 1 < face.size(); i++)
+    {
+        for (size_t corner : { size_t(0), i, i + 1 })
+        {
+            if (face[corner].second)
+                chunk.relativeCorners.emplace_back(chunk.corners.size(), face[corner].second);
+            chunk.corners.push_back(face[corner].first);
+        }
+    }
+}
+
+// Parse the lines in [begin, end), which starts at a line boundary
+void parseObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    chunk.groups.push_back({ std::string(), std::string(), false, false, 0 });
+    std::vector<std::pair<ObjCorner, uint8_t>> face;
+
+    const char* line = begin;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+        const char* p = skipObjSpaces(line, lineEnd);
+
+        if (isObjKeyword(p, lineEnd, "v", 1))
+        {
+            glm::vec3 position(0.0f);
+            parseObjFloats(p + 2, lineEnd, &position.x, 3);
+            chunk.positions.push_back(position);
+        }
+        else if (isObjKeyword(p, lineEnd, "vn", 2))
+        {
+            glm::vec3 normal(0.0f);
+            parseObjFloats(p + 3, lineEnd, &normal.x, 3);
+            chunk.normals.push_back(normal);
+        }
+        else if (isObjKeyword(p, lineEnd, "vt", 2))
+        {
+            glm::vec2 texCoord(0.0f);
+            parseObjFloats(p + 3, lineEnd, &texCoord.x, 2);
+            chunk.texCoords.push_back(texCoord);
+        }
+        else if (isObjKeyword(p, lineEnd, "f", 1))
+            parseObjFace(p + 2, lineEnd, chunk, face);
+        else if (isObjKeyword(p, lineEnd, "o", 1))
+        {
+            ObjGroup group = chunk.groups.back();
+            group.objectName = readObjName(p + 2, lineEnd);
+            group.setsObject = true;
+            group.firstCorner = chunk.corners.size();
+            chunk.groups.push_back(group);
+        }
+        else if (isObjKeyword(p, lineEnd, "usemtl", 6))
+        {
+            ObjGroup group = chunk.groups.back();
+            group.material = readObjName(p + 7, lineEnd);
+            group.setsMaterial = true;
+            group.firstCorner = chunk.corners.size();
+            chunk.groups.push_back(group);
+        }
+        else if (isObjKeyword(p, lineEnd, "mtllib", 6))
+            chunk.materialLibraries.push_back(readObjName(p + 7, lineEnd));
+
+        line = lineEnd + 1;
+    }
+}
+
+// Read the diffuse texture of every material in an MTL file (paths kept exactly as written, like Assimp)
+void parseMtlFile(const std::string& path, std::map<std::string, std::string>& diffuseTextures)
+{
+    AssetFile file(path);
+    if (!file.isOpen())
+    {
+        std::cout << "WARNING::OBJ_PARSER:: Could not open material library " << path << std::endl;
+        return;
+    }
+
+    const char* text = reinterpret_cast<const char*>(file.data());
+    const char* end = text + file.size();
+    std::string material;
+    const char* line = text;
+    while (line < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+        const char* p = skipObjSpaces(line, lineEnd);
+
+        if (isObjKeyword(p, lineEnd, "newmtl", 6))
+            material = readObjName(p + 7, lineEnd);
+        else if (isObjKeyword(p, lineEnd, "map_Kd", 6))
+            diffuseTextures[material] = readObjName(p + 7, lineEnd);
+        line = lineEnd + 1;
+    }
+}
+
+// Triangles of one output mesh, as corner ranges into the chunks
+struct ObjMeshSource
+{
+    std::string objectName;
+    std::string material;
+    std::vector<std::pair<const ObjCorner*, const ObjCorner*>> ranges;
+};
+
+// Build one mesh, joining corners that reference the same v/vt/vn triple
+// Attributes missing from attributes (VERTEX_ATTRIBUTE_*) are dropped first, so they can't keep vertices apart
+// Returns how many triangles were dropped for pointing outside the file's lists
+size_t buildObjMesh(const ObjMeshSource& source, const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+    const std::vector<glm::vec2>& texCoords, unsigned int attributes, MeshData& meshData)
+{
+    size_t cornerCount = 0;
+    for (const auto& range : source.ranges)
+        cornerCount += range.second - range.first;
+
+    std::unordered_map<ObjCorner, unsigned int, ObjCornerHash> vertexIds;
+    vertexIds.reserve(cornerCount);
+    meshData.indices.reserve(cornerCount);
+    std::vector<int> vertexPositions;
+    bool missingNormals = false;
+    size_t dropped = 0;
+
+    for (const auto& range : source.ranges)
+    {
+        for (const ObjCorner* triangle = range.first; triangle < range.second; triangle += 3)
+        {
+            bool valid = true;
+            for (int k = 0; k < 3; k++)
+            {
+                const ObjCorner& corner = triangle[k];
+                valid = valid && corner.position >= 0 && corner.position < static_cast<int>(positions.size()) &&
+                    (corner.texCoord == OBJ_NO_INDEX || (corner.texCoord >= 0 && corner.texCoord < static_cast<int>(texCoords.size()))) &&
+                    (corner.normal == OBJ_NO_INDEX || (corner.normal >= 0 && corner.normal < static_cast<int>(normals.size())));
+            }
+            if (!valid)
+            {
+                dropped++;
+                continue;
+            }
+
+            for (int k = 0; k < 3; k++)
+            {
+                ObjCorner corner = triangle[k];
+                if (!(attributes & VERTEX_ATTRIBUTE_NORMAL))
+                    corner.normal = OBJ_NO_INDEX;
+                if (!(attributes & VERTEX_ATTRIBUTE_TEXCOORD))
+                    corner.texCoord = OBJ_NO_INDEX;
+                auto inserted = vertexIds.emplace(corner, static_cast<unsigned int>(meshData.vertices.size()));
+                if (inserted.second)
+                {
+                    // Same conventions as the Assimp import: V flipped (aiProcess_FlipUVs)
+                    Vertex vertex;
+                    vertex.Position = positions[corner.position];
+                    vertex.Normal = corner.normal != OBJ_NO_INDEX ? normals[corner.normal] : glm::vec3(0.0f);
+                    vertex.TexCoords = corner.texCoord != OBJ_NO_INDEX ? glm::vec2(texCoords[corner.texCoord].x, 1.0f - texCoords[corner.texCoord].y) : glm::vec2(0.0f);
+                    meshData.vertices.push_back(vertex);
+                    vertexPositions.push_back(corner.position);
+                    missingNormals = missingNormals || (corner.normal == OBJ_NO_INDEX && (attributes & VERTEX_ATTRIBUTE_NORMAL));
+                }
+                meshData.indices.push_back(inserted.first->second);
+            }
+        }
+    }
+
+    // Area weighted smooth normals for vertices the file gave none (aiProcess_GenSmoothNormals)
+    if (missingNormals)
+    {
+        std::unordered_map<int, glm::vec3> positionNormals;
+        for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3)
+        {
+            const unsigned int* triangle = &meshData.indices[i];
+            glm::vec3 p0 = meshData.vertices[triangle[0]].Position;
+            glm::vec3 faceNormal = glm::cross(meshData.vertices[triangle[1]].Position - p0, meshData.vertices[triangle[2]].Position - p0);
+            for (int k = 0; k < 3; k++)
+                positionNormals[vertexPositions[triangle[k]]] += faceNormal;
+        }
+        for (size_t v = 0; v < meshData.vertices.size(); v++)
+        {
+            glm::vec3 normal = positionNormals[vertexPositions[v]];
+            if (meshData.vertices[v].Normal == glm::vec3(0.0f) && glm::length(normal) > 0.0f)
+                meshData.vertices[v].Normal = glm::normalize(normal);
+        }
+    }
+
+    meshData.meshName = source.objectName;
+    return dropped;
+}
+
+// Parse an OBJ and the material libraries it references into one MeshData per object/material pair,
+// in file order. threadCount 0 uses every hardware thread, attributes are the VERTEX_ATTRIBUTE_* to keep
+// Returns false if the file can't be read
+bool parseObjFile(const std::string& path, std::vector<MeshData>& meshes, unsigned int threadCount = 0,
+    unsigned int attributes = VERTEX_ATTRIBUTE_NORMAL | VERTEX_ATTRIBUTE_TEXCOORD)
+{
+    AssetFile file(path);
+    if (!file.isOpen())
+    {
+        std::cout << "ERROR::OBJ_PARSER:: Could not open " << path << std::endl;
+        return false;
+    }
+    const char* text = reinterpret_cast<const char*>(file.data());
+    size_t size = file.size();
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, size / OBJ_MIN_CHUNK_BYTES));
+
+    // Chunk boundaries snapped forward to the next line start
+    std::vector<const char*> boundaries(chunkCount + 1);
+    boundaries[0] = text;
+    boundaries[chunkCount] = text + size;
+    for (size_t i = 1; i < chunkCount; i++)
+    {
+        const char* target = std::max(text + size * i / chunkCount, boundaries[i - 1]);
+        const char* newline = static_cast<const char*>(memchr(target, '\n', text + size - target));
+        boundaries[i] = newline ? newline + 1 : text + size;
+    }
+
+    // Parse every chunk, the first one on this thread
+    std::vector<ObjChunk> chunks(chunkCount);
+    std::vector<std::future<void>> parses;
+    for (size_t i = 1; i < chunkCount; i++)
+        parses.push_back(std::async(std::launch::async, [&chunks, &boundaries, i] { parseObjChunk(boundaries[i], boundaries[i + 1], chunks[i]); }));
+    parseObjChunk(boundaries[0], boundaries[1], chunks[0]);
+    for (std::future<void>& parse : parses)
+        parse.get();
+
+    // Concatenate the attribute lists and rebase relative indices
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    size_t positionCount = 0, normalCount = 0, texCoordCount = 0;
+    for (const ObjChunk& chunk : chunks)
+    {
+        positionCount += chunk.positions.size();
+        normalCount += chunk.normals.size();
+        texCoordCount += chunk.texCoords.size();
+    }
+    positions.reserve(positionCount);
+    normals.reserve(normalCount);
+    texCoords.reserve(texCoordCount);
+    for (ObjChunk& chunk : chunks)
+    {
+        for (const auto& relative : chunk.relativeCorners)
+        {
+            ObjCorner& corner = chunk.corners[relative.first];
+            if (relative.second & 1)
+                corner.position += static_cast<int>(positions.size());
+            if (relative.second & 2)
+                corner.texCoord += static_cast<int>(texCoords.size());
+            if (relative.second & 4)
+                corner.normal += static_cast<int>(normals.size());
+        }
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec3>().swap(chunk.normals);
+        std::vector<glm::vec2>().swap(chunk.texCoords);
+    }
+
+    // Gather each object/material pair's triangles across chunks, in order of first appearance
+    std::vector<ObjMeshSource> sources;
+    std::map<std::pair<std::string, std::string>, size_t> sourceIds;
+    std::string objectName = OBJ_DEFAULT_OBJECT;
+    std::string material;
+    std::map<std::string, std::string> diffuseTextures;
+    std::string directory;
+    size_t slash = path.find_last_of("/\\");
+    if (slash != std::string::npos)
+        directory = path.substr(0, slash + 1);
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        for (const std::string& library : chunk.materialLibraries)
+            parseMtlFile(directory + library, diffuseTextures);
+
+        for (size_t g = 0; g < chunk.groups.size(); g++)
+        {
+            const ObjGroup& group = chunk.groups[g];
+            if (group.setsObject)
+                objectName = group.objectName;
+            if (group.setsMaterial)
+                material = group.material;
+
+            size_t lastCorner = g + 1 < chunk.groups.size() ? chunk.groups[g + 1].firstCorner : chunk.corners.size();
+            if (lastCorner == group.firstCorner)
+                continue;
+
+            auto id = sourceIds.emplace(std::make_pair(objectName, material), sources.size());
+            if (id.second)
+                sources.push_back({ objectName, material, {} });
+            sources[id.first->second].ranges.emplace_back(chunk.corners.data() + group.firstCorner, chunk.corners.data() + lastCorner);
+        }
+    }
+
+    // Build the meshes concurrently, handing them out one at a time
+    std::vector<MeshData> built(sources.size());
+    std::atomic<size_t> nextSource(0);
+    std::atomic<size_t> dropped(0);
+    auto buildMeshes = [&]()
+    {
+        for (size_t i = nextSource++; i < sources.size(); i = nextSource++)
+            dropped += buildObjMesh(sources[i], positions, normals, texCoords, attributes, built[i]);
+    };
+    std::vector<std::future<void>> builds;
+    for (size_t i = 1; i < std::min<size_t>(threadCount, sources.size()); i++)
+        builds.push_back(std::async(std::launch::async, buildMeshes));
+    buildMeshes();
+    for (std::future<void>& build : builds)
+        build.get();
+
+    if (dropped > 0)
+        std::cout << "WARNING::OBJ_PARSER:: " << path << " has " << dropped << " faces with out of range indices, skipped" << std::endl;
+
+    meshes.reserve(meshes.size() + built.size());
+    for (size_t i = 0; i < built.size(); i++)
+    {
+        auto texture = diffuseTextures.find(sources[i].material);
+        if (texture != diffuseTextures.end() && !texture->second.empty())
+            built[i].texturePaths.push_back(texture->second);
+        meshes.push_back(std::move(built[i]));
+    }
+    return true;
+}
+#endif // MY_OBJ_PARSER_H
@@ -4,148 +4,344 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <my_asset_pack.h>
+#include <my_async_io.h>
+#include <my_gl_state.h>
+
+#include <algorithm>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <string_view>
 #include <iostream>
+#include <utility>
+#include <vector>
+
+// Per-frame count of the uniform work the location cache saves (see Shader::endFrame)
+struct UniformStats
+{
+    size_t lookupsAvoided = 0;      // Uniforms set without a glGetUniformLocation call (every set used to make one)
+    size_t nameSearches = 0;        // Of those, set by name and so still searched for in the location table
+};
+
+// Samplers textureDiffuse0, textureDiffuse1, ... whose locations are resolved at link time (one per tracked unit)
+const unsigned int SHADER_DIFFUSE_SAMPLERS = 16;
+
+// Locations of the uniforms Mesh, MeshBatch and Model set on every draw, resolved once at link time
+// -1 for the ones a program doesn't use, which glUniform* ignores
+struct DrawUniforms
+{
+    GLint model = -1;
+    GLint quantized = -1;
+    GLint positionOffset = -1;
+    GLint positionScale = -1;
+    GLint texCoordOffset = -1;
+    GLint texCoordScale = -1;
+    GLint instanced = -1;
+    GLint merged = -1;
+    GLint textureDiffuse[SHADER_DIFFUSE_SAMPLERS];
+};
+
+// Sampler names "textureDiffuse0", "textureDiffuse1", ... built once, for resolving their locations
+const std::string& textureDiffuseName(unsigned int unit)
+{
+    static std::vector<std::string> names;
+    while (names.size() <= unit)
+        names.push_back("textureDiffuse" + std::to_string(names.size()));
+    return names[unit];
+}
 
 class Shader
 {
 public:
     unsigned int ID;
 
+    // Per-draw uniforms, set through these handles rather than by name
+    DrawUniforms drawUniforms;
+
     Shader(const char* vertexPath, const char* fragmentPath)
     {
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
+        // Sources are handed to GL straight from the asset pack (or the mapped loose file), with explicit lengths
+        AssetFile vertexFile(vertexPath);
+        AssetFile fragmentFile(fragmentPath);
+        if (!vertexFile.isOpen() || !fragmentFile.isOpen())
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << (vertexFile.isOpen() ? fragmentPath : vertexPath) << std::endl;
+        compile(reinterpret_cast<const char*>(vertexFile.data()), vertexFile.size(), reinterpret_cast<const char*>(fragmentFile.data()), fragmentFile.size());
+    }
 
-        // Ensure ifstream objects can throw exceptions
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // Open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-
-            // Read file's buffer contents into streams
-            std::stringstream vShaderStream, fShaderStream;
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-
-            // Close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-
-            // Convert stream to string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch (std::ifstream::failure& e)
+    // From sources read ahead of time, e.g. in a batch through AsyncFileReader
+    Shader(const AssetBuffer& vertexSource, const AssetBuffer& fragmentSource)
+    {
+        if (!vertexSource.ok || !fragmentSource.ok)
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << (vertexSource.ok ? fragmentSource.path : vertexSource.path) << std::endl;
+        compile(reinterpret_cast<const char*>(vertexSource.data()), vertexSource.size(), reinterpret_cast<const char*>(fragmentSource.data()), fragmentSource.size());
+    }
+
+    // Activates the shader (a no-op if it's already in use)
+    void use()
+    {
+        GLState::instance().useProgram(ID);
+    }
+
+    // Location of an active uniform from the table built at link time, -1 (ignored by glUniform*) if there's none
+    // Resolve once and keep the handle for the location setters below, or let the name setters look it up
+    GLint uniformLocation(std::string_view name) const
+    {
+        auto uniform = std::lower_bound(uniformLocations.begin(), uniformLocations.end(), name, [](const std::pair<std::string, GLint>& entry, std::string_view target)
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-        }
+            return entry.first < target;
+        });
+        return uniform != uniformLocations.end() && uniform->first == name ? uniform->second : -1;
+    }
 
-        // Convert string to C-string
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
+    // Location of the textureDiffuse sampler for a texture unit
+    GLint textureDiffuseLocation(unsigned int unit) const
+    {
+        return unit < SHADER_DIFFUSE_SAMPLERS ? drawUniforms.textureDiffuse[unit] : uniformLocation(textureDiffuseName(unit));
+    }
 
-        // Compile shaders
-        unsigned int vertex, fragment;
+    // Read a uniform block from the buffer bound at binding (e.g. FrameData, see my_frame_uniforms.h)
+    // Programs that don't declare the block are left alone
+    void bindUniformBlock(const char* blockName, GLuint binding) const
+    {
+        GLuint blockIndex = glGetUniformBlockIndex(ID, blockName);
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, blockIndex, binding);
+    }
 
-        // Vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "Vertex");
+    // Uniform counters of the frame in progress and of the last one (see endFrame)
+    static UniformStats& frameStats()
+    {
+        static UniformStats stats;
+        return stats;
+    }
 
-        // Fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "Fragment");
+    static UniformStats& lastFrameStats()
+    {
+        static UniformStats stats;
+        return stats;
+    }
 
-        // Shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "Program");
+    // Close the frame's uniform counters, once per frame after the last draw
+    static void endFrame()
+    {
+        lastFrameStats() = frameStats();
+        frameStats() = UniformStats();
+    }
 
-        // Delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    // Uniform functions, by name (cached lookup, no GL query and no string built) or by location
+    void setBool(std::string_view name, bool value) const
+    {
+        setBool(cachedLocation(name), value);
     }
 
-    // Activates the shader
-    void use()
+    void setBool(GLint location, bool value) const
     {
-        glUseProgram(ID);
+        countSet();
+        glUniform1i(location, (int)value);
     }
 
-    // Uniform functions
-    void setBool(const std::string& name, bool value) const
+    void setInt(std::string_view name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setInt(cachedLocation(name), value);
     }
 
-    void setInt(const std::string& name, int value) const
+    void setInt(GLint location, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        countSet();
+        glUniform1i(location, value);
     }
 
-    void setFloat(const std::string& name, float value) const
+    void setFloat(std::string_view name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        setFloat(cachedLocation(name), value);
     }
 
-    void setVec2(const std::string& name, const glm::vec2& value) const
+    void setFloat(GLint location, float value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        countSet();
+        glUniform1f(location, value);
     }
 
-    void setVec2(const std::string& name, float x, float y) const
+    void setVec2(std::string_view name, const glm::vec2& value) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        setVec2(cachedLocation(name), value);
     }
 
-    void setVec3(const std::string& name, const glm::vec3& value) const
+    void setVec2(GLint location, const glm::vec2& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        countSet();
+        glUniform2fv(location, 1, &value[0]);
     }
 
-    void setVec3(const std::string& name, float x, float y, float z) const
+    void setVec2(std::string_view name, float x, float y) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        setVec2(cachedLocation(name), glm::vec2(x, y));
     }
 
-    void setVec4(const std::string& name, const glm::vec4& value) const
+    void setVec3(std::string_view name, const glm::vec3& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec3(cachedLocation(name), value);
     }
-    void setVec4(const std::string& name, float x, float y, float z, float w)
+
+    void setVec3(GLint location, const glm::vec3& value) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        countSet();
+        glUniform3fv(location, 1, &value[0]);
     }
 
-    void setMat2(const std::string& name, const glm::mat2& mat) const
+    void setVec3(std::string_view name, float x, float y, float z) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setVec3(cachedLocation(name), glm::vec3(x, y, z));
     }
 
-    void setMat3(const std::string& name, const glm::mat3& mat) const
+    void setVec4(std::string_view name, const glm::vec4& value) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setVec4(cachedLocation(name), value);
     }
 
-    void setMat4(const std::string& name, const glm::mat4& mat) const
+    void setVec4(GLint location, const glm::vec4& value) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        countSet();
+        glUniform4fv(location, 1, &value[0]);
+    }
+
+    void setVec4(std::string_view name, float x, float y, float z, float w) const
+    {
+        setVec4(cachedLocation(name), glm::vec4(x, y, z, w));
+    }
+
+    void setMat2(std::string_view name, const glm::mat2& mat) const
+    {
+        countSet();
+        glUniformMatrix2fv(cachedLocation(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+    void setMat3(std::string_view name, const glm::mat3& mat) const
+    {
+        countSet();
+        glUniformMatrix3fv(cachedLocation(name), 1, GL_FALSE, &mat[0][0]);
+    }
+
+    void setMat4(std::string_view name, const glm::mat4& mat) const
+    {
+        setMat4(cachedLocation(name), mat);
+    }
+
+    void setMat4(GLint location, const glm::mat4& mat) const
+    {
+        countSet();
+        glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // Active uniforms by name, sorted (arrays under their bare name and every "name[i]")
+    std::vector<std::pair<std::string, GLint>> uniformLocations;
+
+    // Every set replaces the glGetUniformLocation call the setters used to make
+    static void countSet()
+    {
+        frameStats().lookupsAvoided++;
+    }
+
+    // A name setter's table search
+    GLint cachedLocation(std::string_view name) const
+    {
+        frameStats().nameSearches++;
+        return uniformLocation(name);
+    }
+
+    // Handles of the per-draw uniforms, from the sorted table
+    void resolveDrawUniforms()
+    {
+        drawUniforms.model = uniformLocation("model");
+        drawUniforms.quantized = uniformLocation("quantized");
+        drawUniforms.positionOffset = uniformLocation("positionOffset");
+        drawUniforms.positionScale = uniformLocation("positionScale");
+        drawUniforms.texCoordOffset = uniformLocation("texCoordOffset");
+        drawUniforms.texCoordScale = uniformLocation("texCoordScale");
+        drawUniforms.instanced = uniformLocation("instanced");
+        drawUniforms.merged = uniformLocation("merged");
+        for (unsigned int unit = 0; unit < SHADER_DIFFUSE_SAMPLERS; unit++)
+            drawUniforms.textureDiffuse[unit] = uniformLocation(textureDiffuseName(unit));
+    }
+
+    // Enumerate the linked program's uniforms once, block members have no location and are skipped
+    void cacheUniformLocations()
+    {
+        uniformLocations.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(static_cast<size_t>(maxLength) + 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), static_cast<size_t>(length));
+
+            size_t arraySuffix = name.size() > 3 ? name.size() - 3 : std::string::npos;
+            if (arraySuffix != std::string::npos && name.compare(arraySuffix, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, arraySuffix);
+                for (GLint element = 0; element < size; element++)
+                    addUniformLocation(base + "[" + std::to_string(element) + "]");
+                GLint first = glGetUniformLocation(ID, name.c_str());
+                if (first != -1)
+                    uniformLocations.push_back({ base, first });
+            }
+            else
+                addUniformLocation(name);
+        }
+        std::sort(uniformLocations.begin(), uniformLocations.end());
+        resolveDrawUniforms();
+    }
+
+    void addUniformLocation(const std::string& name)
+    {
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location != -1)
+            uniformLocations.push_back({ name, location });
+    }
+
+    // Build the program from vertex and fragment source text (missing sources compile as empty and fail to link)
+    void compile(const char* vShaderCode, size_t vShaderSize, const char* fShaderCode, size_t fShaderSize)
+    {
+        if (!vShaderCode)
+            vShaderCode = "";
+        if (!fShaderCode)
+            fShaderCode = "";
+        GLint vShaderLength = static_cast<GLint>(vShaderSize);
+        GLint fShaderLength = static_cast<GLint>(fShaderSize);
+
+        // Compile shaders
+        unsigned int vertex, fragment;
+
+        // Vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "Vertex");
+
+        // Fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "Fragment");
+
+        // Shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "Program");
+        cacheUniformLocations();
+
+        // Delete the shaders as they're linked into our program now and no longer necessary
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+    }
+
     // Checks shader compilation/linking errors
     void checkCompileErrors(GLuint shader, std::string type)
     {
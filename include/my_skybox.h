@@ -6,26 +6,228 @@
 
 #include <stb_image.h>
 
+#include <my_asset_pack.h>
+#include <my_async_io.h>
+#include <my_gl_state.h>
+#include <my_ktx_texture.h>
+#include <my_texture_cache.h>
+#include <my_upload_worker.h>
+
+#include <future>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
-// Function to load cubemap textures
+// Decoded cubemap faces (+x, -x, +y, -y, +z, -z), can be prepared off the render thread
+struct CubemapFaces
+{
+    struct Face
+    {
+        int width = 0;
+        int height = 0;
+        int numChannels = 0;
+        unsigned char* data = nullptr;
+    };
+
+    std::vector<std::string> paths;
+    std::vector<Face> faces;
+
+    // Cooked cubemap to upload instead, faces are left empty when set
+    std::string cookedPath;
+
+    CubemapFaces() {}
+
+    ~CubemapFaces()
+    {
+        for (Face& face : faces)
+            stbi_image_free(face.data);
+    }
+
+    // Owns the pixel data, so only allow moves
+    CubemapFaces(const CubemapFaces&) = delete;
+    CubemapFaces& operator=(const CubemapFaces&) = delete;
+
+    CubemapFaces(CubemapFaces&& other) noexcept
+        : paths(std::move(other.paths))
+        , faces(std::move(other.faces))
+        , cookedPath(std::move(other.cookedPath))
+    {
+        other.faces.clear();
+    }
+
+    CubemapFaces& operator=(CubemapFaces&& other) noexcept
+    {
+        std::swap(paths, other.paths);
+        std::swap(faces, other.faces);
+        std::swap(cookedPath, other.cookedPath);
+        return *this;
+    }
+};
+
+// Face files of a skybox directory in cubemap order (+x, -x, +y, -y, +z, -z), shared with tools/asset_cooker.cpp
+std::vector<std::string> skyboxFacePaths(const std::string& directory, const std::string& extension = ".png")
+{
+    static const char* names[6] = { "right", "left", "top", "bottom", "front", "back" };
+    std::vector<std::string> faces;
+    for (const char* name : names)
+        faces.push_back(directory + "/" + name + extension);
+    return faces;
+}
+
+// Forward declare
+GLuint createCubemap(const CubemapFaces& decodedFaces, size_t& residentBytes);
+
+// Decode all faces concurrently from the asset pack or disk, no GL calls so it can itself run on a worker thread
+// With useCooked nothing is decoded when a cooked cubemap exists next to the faces
+CubemapFaces decodeCubemapFaces(const std::vector<std::string>& faces, bool useCooked = true)
+{
+    CubemapFaces decodedFaces;
+    decodedFaces.paths = faces;
+    if (useCooked && hasCookedTexture(cookedCubemapPath(faces)))
+    {
+        decodedFaces.cookedPath = cookedCubemapPath(faces);
+        return decodedFaces;
+    }
+    decodedFaces.faces.resize(faces.size());
+
+    std::vector<std::future<void>> decodes;
+    for (size_t i = 0; i < faces.size(); i++)
+    {
+        decodes.push_back(std::async(std::launch::async, [&decodedFaces, &faces, i]
+        {
+            CubemapFaces::Face& face = decodedFaces.faces[i];
+            AssetFile file(faces[i]);
+            if (file.isOpen())
+                face.data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &face.width, &face.height, &face.numChannels, 0);
+        }));
+    }
+    for (std::future<void>& decode : decodes)
+        decode.get();
+
+    return decodedFaces;
+}
+
+// Same, with the six reads submitted together and each face decoded on the reader's threads as it arrives
+// Nothing blocks while they're in flight, the future is ready once the last face is decoded
+std::future<CubemapFaces> decodeCubemapFacesAsync(AsyncFileReader& fileReader, const std::vector<std::string>& faces, bool useCooked = true)
+{
+    std::shared_ptr<CubemapFaces> decodedFaces = std::make_shared<CubemapFaces>();
+    std::shared_ptr<std::promise<CubemapFaces>> result = std::make_shared<std::promise<CubemapFaces>>();
+    decodedFaces->paths = faces;
+    if (useCooked && hasCookedTexture(cookedCubemapPath(faces)))
+    {
+        decodedFaces->cookedPath = cookedCubemapPath(faces);
+        result->set_value(std::move(*decodedFaces));
+        return result->get_future();
+    }
+    decodedFaces->faces.resize(faces.size());
+
+    std::future<CubemapFaces> future = result->get_future();
+    fileReader.readBatch(faces, [decodedFaces](size_t index, AssetBuffer& buffer)
+    {
+        CubemapFaces::Face& face = decodedFaces->faces[index];
+        if (buffer.ok)
+            face.data = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &face.width, &face.height, &face.numChannels, 0);
+    },
+    [decodedFaces, result]
+    {
+        result->set_value(std::move(*decodedFaces));
+    });
+    return future;
+}
+
+// Function to load cubemap textures, shared through the texture cache
 GLuint loadCubemap(std::vector<std::string> faces)
 {
+    return TextureCache::instance().acquireCubemap(faces, [&faces](size_t& residentBytes)
+    {
+        return createCubemap(decodeCubemapFaces(faces), residentBytes);
+    });
+}
+
+// Load a cubemap from faces decoded earlier, e.g. a skybox swap prepared off-thread and committed in one frame
+GLuint loadCubemap(const CubemapFaces& decodedFaces)
+{
+    return TextureCache::instance().acquireCubemap(decodedFaces.paths, [&decodedFaces](size_t& residentBytes)
+    {
+        return createCubemap(decodedFaces, residentBytes);
+    });
+}
+
+// Same, with the faces streamed in by the worker: the texture is pending in the cache until the last one has arrived
+// Cooked cubemaps still upload in place, like cooked model textures (their mips are a fraction of the decoded size)
+GLuint loadCubemap(CubemapFaces&& decodedFaces, UploadWorker& worker)
+{
+    if (!worker.isRunning() || !decodedFaces.cookedPath.empty())
+        return loadCubemap(decodedFaces);
+
+    std::shared_ptr<CubemapFaces> source = std::make_shared<CubemapFaces>(std::move(decodedFaces));
+    bool queued = false;
+    GLuint textureID = TextureCache::instance().acquireCubemap(source->paths, [&](size_t& residentBytes)
+    {
+        residentBytes = 0;
+        GLuint newTexture;
+        glGenTextures(1, &newTexture);
+
+        // Faces complete in order, the last one queued marks the cubemap ready
+        size_t lastFace = source->faces.size();
+        for (size_t i = 0; i < source->faces.size(); i++)
+        {
+            if (source->faces[i].data)
+                lastFace = i;
+            else
+                std::cerr << "Failed to load cubemap texture at " << source->paths[i] << std::endl;
+        }
+        for (size_t i = 0; i < source->faces.size(); i++)
+        {
+            const CubemapFaces::Face& face = source->faces[i];
+            if (!face.data)
+                continue;
+            GLenum format = face.numChannels == 4 ? GL_RGBA : GL_RGB;
+            UploadWorker::Callback onReady;
+            if (i == lastFace)
+                onReady = [newTexture] { TextureCache::instance().markReady(newTexture); };
+            worker.queueCubemapFace(newTexture, static_cast<unsigned int>(i), GL_RGB, format, face.width, face.height, face.numChannels,
+                face.data, source, onReady);
+            residentBytes += static_cast<size_t>(face.width) * face.height * 3;
+            queued = true;
+        }
+        return newTexture;
+    });
+    if (queued)
+        TextureCache::instance().setPending(textureID);
+    return textureID;
+}
+
+// Upload the six decoded faces (only the uploads are serialized), or the cooked cubemap with its mips
+GLuint createCubemap(const CubemapFaces& decodedFaces, size_t& residentBytes)
+{
+    if (!decodedFaces.cookedPath.empty())
+    {
+        GLuint cookedTexture = loadKtxTexture(decodedFaces.cookedPath, residentBytes);
+        if (cookedTexture != 0)
+            return cookedTexture;
+
+        // Unreadable cooked file, fall back to the source faces
+        return createCubemap(decodeCubemapFaces(decodedFaces.paths, false), residentBytes);
+    }
+
+    residentBytes = 0;
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (GLuint i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
+    GLState::instance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+    for (GLuint i = 0; i < decodedFaces.faces.size(); i++) {
+        const CubemapFaces::Face& face = decodedFaces.faces[i];
+        if (face.data) {
+            GLenum format = face.numChannels == 4 ? GL_RGBA : GL_RGB;
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, face.width, face.height, 0, format, GL_UNSIGNED_BYTE, face.data);
+            residentBytes += static_cast<size_t>(face.width) * face.height * 3;
         }
         else {
-            std::cerr << "Failed to load cubemap texture at " << faces[i] << std::endl;
-            stbi_image_free(data);
+            std::cerr << "Failed to load cubemap texture at " << decodedFaces.paths[i] << std::endl;
         }
     }
 
@@ -91,12 +293,12 @@ GLuint setupSkyboxVAO()
     GLuint skyboxVAO, skyboxVBO;
     glGenVertexArrays(1, &skyboxVAO);
     glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
+    GLState::instance().bindVertexArray(skyboxVAO);
     glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glBindVertexArray(0);
+    GLState::instance().bindVertexArray(0);
     return skyboxVAO;
 }
 
@@ -0,0 +1,186 @@
+#ifndef MY_TEXTURE_CACHE_H
+#define MY_TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <my_gl_state.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide, reference-counted texture cache keyed by normalized path
+// Any loader can use it: on a miss it calls back to create the GL texture, on a hit it hands out the resident one
+class TextureCache
+{
+public:
+    struct Stats
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t residentTextures = 0;
+        size_t residentBytes = 0;
+        bool ready = true;
+    };
+
+    // Creates the GL texture on a miss and reports its approximate size in VRAM
+    typedef std::function<unsigned int(size_t& residentBytes)> Loader;
+
+    static TextureCache& instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // Same file, same key: absolute, "." and ".." folded, forward slashes (case-insensitive on Windows)
+    static std::string normalizePath(const std::string& path)
+    {
+        std::error_code error;
+        std::filesystem::path absolutePath = std::filesystem::absolute(path, error);
+        std::string key = (error ? std::filesystem::path(path) : absolutePath).lexically_normal().generic_string();
+#ifdef _WIN32
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+        return key;
+    }
+
+    // Take a reference to the texture at path, calling loader if it isn't resident (GL thread only)
+    unsigned int acquire(const std::string& path, const Loader& loader)
+    {
+        return acquireKey(normalizePath(path), loader);
+    }
+
+    // Same for a cubemap, keyed by all of its faces in order
+    unsigned int acquireCubemap(const std::vector<std::string>& faces, const Loader& loader)
+    {
+        std::string key = "cubemap";
+        for (const std::string& face : faces)
+            key += "|" + normalizePath(face);
+        return acquireKey(key, loader);
+    }
+
+    // Drop a reference, the texture is deleted with the last one (GL thread only)
+    void release(unsigned int textureID)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto key = textureKeys.find(textureID);
+        if (key == textureKeys.end())
+            return;
+
+        auto entry = entries.find(key->second);
+        if (--entry->second.references > 0)
+            return;
+
+        // Textures die with the context, so only delete while one is current
+        if (glfwGetCurrentContext())
+        {
+            glDeleteTextures(1, &textureID);
+            GLState::instance().forgetTexture(textureID);
+        }
+        counters.residentTextures--;
+        counters.residentBytes -= entry->second.residentBytes;
+        entries.erase(entry);
+        textureKeys.erase(key);
+    }
+
+    // Mark a texture whose data is still streaming in (e.g. through an UploadWorker), then ready once it has
+    void setPending(unsigned int textureID)
+    {
+        setReady(textureID, false);
+    }
+
+    void markReady(unsigned int textureID)
+    {
+        setReady(textureID, true);
+    }
+
+    // Whether a texture's data has fully arrived, unknown textures count as ready
+    bool isReady(unsigned int textureID)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto key = textureKeys.find(textureID);
+        return key == textureKeys.end() || entries[key->second].ready;
+    }
+
+    // Whether path is already resident, lets decode stages on worker threads skip work (thread safe)
+    bool contains(const std::string& path)
+    {
+        std::string normalizedKey = normalizePath(path);
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.find(normalizedKey) != entries.end();
+    }
+
+    Stats stats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counters;
+    }
+
+    void printStats()
+    {
+        Stats current = stats();
+        std::cout << "Texture cache: " << current.hits << " hits, " << current.misses << " misses, "
+            << current.residentTextures << " textures, " << current.residentBytes / 1024 << " KB resident" << std::endl;
+    }
+
+private:
+    struct Entry
+    {
+        unsigned int textureID = 0;
+        size_t references = 0;
+        size_t residentBytes = 0;
+        bool ready = true;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_map<unsigned int, std::string> textureKeys;
+    Stats counters;
+
+    TextureCache() {}
+
+    void setReady(unsigned int textureID, bool ready)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto key = textureKeys.find(textureID);
+        if (key != textureKeys.end())
+            entries[key->second].ready = ready;
+    }
+
+    // Shared lookup/insert behind acquire and acquireCubemap
+    unsigned int acquireKey(const std::string& normalizedKey, const Loader& loader)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = entries.find(normalizedKey);
+            if (entry != entries.end())
+            {
+                entry->second.references++;
+                counters.hits++;
+                return entry->second.textureID;
+            }
+            counters.misses++;
+        }
+
+        // Load outside the lock so worker threads querying contains() don't wait on the upload
+        Entry entry;
+        entry.textureID = loader(entry.residentBytes);
+        entry.references = 1;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[normalizedKey] = entry;
+        textureKeys[entry.textureID] = normalizedKey;
+        counters.residentTextures++;
+        counters.residentBytes += entry.residentBytes;
+        return entry.textureID;
+    }
+};
+#endif // MY_TEXTURE_CACHE_H
@@ -0,0 +1,616 @@
+#ifndef MY_TEXTURE_CODEC_H
+#define MY_TEXTURE_CODEC_H
+
+// Texture cooking on the CPU: mip chain generation, BC1/BC3 (DXT1/DXT5) block compression and
+// a KTX 1.1 container. No GL in here, the cooker and any checks run without a GPU
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GL enums as stored in the KTX header (S3TC isn't core, so glad doesn't define them)
+const uint32_t KTX_COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+const uint32_t KTX_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+const uint32_t KTX_RGB = 0x1907;
+const uint32_t KTX_RGBA = 0x1908;
+const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// One level of a mip chain, RGBA8 pixels or compressed blocks
+struct MipLevel
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> data;
+};
+
+// Parsed KTX file, level data points into the source buffer
+struct KtxTexture
+{
+    uint32_t internalFormat = 0;
+    int width = 0;
+    int height = 0;
+    int faces = 0;
+    int mipLevels = 0;
+
+    // levels[mip * faces + face]
+    struct Level
+    {
+        int width;
+        int height;
+        const unsigned char* data;
+        size_t size;
+    };
+    std::vector<Level> levels;
+};
+
+// Where the cooker writes, and the runtime looks for, the cooked version of a texture
+std::string cookedTexturePath(const std::string& path)
+{
+    return path + ".ktx";
+}
+
+// Cubemaps are cooked into one file next to their first face
+std::string cookedCubemapPath(const std::vector<std::string>& faces)
+{
+    if (faces.empty())
+        return "";
+    size_t slash = faces[0].find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "" : faces[0].substr(0, slash + 1);
+    return directory + "cubemap.ktx";
+}
+
+// Expand any channel count to RGBA8 (1 channel stays red-only, like a GL_RED upload)
+MipLevel toRGBA8(const unsigned char* pixels, int width, int height, int numChannels)
+{
+    MipLevel level;
+    level.width = width;
+    level.height = height;
+    level.data.resize(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+    {
+        const unsigned char* in = pixels + i * numChannels;
+        unsigned char* out = &level.data[i * 4];
+        out[0] = in[0];
+        out[1] = numChannels >= 3 ? in[1] : 0;
+        out[2] = numChannels >= 3 ? in[2] : 0;
+        out[3] = numChannels == 4 ? in[3] : (numChannels == 2 ? in[1] : 255);
+    }
+    return level;
+}
+
+// Box-filtered RGBA8 mip chain down to 1x1 (odd edges are clamped)
+std::vector<MipLevel> generateMipChain(const unsigned char* pixels, int width, int height, int numChannels)
+{
+    std::vector<MipLevel> chain;
+    chain.push_back(toRGBA8(pixels, width, height, numChannels));
+    while (chain.back().width > 1 || chain.back().height > 1)
+    {
+        const MipLevel& source = chain.back();
+        MipLevel level;
+        level.width = std::max(1, source.width / 2);
+        level.height = std::max(1, source.height / 2);
+        level.data.resize(static_cast<size_t>(level.width) * level.height * 4);
+        for (int y = 0; y < level.height; y++)
+        {
+            int y0 = std::min(y * 2, source.height - 1);
+            int y1 = std::min(y * 2 + 1, source.height - 1);
+            for (int x = 0; x < level.width; x++)
+            {
+                int x0 = std::min(x * 2, source.width - 1);
+                int x1 = std::min(x * 2 + 1, source.width - 1);
+                for (int c = 0; c < 4; c++)
+                {
+                    int sum = source.data[(static_cast<size_t>(y0) * source.width + x0) * 4 + c] +
+                        source.data[(static_cast<size_t>(y0) * source.width + x1) * 4 + c] +
+                        source.data[(static_cast<size_t>(y1) * source.width + x0) * 4 + c] +
+                        source.data[(static_cast<size_t>(y1) * source.width + x1) * 4 + c];
+                    level.data[(static_cast<size_t>(y) * level.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        chain.push_back(std::move(level));
+    }
+    return chain;
+}
+
+// 565 packing helpers
+uint16_t packColor565(int r, int g, int b)
+{
+    return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+void unpackColor565(uint16_t color, int rgb[3])
+{
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// BC1 colour block from 16 RGBA8 pixels: endpoints along the principal axis, always 4-colour mode
+void encodeBC1Block(const unsigned char rgba[64], unsigned char out[8])
+{
+    // Mean and covariance of the block's colours
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += rgba[i * 4 + c] / 16.0f;
+
+    float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+    {
+        float r = rgba[i * 4 + 0] - mean[0];
+        float g = rgba[i * 4 + 1] - mean[1];
+        float b = rgba[i * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // Principal axis by power iteration
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[3] =
+        {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+        };
+        float length = std::max(std::fabs(next[0]), std::max(std::fabs(next[1]), std::fabs(next[2])));
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 3; c++)
+            axis[c] = next[c] / length;
+    }
+
+    // Extremes along the axis become the endpoints
+    float minProjection = 1e30f, maxProjection = -1e30f;
+    int minIndex = 0, maxIndex = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        float projection = rgba[i * 4 + 0] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+        if (projection < minProjection)
+        {
+            minProjection = projection;
+            minIndex = i;
+        }
+        if (projection > maxProjection)
+        {
+            maxProjection = projection;
+            maxIndex = i;
+        }
+    }
+    uint16_t color0 = packColor565(rgba[maxIndex * 4 + 0], rgba[maxIndex * 4 + 1], rgba[maxIndex * 4 + 2]);
+    uint16_t color1 = packColor565(rgba[minIndex * 4 + 0], rgba[minIndex * 4 + 1], rgba[minIndex * 4 + 2]);
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    // Palette from the quantized endpoints, as the decoder will see it
+    int palette[4][3];
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    // Nearest palette entry per pixel (equal endpoints means a flat block, index 0 everywhere)
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            int bestDistance = 1 << 30;
+            for (int p = 0; p < 4; p++)
+            {
+                int dr = rgba[i * 4 + 0] - palette[p][0];
+                int dg = rgba[i * 4 + 1] - palette[p][1];
+                int db = rgba[i * 4 + 2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(color0 & 0xFF);
+    out[1] = static_cast<unsigned char>(color0 >> 8);
+    out[2] = static_cast<unsigned char>(color1 & 0xFF);
+    out[3] = static_cast<unsigned char>(color1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+}
+
+// BC3 block: interpolated alpha block followed by a BC1 colour block
+void encodeBC3Block(const unsigned char rgba[64], unsigned char out[16])
+{
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+        alpha0 = std::max(alpha0, static_cast<int>(rgba[i * 4 + 3]));
+        alpha1 = std::min(alpha1, static_cast<int>(rgba[i * 4 + 3]));
+    }
+
+    // 8-value mode (alpha0 > alpha1): codes 0/1 are the endpoints, 2..7 interpolate between them
+    int palette[8];
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    for (int i = 1; i < 7; i++)
+        palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            int bestDistance = 1 << 30;
+            for (int p = 0; p < 8; p++)
+            {
+                int distance = std::abs(rgba[i * 4 + 3] - palette[p]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (i * 3);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(alpha0);
+    out[1] = static_cast<unsigned char>(alpha1);
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    encodeBC1Block(rgba, out + 8);
+}
+
+// Decode a BC1 block into 16 RGBA8 pixels
+void decodeBC1Block(const unsigned char in[8], unsigned char rgba[64])
+{
+    uint16_t color0 = static_cast<uint16_t>(in[0] | in[1] << 8);
+    uint16_t color1 = static_cast<uint16_t>(in[2] | in[3] << 8);
+    int palette[4][4];
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    for (int c = 0; c < 3; c++)
+    {
+        if (color0 > color1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = color0 > color1 ? 255 : 0;
+
+    uint32_t indices = in[4] | in[5] << 8 | in[6] << 16 | static_cast<uint32_t>(in[7]) << 24;
+    for (int i = 0; i < 16; i++)
+    {
+        int index = (indices >> (i * 2)) & 3;
+        for (int c = 0; c < 4; c++)
+            rgba[i * 4 + c] = static_cast<unsigned char>(palette[index][c]);
+    }
+}
+
+// Decode a BC3 block into 16 RGBA8 pixels
+void decodeBC3Block(const unsigned char in[16], unsigned char rgba[64])
+{
+    decodeBC1Block(in + 8, rgba);
+
+    int alpha0 = in[0], alpha1 = in[1];
+    int palette[8] = { alpha0, alpha1 };
+    for (int i = 1; i < 7; i++)
+        palette[i + 1] = alpha0 > alpha1 ? ((7 - i) * alpha0 + i * alpha1) / 7 : 0;
+    if (alpha0 <= alpha1)
+    {
+        // 6-value mode, never written by the encoder but valid input
+        for (int i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++)
+        indices |= static_cast<uint64_t>(in[2 + i]) << (i * 8);
+    for (int i = 0; i < 16; i++)
+        rgba[i * 4 + 3] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+}
+
+// Bytes of a compressed level, in whole 4x4 blocks
+size_t compressedLevelSize(int width, int height, bool withAlpha)
+{
+    size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (withAlpha ? 16 : 8);
+}
+
+// Compress an RGBA8 level, partial edge blocks repeat their last row/column
+MipLevel compressLevel(const MipLevel& level, bool withAlpha)
+{
+    MipLevel compressed;
+    compressed.width = level.width;
+    compressed.height = level.height;
+    compressed.data.resize(compressedLevelSize(level.width, level.height, withAlpha));
+
+    size_t blockSize = withAlpha ? 16 : 8;
+    unsigned char* out = compressed.data.data();
+    unsigned char block[64];
+    for (int by = 0; by < level.height; by += 4)
+    {
+        for (int bx = 0; bx < level.width; bx += 4)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                int sy = std::min(by + y, level.height - 1);
+                for (int x = 0; x < 4; x++)
+                {
+                    int sx = std::min(bx + x, level.width - 1);
+                    memcpy(block + (y * 4 + x) * 4, &level.data[(static_cast<size_t>(sy) * level.width + sx) * 4], 4);
+                }
+            }
+            if (withAlpha)
+                encodeBC3Block(block, out);
+            else
+                encodeBC1Block(block, out);
+            out += blockSize;
+        }
+    }
+    return compressed;
+}
+
+// Expand a compressed level back to RGBA8 (for drivers without S3TC and for checking the encoder)
+MipLevel decompressLevel(const unsigned char* blocks, int width, int height, bool withAlpha)
+{
+    MipLevel level;
+    level.width = width;
+    level.height = height;
+    level.data.resize(static_cast<size_t>(width) * height * 4);
+
+    size_t blockSize = withAlpha ? 16 : 8;
+    unsigned char block[64];
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            if (withAlpha)
+                decodeBC3Block(blocks, block);
+            else
+                decodeBC1Block(blocks, block);
+            blocks += blockSize;
+
+            for (int y = 0; y < 4 && by + y < height; y++)
+                for (int x = 0; x < 4 && bx + x < width; x++)
+                    memcpy(&level.data[(static_cast<size_t>(by + y) * width + bx + x) * 4], block + (y * 4 + x) * 4, 4);
+        }
+    }
+    return level;
+}
+
+// Peak signal-to-noise ratio over the RGB channels of two RGBA8 images
+double computePsnr(const unsigned char* a, const unsigned char* b, size_t pixelCount)
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < pixelCount; i++)
+        for (int c = 0; c < 3; c++)
+        {
+            double difference = static_cast<double>(a[i * 4 + c]) - b[i * 4 + c];
+            squaredError += difference * difference;
+        }
+    double meanSquaredError = squaredError / (pixelCount * 3.0);
+    return meanSquaredError == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+// Write a KTX 1.1 file, faces[face][mip] are already compressed with internalFormat
+bool writeKtx(const std::string& path, uint32_t internalFormat, const std::vector<std::vector<MipLevel>>& faces)
+{
+    if (faces.empty() || faces[0].empty())
+        return false;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    uint32_t header[13] =
+    {
+        0x04030201,                                     // Endianness
+        0,                                              // glType (compressed)
+        1,                                              // glTypeSize
+        0,                                              // glFormat (compressed)
+        internalFormat,
+        internalFormat == KTX_COMPRESSED_RGBA_S3TC_DXT5 ? KTX_RGBA : KTX_RGB,
+        static_cast<uint32_t>(faces[0][0].width),
+        static_cast<uint32_t>(faces[0][0].height),
+        0,                                              // Depth
+        0,                                              // Array elements
+        static_cast<uint32_t>(faces.size()),
+        static_cast<uint32_t>(faces[0].size()),
+        0                                               // Key/value bytes
+    };
+    out.write(reinterpret_cast<const char*>(KTX_IDENTIFIER), sizeof(KTX_IDENTIFIER));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    // Per mip: image size (of one face) then every face, block sizes keep everything 4-byte aligned
+    for (size_t mip = 0; mip < faces[0].size(); mip++)
+    {
+        uint32_t imageSize = static_cast<uint32_t>(faces[0][mip].data.size());
+        out.write(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+        for (const std::vector<MipLevel>& face : faces)
+            out.write(reinterpret_cast<const char*>(face[mip].data.data()), face[mip].data.size());
+    }
+    return static_cast<bool>(out);
+}
+
+// Bytes of one BC1/BC3 image: 8 or 16 per 4x4 block, partial blocks at the edges count whole
+size_t compressedImageSize(uint32_t internalFormat, int width, int height)
+{
+    size_t blockSize = internalFormat == KTX_COMPRESSED_RGBA_S3TC_DXT5 ? 16 : 8;
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+// Parse a KTX 1.1 file written by writeKtx (little-endian, BC1/BC3 compressed 2D or cubemap)
+// Anything else, or a level holding fewer bytes than its blocks need, is rejected so decoders never read past it
+bool parseKtx(const unsigned char* data, size_t size, KtxTexture& texture)
+{
+    const size_t headerSize = sizeof(KTX_IDENTIFIER) + 13 * sizeof(uint32_t);
+    if (size < headerSize || memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0)
+        return false;
+
+    uint32_t header[13];
+    memcpy(header, data + sizeof(KTX_IDENTIFIER), sizeof(header));
+    if (header[0] != 0x04030201 || header[1] != 0 || header[8] > 1 || header[9] != 0 || (header[10] != 1 && header[10] != 6))
+        return false;
+    if (header[4] != KTX_COMPRESSED_RGB_S3TC_DXT1 && header[4] != KTX_COMPRESSED_RGBA_S3TC_DXT5)
+        return false;
+    if (header[6] == 0 || header[7] == 0 || header[6] > 16384 || header[7] > 16384 || header[11] > 15)
+        return false;
+
+    texture.internalFormat = header[4];
+    texture.width = static_cast<int>(header[6]);
+    texture.height = static_cast<int>(header[7]);
+    texture.faces = static_cast<int>(header[10]);
+    texture.mipLevels = std::max(1, static_cast<int>(header[11]));
+    texture.levels.clear();
+
+    size_t offset = headerSize + header[12];
+    for (int mip = 0; mip < texture.mipLevels; mip++)
+    {
+        if (offset + sizeof(uint32_t) > size)
+            return false;
+        uint32_t imageSize;
+        memcpy(&imageSize, data + offset, sizeof(imageSize));
+        offset += sizeof(uint32_t);
+        int levelWidth = std::max(1, texture.width >> mip);
+        int levelHeight = std::max(1, texture.height >> mip);
+        if (imageSize < compressedImageSize(texture.internalFormat, levelWidth, levelHeight))
+            return false;
+
+        for (int face = 0; face < texture.faces; face++)
+        {
+            if (offset + imageSize > size)
+                return false;
+            KtxTexture::Level level;
+            level.width = levelWidth;
+            level.height = levelHeight;
+            level.data = data + offset;
+            level.size = imageSize;
+            texture.levels.push_back(level);
+            offset += (imageSize + 3) & ~static_cast<size_t>(3);
+        }
+    }
+    return true;
+}
+
+// Source image decoded and cooked into compressed mips
+struct CookedFace
+{
+    bool valid = false;
+    bool withAlpha = false;
+    size_t sourceBytes = 0;
+    std::vector<MipLevel> mips;
+    MipLevel baseLevel;
+};
+
+CookedFace cookFace(const std::string& path)
+{
+    CookedFace face;
+    int width, height, numChannels;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &numChannels, 0);
+    if (!pixels)
+    {
+        std::cout << "ERROR::TEXTURE_COOKER:: Failed to load " << path << std::endl;
+        return face;
+    }
+
+    std::vector<MipLevel> chain = generateMipChain(pixels, width, height, numChannels);
+    face.sourceBytes = static_cast<size_t>(width) * height * numChannels;
+    stbi_image_free(pixels);
+
+    // BC3 only when some pixel is actually translucent
+    for (size_t i = 3; i < chain[0].data.size() && !face.withAlpha; i += 4)
+        face.withAlpha = chain[0].data[i] != 255;
+
+    for (const MipLevel& level : chain)
+        face.mips.push_back(compressLevel(level, face.withAlpha));
+    face.baseLevel = std::move(chain[0]);
+    face.valid = true;
+    return face;
+}
+
+// Cook one or six faces concurrently into a single KTX file (sampled as-is, so load them unflipped)
+// faces keeps the decoded base levels for checking the result
+bool cookKtxTexture(const std::vector<std::string>& sources, const std::string& outPath, std::vector<CookedFace>& faces, bool& withAlpha)
+{
+    std::vector<std::future<CookedFace>> jobs;
+    for (const std::string& source : sources)
+        jobs.push_back(std::async(std::launch::async, cookFace, source));
+
+    faces.clear();
+    bool valid = true;
+    for (std::future<CookedFace>& job : jobs)
+    {
+        faces.push_back(job.get());
+        valid = valid && faces.back().valid;
+    }
+    if (!valid)
+        return false;
+
+    // Cubemap faces must agree, a single translucent face promotes them all to BC3
+    withAlpha = false;
+    for (const CookedFace& face : faces)
+    {
+        withAlpha = withAlpha || face.withAlpha;
+        if (face.baseLevel.width != faces[0].baseLevel.width || face.baseLevel.height != faces[0].baseLevel.height)
+        {
+            std::cout << "ERROR::TEXTURE_COOKER:: Cubemap faces differ in size" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<std::vector<MipLevel>> levels;
+    for (CookedFace& face : faces)
+    {
+        if (face.withAlpha != withAlpha)
+        {
+            face.mips.clear();
+            for (const MipLevel& level : generateMipChain(face.baseLevel.data.data(), face.baseLevel.width, face.baseLevel.height, 4))
+                face.mips.push_back(compressLevel(level, withAlpha));
+        }
+        levels.push_back(face.mips);
+    }
+
+    uint32_t format = withAlpha ? KTX_COMPRESSED_RGBA_S3TC_DXT5 : KTX_COMPRESSED_RGB_S3TC_DXT1;
+    if (!writeKtx(outPath, format, levels))
+    {
+        std::cout << "ERROR::TEXTURE_COOKER:: Could not write " << outPath << std::endl;
+        return false;
+    }
+    return true;
+}
+#endif // MY_TEXTURE_CODEC_H
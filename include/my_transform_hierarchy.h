@@ -0,0 +1,266 @@
+#ifndef MY_TRANSFORM_HIERARCHY_H
+#define MY_TRANSFORM_HIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <my_asset_pack.h>
+#include <my_json.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Rig files sit next to the model they animate: models/spitfire.obj -> models/spitfire.rig
+const char* const RIG_EXTENSION = ".rig";
+
+// The channel Model::drawHierarchy drives with its rot argument (degrees)
+const char* const HIERARCHY_SPIN_CHANNEL = "spin";
+
+// Rotation matrix of a unit quaternion (x, y, z, w)
+glm::mat4 quaternionMatrix(const glm::vec4& q)
+{
+    float x = q.x, y = q.y, z = q.z, w = q.w;
+    glm::mat4 result(1.0f);
+    result[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f);
+    result[1] = glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f);
+    result[2] = glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+    return result;
+}
+
+// Nodes with a parent, a local translation/rotation/scale about a pivot and optionally a channel that turns them
+// about an axis, stored flat with parents before children. update() walks the arrays once and only recomputes
+// nodes whose own inputs or whose parent's world matrix changed, so a still model costs one pass over a few flags
+// Node and channel names are resolved once at load (findNode/findChannel), per-frame calls take indices
+// World matrices are in model space, the model matrix is applied on top by the shader
+class TransformHierarchy
+{
+public:
+    // Append a node (a parent must already exist), returns its index
+    int addNode(const std::string& name, const std::string& meshName, int parent, const glm::vec3& translation,
+        const glm::vec4& rotation, const glm::vec3& scale)
+    {
+        names.push_back(name);
+        meshNames.push_back(meshName);
+        parents.push_back(parent);
+        translations.push_back(translation);
+        rotations.push_back(rotation);
+        scales.push_back(scale);
+        pivots.push_back(glm::vec3(0.0f));
+        hasPivots.push_back(0);
+        nodeChannels.push_back(-1);
+        channelAxes.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+        worldMatrices.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+        moved.push_back(0);
+        return static_cast<int>(names.size() - 1);
+    }
+
+    // Point the node turns and scales about
+    void setPivot(int node, const glm::vec3& pivot)
+    {
+        pivots[node] = pivot;
+        hasPivots[node] = 1;
+        dirty[node] = 1;
+    }
+
+    bool hasPivot(int node) const
+    {
+        return hasPivots[node] != 0;
+    }
+
+    // Turn node about axis (node space) by the named channel's value in degrees, creating the channel on first use
+    void bindChannel(int node, const std::string& channel, const glm::vec3& axis)
+    {
+        int index = findChannel(channel);
+        if (index < 0)
+        {
+            channelNames.push_back(channel);
+            channelValues.push_back(0.0f);
+            channelNodes.emplace_back();
+            index = static_cast<int>(channelNames.size() - 1);
+        }
+        nodeChannels[node] = index;
+        channelAxes[node] = axis;
+        channelNodes[index].push_back(node);
+        dirty[node] = 1;
+    }
+
+    // Index of the node named name, -1 if there's none
+    int findNode(const std::string& name) const
+    {
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            if (names[i] == name)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Index of the node that places the mesh named meshName, -1 if there's none
+    int findMeshNode(const std::string& meshName) const
+    {
+        for (size_t i = 0; i < meshNames.size(); i++)
+        {
+            if (meshNames[i] == meshName)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    int findChannel(const std::string& name) const
+    {
+        for (size_t i = 0; i < channelNames.size(); i++)
+        {
+            if (channelNames[i] == name)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Set a channel (degrees), only nodes bound to it are marked for the next update() and only if it changed
+    void setChannel(int channel, float degrees)
+    {
+        if (channel < 0 || channelValues[channel] == degrees)
+            return;
+        channelValues[channel] = degrees;
+        for (int node : channelNodes[channel])
+            dirty[node] = 1;
+    }
+
+    // Recompute the world matrices that are out of date, parents first. Returns how many were
+    size_t update()
+    {
+        size_t updated = 0;
+        for (size_t i = 0; i < parents.size(); i++)
+        {
+            int parent = parents[i];
+            moved[i] = dirty[i] || (parent >= 0 && moved[parent]);
+            if (!moved[i])
+                continue;
+            glm::mat4 local = localMatrix(i);
+            worldMatrices[i] = parent >= 0 ? worldMatrices[parent] * local : local;
+            dirty[i] = 0;
+            updated++;
+        }
+        return updated;
+    }
+
+    // Model space matrix of a node as of the last update()
+    const glm::mat4& worldMatrix(int node) const
+    {
+        return worldMatrices[node];
+    }
+
+    size_t nodeCount() const
+    {
+        return names.size();
+    }
+
+    // Read a rig file: {"nodes": [{"name", "mesh", "parent", "translation", "rotation", "scale", "pivot", "axis",
+    // "channel"}, ...]}, every member but name optional. mesh defaults to name, rotation is a quaternion (x, y, z, w),
+    // axis is "x", "y", "z" or a vector. A missing file is an empty hierarchy, not an error
+    bool load(const std::string& path)
+    {
+        *this = TransformHierarchy();
+        AssetFile file(path);
+        if (!file.isOpen())
+            return true;
+
+        JsonValue root;
+        JsonParser parser(reinterpret_cast<const char*>(file.data()), file.size());
+        const JsonValue* nodes = nullptr;
+        if (!parser.parse(root) || !(nodes = root.find("nodes")) || nodes->type != JSON_ARRAY)
+        {
+            std::cout << "ERROR::RIG:: Bad rig file " << path << ": " << (parser.error().empty() ? "no nodes array" : parser.error()) << std::endl;
+            return false;
+        }
+
+        for (size_t i = 0; i < nodes->size(); i++)
+        {
+            const JsonValue& node = (*nodes)[i];
+            std::string name = node.stringOr("name", "node" + std::to_string(i));
+            std::string parentName = node.stringOr("parent", "");
+            int parent = parentName.empty() ? -1 : findNode(parentName);
+            if (!parentName.empty() && parent < 0)
+                std::cout << "WARNING::RIG:: " << path << ": parent " << parentName << " of " << name << " isn't listed before it, made a root" << std::endl;
+
+            int index = addNode(name, node.stringOr("mesh", name), parent, readVector(node.find("translation"), glm::vec3(0.0f)),
+                readQuaternion(node.find("rotation")), readVector(node.find("scale"), glm::vec3(1.0f)));
+            if (node.find("pivot"))
+                setPivot(index, readVector(node.find("pivot"), glm::vec3(0.0f)));
+            std::string channel = node.stringOr("channel", "");
+            if (!channel.empty())
+                bindChannel(index, channel, readAxis(node.find("axis")));
+        }
+        return true;
+    }
+
+    // Rig file of a model
+    static std::string rigPath(const std::string& modelPath)
+    {
+        return std::filesystem::path(modelPath).replace_extension(RIG_EXTENSION).generic_string();
+    }
+
+private:
+    // Per node, by index
+    std::vector<std::string> names;
+    std::vector<std::string> meshNames;
+    std::vector<int> parents;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::vec4> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::vec3> pivots;
+    std::vector<uint8_t> hasPivots;
+    std::vector<int> nodeChannels;
+    std::vector<glm::vec3> channelAxes;
+    std::vector<glm::mat4> worldMatrices;
+    std::vector<uint8_t> dirty;     // Own inputs changed since the last update()
+    std::vector<uint8_t> moved;     // Recomputed by the current update(), children follow
+
+    // Per channel
+    std::vector<std::string> channelNames;
+    std::vector<float> channelValues;
+    std::vector<std::vector<int>> channelNodes;
+
+    // Translate * rotate * channel turn * scale, rotation and scale about the pivot
+    glm::mat4 localMatrix(size_t node) const
+    {
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), translations[node] + pivots[node]) * quaternionMatrix(rotations[node]);
+        if (nodeChannels[node] >= 0)
+            local = glm::rotate(local, glm::radians(channelValues[nodeChannels[node]]), channelAxes[node]);
+        local = glm::scale(local, scales[node]);
+        return glm::translate(local, -pivots[node]);
+    }
+
+    static glm::vec3 readVector(const JsonValue* value, const glm::vec3& fallback)
+    {
+        if (!value || value->size() != 3)
+            return fallback;
+        return glm::vec3(static_cast<float>((*value)[0].number), static_cast<float>((*value)[1].number), static_cast<float>((*value)[2].number));
+    }
+
+    static glm::vec4 readQuaternion(const JsonValue* value)
+    {
+        if (!value || value->size() != 4)
+            return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        return glm::vec4(static_cast<float>((*value)[0].number), static_cast<float>((*value)[1].number),
+            static_cast<float>((*value)[2].number), static_cast<float>((*value)[3].number));
+    }
+
+    static glm::vec3 readAxis(const JsonValue* value)
+    {
+        if (value && value->type == JSON_STRING)
+        {
+            if (value->string == "x")
+                return glm::vec3(1.0f, 0.0f, 0.0f);
+            if (value->string == "y")
+                return glm::vec3(0.0f, 1.0f, 0.0f);
+            return glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+        return readVector(value, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+};
+#endif // MY_TRANSFORM_HIERARCHY_H
@@ -0,0 +1,358 @@
+#ifndef MY_UPLOAD_WORKER_H
+#define MY_UPLOAD_WORKER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Streams buffer and texture data to the GPU from a background thread with its own shared GL context
+// Object names are generated on the render thread (names are shared between the contexts), the worker
+// fills them through an orphaned staging PBO, a few chunks per frame within a byte budget, and fences
+// each finished job. beginFrame() hands completed jobs back to the render thread once their fence has
+// signalled, so nothing on the render thread ever waits on an upload
+class UploadWorker
+{
+public:
+    // Called on the render thread once the data is on the GPU
+    typedef std::function<void()> Callback;
+
+    // Must be constructed on the main thread (GLFW window creation) with the render context current
+    UploadWorker(GLFWwindow* sharedWith, size_t bytesPerFrame = 4 * 1024 * 1024)
+        : bytesPerFrame(bytesPerFrame)
+    {
+        // Hidden 1x1 window, only used for its context
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        uploadWindow = glfwCreateWindow(1, 1, "Upload Worker", NULL, sharedWith);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (uploadWindow == NULL)
+        {
+            std::cout << "ERROR::UPLOAD_WORKER:: Failed to create shared context" << std::endl;
+            return;
+        }
+        worker = std::thread([this] { workerLoop(); });
+    }
+
+    ~UploadWorker()
+    {
+        shutdown();
+    }
+
+    UploadWorker(const UploadWorker&) = delete;
+    UploadWorker& operator=(const UploadWorker&) = delete;
+
+    // Stop the thread and destroy its context, call before glfwTerminate (main thread)
+    void shutdown()
+    {
+        if (worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            condition.notify_all();
+            worker.join();
+        }
+        if (uploadWindow)
+        {
+            glfwDestroyWindow(uploadWindow);
+            uploadWindow = NULL;
+        }
+        for (CompletedJob& completed : completedJobs)
+            glDeleteSync(completed.fence);
+        completedJobs.clear();
+    }
+
+    // Whether the shared context could be created, callers upload synchronously otherwise
+    bool isRunning() const
+    {
+        return uploadWindow != NULL;
+    }
+
+    // Fill a buffer generated on the render thread, keepAlive owns data until the upload is done (any thread)
+    void queueBuffer(GLuint buffer, GLenum target, const void* data, size_t size, std::shared_ptr<void> keepAlive, Callback onReady = Callback())
+    {
+        Job job;
+        job.type = BufferJob;
+        job.name = buffer;
+        job.target = target;
+        job.data = static_cast<const unsigned char*>(data);
+        job.size = size;
+        job.keepAlive = keepAlive;
+        job.onReady = onReady;
+        queue(std::move(job));
+    }
+
+    // Fill a 2D texture generated on the render thread, mipmaps are generated once all rows are in (any thread)
+    void queueTexture(GLuint texture, GLenum format, int width, int height, int numChannels, const unsigned char* pixels, std::shared_ptr<void> keepAlive, Callback onReady = Callback())
+    {
+        Job job;
+        job.type = TextureJob;
+        job.name = texture;
+        job.target = GL_TEXTURE_2D;
+        job.internalFormat = format;
+        job.format = format;
+        job.width = width;
+        job.height = height;
+        job.rowSize = static_cast<size_t>(width) * numChannels;
+        job.data = pixels;
+        job.size = job.rowSize * height;
+        job.keepAlive = keepAlive;
+        job.onReady = onReady;
+        queue(std::move(job));
+    }
+
+    // Fill one face (0-5: +x, -x, +y, -y, +z, -z) of a cubemap generated on the render thread, no mipmaps (any thread)
+    void queueCubemapFace(GLuint texture, unsigned int face, GLenum internalFormat, GLenum format, int width, int height, int numChannels,
+        const unsigned char* pixels, std::shared_ptr<void> keepAlive, Callback onReady = Callback())
+    {
+        Job job;
+        job.type = TextureJob;
+        job.name = texture;
+        job.target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+        job.internalFormat = internalFormat;
+        job.format = format;
+        job.width = width;
+        job.height = height;
+        job.rowSize = static_cast<size_t>(width) * numChannels;
+        job.data = pixels;
+        job.size = job.rowSize * height;
+        job.keepAlive = keepAlive;
+        job.onReady = onReady;
+        queue(std::move(job));
+    }
+
+    // Render thread, once per frame: grant this frame's upload budget and run callbacks for finished jobs
+    void beginFrame()
+    {
+        std::vector<Callback> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frameBudget = bytesPerFrame;
+
+            // Fences signal in submission order, so stop at the first one that hasn't
+            while (!completedJobs.empty())
+            {
+                GLenum status = glClientWaitSync(completedJobs.front().fence, 0, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                    break;
+                glDeleteSync(completedJobs.front().fence);
+                ready.push_back(completedJobs.front().onReady);
+                completedJobs.pop_front();
+            }
+        }
+        condition.notify_all();
+
+        for (Callback& callback : ready)
+        {
+            if (callback)
+                callback();
+        }
+    }
+
+    // Jobs queued or in flight
+    size_t pendingJobs()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size() + completedJobs.size() + (busy ? 1 : 0);
+    }
+
+private:
+    enum JobType
+    {
+        BufferJob,
+        TextureJob
+    };
+
+    struct Job
+    {
+        JobType type = BufferJob;
+        GLuint name = 0;
+        GLenum target = 0;          // Buffer target, GL_TEXTURE_2D or a cubemap face
+        GLenum internalFormat = 0;
+        GLenum format = 0;
+        int width = 0;
+        int height = 0;
+        size_t rowSize = 0;
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        size_t uploaded = 0;
+        std::shared_ptr<void> keepAlive;
+        Callback onReady;
+    };
+
+    struct CompletedJob
+    {
+        GLsync fence;
+        Callback onReady;
+    };
+
+    GLFWwindow* uploadWindow = NULL;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Job> jobs;
+    std::deque<CompletedJob> completedJobs;
+    size_t bytesPerFrame;
+    size_t frameBudget = 0;
+    bool busy = false;
+    bool stopping = false;
+
+    // Worker thread state
+    GLuint stagingBuffer = 0;
+
+    void queue(Job job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        condition.notify_all();
+    }
+
+    void workerLoop()
+    {
+        glfwMakeContextCurrent(uploadWindow);
+        glGenBuffers(1, &stagingBuffer);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        while (true)
+        {
+            // Wait for work and budget to do it with
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this] { return stopping || (!jobs.empty() && frameBudget > 0); });
+                if (stopping)
+                    break;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                busy = true;
+            }
+
+            // Stream the job out in budget-sized chunks, possibly across several frames
+            beginJob(job);
+            while (job.uploaded < job.size)
+            {
+                size_t budget = takeBudget(job.type == TextureJob ? job.rowSize : 1, job.size - job.uploaded);
+                if (budget == 0)
+                    break; // Stopping
+                uploadChunk(job, budget);
+            }
+
+            // Publish behind a fence, flushed so the render context sees it
+            finishJob(job);
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completedJobs.push_back({ fence, job.onReady });
+                busy = false;
+            }
+        }
+
+        glDeleteBuffers(1, &stagingBuffer);
+        glfwMakeContextCurrent(NULL);
+    }
+
+    // Claim up to wanted bytes of this frame's budget, in multiples of granularity (always at least one unit)
+    size_t takeBudget(size_t granularity, size_t wanted)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return stopping || frameBudget > 0; });
+        if (stopping)
+            return 0;
+
+        size_t granted = std::min(wanted, std::max(granularity, frameBudget - frameBudget % granularity));
+        frameBudget -= std::min(frameBudget, granted);
+        return granted;
+    }
+
+    // Allocate storage for the destination
+    void beginJob(const Job& job)
+    {
+        if (job.type == BufferJob)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, job.name);
+            glBufferData(GL_COPY_WRITE_BUFFER, job.size, NULL, GL_STATIC_DRAW);
+        }
+        else
+        {
+            glBindTexture(textureTarget(job), job.name);
+            glTexImage2D(job.target, 0, job.internalFormat, job.width, job.height, 0, job.format, GL_UNSIGNED_BYTE, NULL);
+        }
+    }
+
+    // What the texture is bound as, a cubemap for its faces
+    static GLenum textureTarget(const Job& job)
+    {
+        return job.target == GL_TEXTURE_2D ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP;
+    }
+
+    // Copy a chunk into the orphaned staging PBO, then from there into the destination
+    void uploadChunk(Job& job, size_t size)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (staging)
+        {
+            memcpy(staging, job.data + job.uploaded, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+
+        if (job.type == BufferJob)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, job.name);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, job.uploaded, size);
+        }
+        else
+        {
+            // Whole rows, read from the bound PBO at offset 0
+            GLint firstRow = static_cast<GLint>(job.uploaded / job.rowSize);
+            GLsizei rowCount = static_cast<GLsizei>(size / job.rowSize);
+            glBindTexture(textureTarget(job), job.name);
+            glTexSubImage2D(job.target, 0, 0, firstRow, job.width, rowCount, job.format, GL_UNSIGNED_BYTE, (void*)0);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        job.uploaded += size;
+    }
+
+    // Final touches once all data is in
+    void finishJob(const Job& job)
+    {
+        if (job.type == TextureJob && job.target != GL_TEXTURE_2D)
+        {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, job.name);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        }
+        else if (job.type == TextureJob)
+        {
+            glBindTexture(GL_TEXTURE_2D, job.name);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        else
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+};
+#endif // MY_UPLOAD_WORKER_H
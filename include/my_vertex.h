@@ -0,0 +1,193 @@
+#ifndef MY_VERTEX_H
+#define MY_VERTEX_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Full precision vertex, 32 bytes
+struct Vertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+};
+
+// Quantized vertex, 16 bytes: unorm16 position against the mesh bounds, octahedral snorm16 normal,
+// unorm16 texcoords against the mesh's UV range. Dequantized in the vertex shader
+struct PackedVertex
+{
+    uint16_t position[4];   // xyz, w unused (keeps the normal 4-byte aligned)
+    int16_t normal[2];
+    uint16_t texCoords[2];
+};
+
+// Vertex layouts a Mesh can upload
+enum VertexFormat
+{
+    VERTEX_FORMAT_FLOAT = 0,
+    VERTEX_FORMAT_PACKED = 1,
+    VERTEX_FORMAT_STREAMS = 2   // Separate attribute arrays uploaded as the file stores them (see VertexStreams)
+};
+
+// One attribute array of a VERTEX_FORMAT_STREAMS mesh, e.g. a glTF accessor
+struct VertexStream
+{
+    uint32_t offset = 0;        // Bytes from the start of the mesh's vertex buffer
+    uint32_t stride = 0;
+    uint32_t type = 0;          // GL component type, 0 when the mesh has no such attribute
+    int32_t components = 0;
+    bool normalized = false;
+};
+
+struct VertexStreams
+{
+    VertexStream position;
+    VertexStream normal;
+    VertexStream texCoords;
+};
+
+// Vertex attributes a shader reads, besides the position (see ImportProfile)
+const unsigned int VERTEX_ATTRIBUTE_NORMAL = 1 << 0;
+const unsigned int VERTEX_ATTRIBUTE_TEXCOORD = 1 << 1;
+
+// Per-mesh dequantization: value = packed * scale + offset (identity for float vertices)
+struct VertexQuantization
+{
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    glm::vec2 texCoordOffset = glm::vec2(0.0f);
+    glm::vec2 texCoordScale = glm::vec2(1.0f);
+};
+
+// Worst-case round trip error of a quantized mesh
+struct QuantizationError
+{
+    float position = 0.0f;          // Model units
+    float positionRelative = 0.0f;  // Fraction of the largest bounds extent
+    float normalDegrees = 0.0f;
+    float texCoord = 0.0f;          // UV units
+};
+
+size_t vertexFormatStride(VertexFormat format)
+{
+    return format == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2
+glm::vec2 encodeOctahedral(glm::vec3 n)
+{
+    n /= std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        e.x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        e.y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return e;
+}
+
+// Inverse of encodeOctahedral, mirrored in vertexShader.vs/cloudVertexShader.vs
+glm::vec3 decodeOctahedral(glm::vec2 e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    if (n.z < 0.0f)
+    {
+        float x = n.x;
+        n.x = (1.0f - std::fabs(n.y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::fabs(x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(n);
+}
+
+uint16_t quantizeUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+int16_t quantizeSnorm16(float value)
+{
+    return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+// Pack vertices against their bounds, filling in the dequantization the shader needs
+std::vector<PackedVertex> quantizeVertices(const Vertex* vertices, size_t vertexCount, VertexQuantization& quantization)
+{
+    std::vector<PackedVertex> packed(vertexCount);
+    if (vertexCount == 0)
+        return packed;
+
+    glm::vec3 positionMin = vertices[0].Position, positionMax = vertices[0].Position;
+    glm::vec2 texCoordMin = vertices[0].TexCoords, texCoordMax = vertices[0].TexCoords;
+    for (size_t i = 1; i < vertexCount; i++)
+    {
+        positionMin = glm::min(positionMin, vertices[i].Position);
+        positionMax = glm::max(positionMax, vertices[i].Position);
+        texCoordMin = glm::min(texCoordMin, vertices[i].TexCoords);
+        texCoordMax = glm::max(texCoordMax, vertices[i].TexCoords);
+    }
+
+    // Flat axes keep a nonzero scale so nothing divides by zero
+    quantization.positionOffset = positionMin;
+    quantization.positionScale = glm::max(positionMax - positionMin, glm::vec3(1e-20f));
+    quantization.texCoordOffset = texCoordMin;
+    quantization.texCoordScale = glm::max(texCoordMax - texCoordMin, glm::vec2(1e-20f));
+
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 position = (vertices[i].Position - quantization.positionOffset) / quantization.positionScale;
+        glm::vec2 texCoords = (vertices[i].TexCoords - quantization.texCoordOffset) / quantization.texCoordScale;
+        float normalLength = glm::length(vertices[i].Normal);
+        glm::vec2 normal = normalLength > 0.0f ? encodeOctahedral(vertices[i].Normal / normalLength) : glm::vec2(0.0f);
+
+        PackedVertex& out = packed[i];
+        out.position[0] = quantizeUnorm16(position.x);
+        out.position[1] = quantizeUnorm16(position.y);
+        out.position[2] = quantizeUnorm16(position.z);
+        out.position[3] = 0;
+        out.normal[0] = quantizeSnorm16(normal.x);
+        out.normal[1] = quantizeSnorm16(normal.y);
+        out.texCoords[0] = quantizeUnorm16(texCoords.x);
+        out.texCoords[1] = quantizeUnorm16(texCoords.y);
+    }
+    return packed;
+}
+
+// Exactly what the vertex shader reconstructs
+Vertex dequantizeVertex(const PackedVertex& packed, const VertexQuantization& quantization)
+{
+    Vertex vertex;
+    vertex.Position = glm::vec3(packed.position[0], packed.position[1], packed.position[2]) / 65535.0f * quantization.positionScale + quantization.positionOffset;
+    vertex.Normal = decodeOctahedral(glm::max(glm::vec2(packed.normal[0], packed.normal[1]) / 32767.0f, glm::vec2(-1.0f)));
+    vertex.TexCoords = glm::vec2(packed.texCoords[0], packed.texCoords[1]) / 65535.0f * quantization.texCoordScale + quantization.texCoordOffset;
+    return vertex;
+}
+
+// Measure the worst round trip error over a mesh
+QuantizationError measureQuantizationError(const Vertex* vertices, const PackedVertex* packed, size_t vertexCount, const VertexQuantization& quantization)
+{
+    QuantizationError error;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        Vertex restored = dequantizeVertex(packed[i], quantization);
+        glm::vec3 positionError = glm::abs(restored.Position - vertices[i].Position);
+        glm::vec2 texCoordError = glm::abs(restored.TexCoords - vertices[i].TexCoords);
+        error.position = std::max(error.position, std::max(positionError.x, std::max(positionError.y, positionError.z)));
+        error.texCoord = std::max(error.texCoord, std::max(texCoordError.x, texCoordError.y));
+
+        float normalLength = glm::length(vertices[i].Normal);
+        if (normalLength > 0.0f)
+        {
+            float cosine = std::min(1.0f, std::max(-1.0f, glm::dot(restored.Normal, vertices[i].Normal / normalLength)));
+            error.normalDegrees = std::max(error.normalDegrees, glm::degrees(std::acos(cosine)));
+        }
+    }
+
+    float extent = std::max(quantization.positionScale.x, std::max(quantization.positionScale.y, quantization.positionScale.z));
+    error.positionRelative = extent > 0.0f ? error.position / extent : 0.0f;
+    return error;
+}
+#endif // MY_VERTEX_H
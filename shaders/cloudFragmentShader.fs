@@ -4,9 +4,16 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 
-uniform vec3 lightPos;      // Position of the orange light source (e.g., the sun)
-uniform vec3 viewPos;       // Camera position
-uniform vec3 lightColour;   // Sunlight color (e.g., vec3(1.0, 0.6, 0.2))
+// Per-frame camera and light state, shared by every program (see my_frame_uniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;       // Camera position in world space
+    vec3 lightPos;      // Light position in world space
+    vec3 lightColour;
+};
+
 uniform float alpha;        // Cloud transparency (e.g., 0.2)
 uniform float blendCoeff;   // Lighting blend coefficient
 
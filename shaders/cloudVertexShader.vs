@@ -1,18 +1,70 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 3) in mat4 aInstance;    // Per-instance model space transform (see Mesh::drawInstanced)
+layout (location = 7) in uint aPart;        // Merged mesh the vertex belongs to (see MeshBatch)
+
+// Per-frame camera and light state, shared by every program (see my_frame_uniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;       // Camera position in world space
+    vec3 lightPos;      // Light position in world space
+    vec3 lightColour;
+};
+
+// Transform and quantization of each mesh merged into a MeshBatch, by aPart (see my_mesh_batch.h)
+struct ModelPart
+{
+    mat4 transform;             // Applied before model
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;     // Offset xy, scale zw
+};
+layout (std140) uniform ModelParts
+{
+    ModelPart parts[128];       // MAX_BATCH_PARTS
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform bool instanced;     // Apply aInstance before model
+uniform bool merged;        // Take the transform and quantization from parts[aPart]
+
+// Packed vertex format (see my_vertex.h): attributes arrive normalized to [0, 1] / [-1, 1]
+uniform bool quantized;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 out vec3 FragPos;
 out vec3 Normal;
 
+// Octahedral normal decode, matches decodeOctahedral in my_vertex.h
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main() 
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal; // Normal transformation
+    mat4 world = instanced ? model * aInstance : model;
+    vec3 partPositionOffset = positionOffset;
+    vec3 partPositionScale = positionScale;
+    if (merged)
+    {
+        world = model * parts[aPart].transform;
+        partPositionOffset = parts[aPart].positionOffset.xyz;
+        partPositionScale = parts[aPart].positionScale.xyz;
+    }
+
+    // Dequantize packed vertices
+    vec3 position = quantized ? aPos * partPositionScale + partPositionOffset : aPos;
+    vec3 normal = quantized ? decodeOctahedral(aNormal.xy) : aNormal;
+    FragPos = vec3(world * vec4(position, 1.0));
+    Normal = mat3(transpose(inverse(world))) * normal; // Normal transformation
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * world * vec4(position, 1.0);
 }
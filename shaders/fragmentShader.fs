@@ -8,8 +8,17 @@ in vec3 ViewDir;    // Direction vector from fragment to the camera
 
 out vec4 FragColor; // Output colour
 
+// Per-frame camera and light state, shared by every program (see my_frame_uniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;       // Camera position in world space
+    vec3 lightPos;      // Light position in world space
+    vec3 lightColour;
+};
+
 uniform sampler2D textureDiffuse1;
-uniform vec3 lightColour;           // Light colour
 uniform vec3 ambient;               // Ambient light
 uniform float specularExponent;     // Specular exponent
 
@@ -4,11 +4,19 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame camera and light state, shared by every program (see my_frame_uniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;       // Camera position in world space
+    vec3 lightPos;      // Light position in world space
+    vec3 lightColour;
+};
 
 void main() 
 {
     TexCoords = aPos;  
-    gl_Position = projection * view * vec4(aPos, 1.0);
+    // Rotation only, the sky stays centred on the camera
+    gl_Position = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
 }
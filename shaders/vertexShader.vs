@@ -3,12 +3,42 @@
 layout(location = 0) in vec3 aPos;          // Vertex position
 layout(location = 1) in vec3 aNormal;       // Vertex normal
 layout(location = 2) in vec2 aTexCoords;    // Texture coordinates
+layout(location = 3) in mat4 aInstance;     // Per-instance model space transform (see Mesh::drawInstanced)
+layout(location = 7) in uint aPart;         // Merged mesh the vertex belongs to (see MeshBatch)
+
+// Per-frame camera and light state, shared by every program (see my_frame_uniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;       // Camera position in world space
+    vec3 lightPos;      // Light position in world space
+    vec3 lightColour;
+};
+
+// Transform and quantization of each mesh merged into a MeshBatch, by aPart (see my_mesh_batch.h)
+struct ModelPart
+{
+    mat4 transform;             // Applied before model
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;     // Offset xy, scale zw
+};
+layout (std140) uniform ModelParts
+{
+    ModelPart parts[128];       // MAX_BATCH_PARTS
+};
 
 uniform mat4 model;      // Model matrix
-uniform mat4 view;       // View matrix
-uniform mat4 projection; // Projection matrix
-uniform vec3 lightPos;   // Light position in world space
-uniform vec3 viewPos;    // Camera (view) position in world space
+uniform bool instanced;  // Apply aInstance before model
+uniform bool merged;     // Take the transform and quantization from parts[aPart]
+
+// Packed vertex format (see my_vertex.h): attributes arrive normalized to [0, 1] / [-1, 1]
+uniform bool quantized;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform vec2 texCoordOffset;
+uniform vec2 texCoordScale;
 
 out vec3 FragPos;    // Fragment position in world space
 out vec3 Normal;     // Normal vector in world space
@@ -16,16 +46,43 @@ out vec3 LightDir;   // Direction vector from fragment to light source
 out vec3 ViewDir;    // Direction vector from fragment to camera
 out vec2 TexCoords;  // To pass texture coordinates to fragment shader
 
+// Octahedral normal decode, matches decodeOctahedral in my_vertex.h
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main() 
 {
+    // Shared meshes are placed per instance, merged ones per part
+    mat4 world = instanced ? model * aInstance : model;
+    vec3 partPositionOffset = positionOffset;
+    vec3 partPositionScale = positionScale;
+    vec4 partTexCoordTransform = vec4(texCoordOffset, texCoordScale);
+    if (merged)
+    {
+        world = model * parts[aPart].transform;
+        partPositionOffset = parts[aPart].positionOffset.xyz;
+        partPositionScale = parts[aPart].positionScale.xyz;
+        partTexCoordTransform = parts[aPart].texCoordTransform;
+    }
+
+    // Dequantize packed vertices
+    vec3 position = quantized ? aPos * partPositionScale + partPositionOffset : aPos;
+    vec3 normal = quantized ? decodeOctahedral(aNormal.xy) : aNormal;
+    vec2 texCoords = quantized ? aTexCoords * partTexCoordTransform.zw + partTexCoordTransform.xy : aTexCoords;
+
     // Calculate position in world space
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(world * vec4(position, 1.0));
 
     // Transform normal to world space and normalize
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = mat3(transpose(inverse(world))) * normal;
 
     // Texture coordinates
-    TexCoords = aTexCoords;
+    TexCoords = texCoords;
 
     // Calculate light direction vector
     LightDir = normalize(lightPos - FragPos);
@@ -5,9 +5,16 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <my_asset_pack.h>
+#include <my_async_io.h>
+#include <my_frame_uniforms.h>
+#include <my_gl_state.h>
 #include <my_shader.h>
 #include <my_plane_camera.h>
 #include <my_model.h>
+#include <my_model_loader.h>
+#include <my_model_settings.h>
+#include <my_upload_worker.h>
 #include <my_skybox.h>
 
 #include <iostream>
@@ -47,13 +54,6 @@ float generateRandomNumInRange(float low, float high)
     return dis(gen);
 }
 
-// 3D model name
-// "Spitfire Mk IXe" (https://skfb.ly/6txDP) 
-// by martinsifrar is licensed under 
-// Creative Commons Attribution (http://creativecommons.org/licenses/by/4.0/).
-#define PLANE_MODEL "models/spitfire.obj"
-#define CLOUD_MODEL "models/cloud.obj"
-
 // Camera specs (set later, can't call functions here)
 const float cameraSpeed = 3.0f;
 const float cameraZoom = 50.0f;
@@ -111,216 +111,272 @@ int main()
         return -1;
     }
 
-    // Configure global OpenGL state
-    glEnable(GL_DEPTH_TEST);        // Depth-testing
-    glDepthFunc(GL_LESS);           // Smaller value as "closer" for depth-testing
-    glEnable(GL_BLEND);             // Enable blending
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK); // Default
-    glFrontFace(GL_CCW);
-
-    // Build and compile shaders
-    Shader planeShader("shaders/vertexShader.vs", "shaders/fragmentShader.fs");
-    Shader cloudShader("shaders/cloudVertexShader.vs", "shaders/cloudFragmentShader.fs");
-    Shader skyboxShader("shaders/skyboxVertexShader.vs", "shaders/skyboxFragmentShader.fs");
-
-    // Load models
-    Model planeModel(PLANE_MODEL);
-    Model cloudModel(CLOUD_MODEL);
-
-    // Fine tune planeCamera params
-    planeCamera.setCameraMovementSpeed(cameraSpeed);
-    planeCamera.setCameraTurnSpeed(cameraTurnSpeed);
-    planeCamera.setZoom(false, 50.0f);
-
-    // IMGUI setup
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
-    ImGui::StyleColorsDark();
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 330");
-
-    // Set font
-    io.Fonts->Clear();
-    ImFont* myFont = io.Fonts->AddFontFromFileTTF(
-        "C:\\fonts\\Open_Sans\\static\\OpenSans_Condensed-Regular.ttf", 32.0f);
-
-    // Rebuild the font atlas
-    unsigned char* pixels;
-    int width, height;
-    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
-
-    // Setup skybox VAO
-    GLuint skyboxVAO = setupSkyboxVAO();
-
-    std::vector<std::string> facesCubemap =
-    {
-        "skybox/right.png",    // px
-        "skybox/left.png",     // nx
-        "skybox/top.png",      // py
-        "skybox/bottom.png",   // ny
-        "skybox/front.png",    // pz
-        "skybox/back.png"      // nz
-    };
-
-    GLuint cubemapTexture = loadCubemap(facesCubemap);
-
-    // Render loop
-    float elapsedTime = 0.0f;
-    float rotZ = 0.0f;
-    float specularExponent = 32.0f;
-    float ambientFloat = 0.1f;
-    float lightOffsetFloat = 25.0f;
-    glm::vec3 ambientLight(ambientFloat, ambientFloat, ambientFloat);
-    glm::vec3 lightOffset(lightOffsetFloat, lightOffsetFloat, lightOffsetFloat);
-    float lightColour[3] = { 1.0f, 0.35f, 0.25f };
-    float cloudAlpha = 0.2f;
-    float cloudBlendCoeff = 0.1f;
-    while (!glfwWindowShouldClose(window))
+    // Configure global OpenGL state, all of it through the tracker so it knows what's set
+    GLState& glState = GLState::instance();
+    glState.setDepthTest(true);             // Depth-testing
+    glState.setDepthFunc(GL_LESS);          // Smaller value as "closer" for depth-testing
+    glState.setBlend(true);                 // Enable blending
+    glState.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.setCullFace(true);
+    glState.setCullMode(GL_BACK); // Default
+    glState.setFrontFace(GL_CCW);
+
+    // Read every asset from one mapping when assets.pak is deployed (see tools/asset_packer.cpp), loose files otherwise
+    mountAssetPack();
+
+    // Everything that owns GL objects lives in this block, so it is destroyed while the context is still current
+    // (before the window goes away below)
     {
-        // Per-frame time logic
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - prevFrame;
-        elapsedTime += deltaTime;
-        prevFrame = currentFrame;
-
-        // User input handling
-        processUserInput(window);
-
-        // Disable depth test for skybox
-        glDisable(GL_DEPTH_TEST);
-
-        // Clear screen colour and buffers
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // IMGUI window
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        // Skybox
-        skyboxShader.use();
-
-        // Remove translation component from the view matrix for the skybox
-        glm::mat4 view = glm::mat4(glm::mat3(planeCamera.getViewMatrix()));
-        skyboxShader.setMat4("view", view);
-        glm::mat4 projection = glm::perspective(glm::radians(planeCamera.zoom),
-            static_cast<float>(SCREEN_WIDTH) / static_cast<float>(SCREEN_HEIGHT), 0.1f, 1000.0f);
-        skyboxShader.setMat4("projection", projection);
-
-        // Bind the skybox texture and render
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        skyboxShader.setInt("skybox", 0);
-
-        glBindVertexArray(skyboxVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-
-        // Set updated IMGUI params
-        ambientLight = glm::vec3(ambientFloat, ambientFloat, ambientFloat);
-        lightOffset = glm::vec3(lightOffsetFloat, lightOffsetFloat, lightOffsetFloat);
-
-        // Enable depth test for models
-        glEnable(GL_DEPTH_TEST);
-
-        // Draw clouds
-        glEnable(GL_BLEND);
-        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
-        cloudShader.use();
-        cloudShader.setVec3("lightColour", glm::vec3(lightColour[0], lightColour[1], lightColour[2]));
-        cloudShader.setVec3("viewPos", planeCamera.cameraPosition);
-        cloudShader.setVec3("lightPos", lightOffset);
-        cloudShader.setFloat("blendCoeff", cloudBlendCoeff);
-        view = planeCamera.getViewMatrix();
-        cloudShader.setMat4("view", view);
-        cloudShader.setMat4("projection", projection);
-        cloudShader.setFloat("alpha", cloudAlpha);
-        glm::mat4 model = glm::identity<glm::mat4>();
-        model = glm::translate(model, glm::vec3(0.0f, -50.0f, 0.0f));
-        cloudShader.setMat4("model", model);
-        cloudModel.draw(cloudShader);
-        glDisable(GL_BLEND);
-
-        // Enable shader before setting uniforms
-        planeShader.use();
-        planeShader.setVec3("ambient", ambientLight);
-        planeShader.setFloat("specularExponent", specularExponent);
-        planeShader.setVec3("lightColour", glm::vec3(lightColour[0], lightColour[1], lightColour[2]));
-
-        // Camera position
-        planeShader.setVec3("viewPos", planeCamera.cameraPosition);
-        planeShader.setVec3("lightPos", lightOffset);
-
-        // Model, View & Projection transformations, set uniforms in shader
-        view = planeCamera.getViewMatrix();
-        planeShader.setMat4("view", view);
-        planeShader.setMat4("projection", projection);
-
-        // Rotate the propeller around the z axis at 360 degrees per second
-        rotZ += 720.0f * deltaTime;
-        rotZ = fmodf(rotZ, 360.0f);
-
-        // Model mat
-        model = planeCamera.getPlaneModelMatrix();
-        model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        planeShader.setMat4("model", model);
-        planeModel.drawHierarchy(planeShader, model, rotZ);
-
-        // IMGUI drawing
-        ImGui::SetNextWindowCollapsed(!imguiMouseUse);
-        ImGui::SetNextWindowSize(ImVec2(550, 400));
-        ImGui::Begin("Parameter Adjustments");
-        ImGui::SliderFloat("Specular Exponent", &specularExponent, 2.0f, 128.0f);
-        ImGui::SliderFloat("Ambient light", &ambientFloat, 0.01f, 0.5f);
-        ImGui::SliderFloat("Light Offset", &lightOffsetFloat, 1.0f, 25.0f);
-        ImGui::SliderFloat("Cloud Alpha", &cloudAlpha, 0.05f, 0.8f);
-        ImGui::SliderFloat("Cloud Light Blend", &cloudBlendCoeff, 0.0f, 1.0f);
-        ImGui::ColorEdit3("Light Colour", lightColour);
-        ImGui::Combo("Camera Type", &planeCamera.selectedCameraType, cameraOptions, IM_ARRAYSIZE(cameraOptions));
-        ImGui::Checkbox("MoveFreely", &planeCamera.moveFreely);
-        planeCamera.updateCameraType(planeCamera.selectedCameraType);
-        ImGui::End();
-
-        // Second window in the top-right corner
-        ImVec2 windowSize(250, 360); // Set window size (adjust as needed)
-        ImVec2 topRightPos(ImGui::GetIO().DisplaySize.x - windowSize.x - 50, 50); // Offset 10px from edges
-
-        ImGui::SetNextWindowPos(topRightPos, ImGuiCond_Always); // Position window
-        ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always); // Set size
-
-        ImGui::Begin("Position", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
-        std::string xPosCam = "x = " + std::to_string(planeCamera.cameraPosition.x);
-        std::string yPosCam = "y = " + std::to_string(planeCamera.cameraPosition.y);
-        std::string zPosCam = "z = " + std::to_string(planeCamera.cameraPosition.z);
-        ImGui::Text("Camera Position:");
-        ImGui::Text(xPosCam.c_str());
-        ImGui::Text(yPosCam.c_str());
-        ImGui::Text(zPosCam.c_str());
-        std::string xRotPlane = "Rot X = " + std::to_string(glm::degrees(planeCamera.rotX));
-        std::string yRotPlane = "Rot Y = " + std::to_string(glm::degrees(planeCamera.rotY));
-        std::string zRotPlane = "Rot Z = " + std::to_string(glm::degrees(planeCamera.rotZ));
-        ImGui::Text("Plane Rotation:");
-        ImGui::Text(xRotPlane.c_str());
-        ImGui::Text(yRotPlane.c_str());
-        ImGui::Text(zRotPlane.c_str());
-        ImGui::End();
-
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
+        // Start loading models, their import and texture decoding runs on worker threads
+        // while the shaders, GUI and skybox are set up here, and their GPU data is streamed in
+        // by the upload worker's shared context within a per-frame budget
+        // File reads are batched through one async reader (io_uring where available) and decoded as they complete
+        AsyncFileReader fileReader;     // Outlives the pool, whose model loads read through it
+        ThreadPool loaderPool;
+        UploadWorker uploadWorker(window);
+        ModelLoader modelLoader(loaderPool, &uploadWorker, &fileReader);
+        Model planeModel;
+        Model cloudModel;
+        applyModelSettings(planeModel, PLANE_MODEL);
+        applyModelSettings(cloudModel, CLOUD_MODEL);
+        planeModel.residency = RESIDENCY_COLLISION_PROXY;
+        cloudModel.residency = RESIDENCY_FREE_AFTER_UPLOAD;
+
+        // A deployed pack means a production build, whose mesh caches were cooked into it (see tools/asset_cooker.cpp)
+        planeModel.requireCookedAssets = AssetPack::instance().isMounted();
+        cloudModel.requireCookedAssets = AssetPack::instance().isMounted();
+        modelLoader.load(planeModel, PLANE_MODEL);
+        modelLoader.load(cloudModel, CLOUD_MODEL);
+
+        // Decode the skybox faces in the background too, only their upload happens here
+        std::vector<std::string> facesCubemap = skyboxFacePaths("skybox");
+        std::future<CubemapFaces> skyboxFaces = decodeCubemapFacesAsync(fileReader, facesCubemap);
+
+        // Read the shader sources in one batch too, then build and compile them here
+        std::vector<std::string> shaderFiles =
+        {
+            "shaders/vertexShader.vs", "shaders/fragmentShader.fs",
+            "shaders/cloudVertexShader.vs", "shaders/cloudFragmentShader.fs",
+            "shaders/skyboxVertexShader.vs", "shaders/skyboxFragmentShader.fs"
+        };
+        std::vector<AssetBuffer> shaderSources(shaderFiles.size());
+        fileReader.readBatch(shaderFiles, [&shaderSources](size_t index, AssetBuffer& buffer) { shaderSources[index] = std::move(buffer); })->wait();
+        Shader planeShader(shaderSources[0], shaderSources[1]);
+        Shader cloudShader(shaderSources[2], shaderSources[3]);
+        Shader skyboxShader(shaderSources[4], shaderSources[5]);
+
+        // Camera and light state shared by all three programs, uploaded once per frame
+        FrameUniformBuffer frameUniformBuffer;
+        frameUniformBuffer.create();
+        planeShader.bindUniformBlock("FrameData", FRAME_UNIFORMS_BINDING);
+        cloudShader.bindUniformBlock("FrameData", FRAME_UNIFORMS_BINDING);
+        skyboxShader.bindUniformBlock("FrameData", FRAME_UNIFORMS_BINDING);
+
+        // Per-part transforms of the models' merged meshes (see my_mesh_batch.h)
+        planeShader.bindUniformBlock("ModelParts", MODEL_PARTS_BINDING);
+        cloudShader.bindUniformBlock("ModelParts", MODEL_PARTS_BINDING);
+        FrameUniforms frameUniforms;
+
+        // Fine tune planeCamera params
+        planeCamera.setCameraMovementSpeed(cameraSpeed);
+        planeCamera.setCameraTurnSpeed(cameraTurnSpeed);
+        planeCamera.setZoom(false, 50.0f);
+
+        // IMGUI setup
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO(); (void)io;
+        ImGui::StyleColorsDark();
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init("#version 330");
+
+        // Set font
+        io.Fonts->Clear();
+        ImFont* myFont = io.Fonts->AddFontFromFileTTF(
+            "C:\\fonts\\Open_Sans\\static\\OpenSans_Condensed-Regular.ttf", 32.0f);
+
+        // Rebuild the font atlas
+        unsigned char* pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+        // Setup skybox VAO
+        GLuint skyboxVAO = setupSkyboxVAO();
+
+        // Streamed in by the upload worker like the models' textures, the sky stays clear colour until it has arrived
+        GLuint cubemapTexture = loadCubemap(skyboxFaces.get(), uploadWorker);
+        bool skyboxReady = false;
+
+        // Render loop
+        float elapsedTime = 0.0f;
+        float rotZ = 0.0f;
+        float specularExponent = 32.0f;
+        float ambientFloat = 0.1f;
+        float lightOffsetFloat = 25.0f;
+        glm::vec3 ambientLight(ambientFloat, ambientFloat, ambientFloat);
+        glm::vec3 lightOffset(lightOffsetFloat, lightOffsetFloat, lightOffsetFloat);
+        float lightColour[3] = { 1.0f, 0.35f, 0.25f };
+        float cloudAlpha = 0.2f;
+        float cloudBlendCoeff = 0.1f;
+        bool modelsLoaded = false;
+        while (!glfwWindowShouldClose(window))
+        {
+            // Hand finished model loads to the upload worker and publish completed uploads,
+            // models pop in a frame or two later rather than stalling this loop
+            modelLoader.uploadReady();
+            uploadWorker.beginFrame();
+            if (!modelsLoaded && modelLoader.idle() && uploadWorker.pendingJobs() == 0)
+            {
+                modelsLoaded = true;
+                TextureCache::instance().printStats();
+                planeModel.printMemoryStats(PLANE_MODEL);
+                cloudModel.printMemoryStats(CLOUD_MODEL);
+            }
+
+            // Per-frame time logic
+            float currentFrame = static_cast<float>(glfwGetTime());
+            deltaTime = currentFrame - prevFrame;
+            elapsedTime += deltaTime;
+            prevFrame = currentFrame;
+
+            // User input handling
+            processUserInput(window);
+
+            // Disable depth test for skybox
+            glState.setDepthTest(false);
+
+            // Clear screen colour and buffers
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // IMGUI window
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+
+            // Set updated IMGUI params
+            ambientLight = glm::vec3(ambientFloat, ambientFloat, ambientFloat);
+            lightOffset = glm::vec3(lightOffsetFloat, lightOffsetFloat, lightOffsetFloat);
+
+            // Camera and light for every program this frame (the skybox drops the view's translation itself)
+            frameUniforms.view = planeCamera.getViewMatrix();
+            frameUniforms.projection = glm::perspective(glm::radians(planeCamera.zoom),
+                static_cast<float>(SCREEN_WIDTH) / static_cast<float>(SCREEN_HEIGHT), 0.1f, 1000.0f);
+            frameUniforms.viewPos = planeCamera.cameraPosition;
+            frameUniforms.lightPos = lightOffset;
+            frameUniforms.lightColour = glm::vec3(lightColour[0], lightColour[1], lightColour[2]);
+            frameUniformBuffer.update(frameUniforms);
+
+            // Skybox
+            skyboxReady = skyboxReady || TextureCache::instance().isReady(cubemapTexture);
+            if (skyboxReady)
+            {
+                skyboxShader.use();
+
+                // Bind the skybox texture and render
+                glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+                skyboxShader.setInt("skybox", 0);
+
+                glState.bindVertexArray(skyboxVAO);
+                glDrawArrays(GL_TRIANGLES, 0, 36);
+            }
+
+            // Enable depth test for models
+            glState.setDepthTest(true);
+
+            // Draw clouds
+            glState.setBlend(true);
+            glState.setBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+            cloudShader.use();
+            cloudShader.setFloat("blendCoeff", cloudBlendCoeff);
+            cloudShader.setFloat("alpha", cloudAlpha);
+            glm::mat4 model = glm::identity<glm::mat4>();
+            model = glm::translate(model, glm::vec3(0.0f, -50.0f, 0.0f));
+            cloudShader.setMat4("model", model);
+            cloudModel.selectLods(model, planeCamera.cameraPosition, glm::radians(planeCamera.zoom), static_cast<float>(SCREEN_HEIGHT));
+            cloudModel.draw(cloudShader);
+            glState.setBlend(false);
+
+            // Enable shader before setting uniforms
+            planeShader.use();
+            planeShader.setVec3("ambient", ambientLight);
+            planeShader.setFloat("specularExponent", specularExponent);
+
+            // Rotate the propeller around the z axis at 360 degrees per second
+            rotZ += 720.0f * deltaTime;
+            rotZ = fmodf(rotZ, 360.0f);
+
+            // Model mat
+            model = planeCamera.getPlaneModelMatrix();
+            model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            planeShader.setMat4("model", model);
+            planeModel.selectLods(model, planeCamera.cameraPosition, glm::radians(planeCamera.zoom), static_cast<float>(SCREEN_HEIGHT));
+            planeModel.drawHierarchy(planeShader, model, rotZ);
+
+            // IMGUI drawing
+            ImGui::SetNextWindowCollapsed(!imguiMouseUse);
+            ImGui::SetNextWindowSize(ImVec2(550, 400));
+            ImGui::Begin("Parameter Adjustments");
+            ImGui::SliderFloat("Specular Exponent", &specularExponent, 2.0f, 128.0f);
+            ImGui::SliderFloat("Ambient light", &ambientFloat, 0.01f, 0.5f);
+            ImGui::SliderFloat("Light Offset", &lightOffsetFloat, 1.0f, 25.0f);
+            ImGui::SliderFloat("Cloud Alpha", &cloudAlpha, 0.05f, 0.8f);
+            ImGui::SliderFloat("Cloud Light Blend", &cloudBlendCoeff, 0.0f, 1.0f);
+            ImGui::ColorEdit3("Light Colour", lightColour);
+            ImGui::Combo("Camera Type", &planeCamera.selectedCameraType, cameraOptions, IM_ARRAYSIZE(cameraOptions));
+            ImGui::Checkbox("MoveFreely", &planeCamera.moveFreely);
+            planeCamera.updateCameraType(planeCamera.selectedCameraType);
+            ImGui::End();
+
+            // Second window in the top-right corner
+            ImVec2 windowSize(250, 530); // Set window size (adjust as needed)
+            ImVec2 topRightPos(ImGui::GetIO().DisplaySize.x - windowSize.x - 50, 50); // Offset 10px from edges
+
+            ImGui::SetNextWindowPos(topRightPos, ImGuiCond_Always); // Position window
+            ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always); // Set size
+
+            ImGui::Begin("Position", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+            std::string xPosCam = "x = " + std::to_string(planeCamera.cameraPosition.x);
+            std::string yPosCam = "y = " + std::to_string(planeCamera.cameraPosition.y);
+            std::string zPosCam = "z = " + std::to_string(planeCamera.cameraPosition.z);
+            ImGui::Text("Camera Position:");
+            ImGui::Text(xPosCam.c_str());
+            ImGui::Text(yPosCam.c_str());
+            ImGui::Text(zPosCam.c_str());
+            std::string xRotPlane = "Rot X = " + std::to_string(glm::degrees(planeCamera.rotX));
+            std::string yRotPlane = "Rot Y = " + std::to_string(glm::degrees(planeCamera.rotY));
+            std::string zRotPlane = "Rot Z = " + std::to_string(glm::degrees(planeCamera.rotZ));
+            ImGui::Text("Plane Rotation:");
+            ImGui::Text(xRotPlane.c_str());
+            ImGui::Text(yRotPlane.c_str());
+            ImGui::Text(zRotPlane.c_str());
+            const UniformStats& uniformStats = Shader::lastFrameStats();
+            ImGui::Text("Uniforms per frame:");
+            ImGui::Text("%zu GL lookups avoided", uniformStats.lookupsAvoided);
+            ImGui::Text("%zu still found by name", uniformStats.nameSearches);
+            const GLStateStats& stateStats = glState.lastFrameStats();
+            ImGui::Text("GL state changes per frame:");
+            ImGui::Text("%zu issued", stateStats.changesIssued);
+            ImGui::Text("%zu redundant dropped", stateStats.changesDropped);
+            ImGui::End();
+
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            Shader::endFrame();
+            glState.endFrame();
+
+            // Swap buffers and poll events
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
 
-    // Shutdown procedure
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+        // Shutdown procedure (let in-flight model loads finish before their models go away)
+        modelLoader.finish();
+        uploadWorker.shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     // Destroy window
     glfwDestroyWindow(window);
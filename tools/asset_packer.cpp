@@ -0,0 +1,65 @@
+// Asset packer: gathers the app's asset directories into one pack (see my_asset_pack.h), then mounts it and
+// checks every entry reads back byte for byte
+// Run from the directory the app runs from, packed paths are relative to it. Mesh caches and cooked textures
+// found next to their sources are packed too, so build it after a first run and a texture cook
+// Usage: asset_packer [output] [directory or file]...   (default: assets.pak models shaders skybox)
+
+#include <my_asset_pack.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    std::string packPath = argc > 1 ? argv[1] : ASSET_PACK_FILE;
+    std::vector<std::string> roots;
+    for (int i = 2; i < argc; i++)
+        roots.push_back(argv[i]);
+    if (roots.empty())
+        roots = { "models", "shaders", "skybox" };
+
+    std::vector<std::pair<std::string, std::string>> files;
+    for (const std::string& root : roots)
+        gatherAssetFiles(root, files);
+    if (files.empty())
+    {
+        printf("No assets found\n");
+        return -1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!writeAssetPack(packPath, files))
+    {
+        printf("Could not write %s\n", packPath.c_str());
+        return -1;
+    }
+    double writeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // Read everything back through the same path the app uses
+    if (!AssetPack::instance().mount(packPath))
+        return -1;
+    size_t assetBytes = 0, mismatches = 0;
+    for (const auto& file : files)
+    {
+        MappedFile loose(file.second);
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        bool found = AssetPack::instance().find(file.first, data, size);
+        if (!found || size != loose.size() || (size != 0 && memcmp(data, loose.data(), size) != 0))
+        {
+            printf("  MISMATCH %s\n", file.first.c_str());
+            mismatches++;
+        }
+        assetBytes += size;
+    }
+
+    std::error_code error;
+    printf("%s: %zu assets, %.2f MB of data, %.2f MB pack (%.1f ms)\n", packPath.c_str(), files.size(), assetBytes / (1024.0 * 1024.0),
+        std::filesystem::file_size(packPath, error) / (1024.0 * 1024.0), writeTime);
+    printf("  Read back: %s\n", mismatches == 0 ? "all assets match" : "MISMATCHES");
+    return mismatches == 0 ? 0 : 1;
+}
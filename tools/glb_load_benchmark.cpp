@@ -0,0 +1,188 @@
+// GLB vs OBJ load time on the same geometry: converts the OBJ to a GLB next to it, then times reading each one
+// up to the point its meshes are ready to upload (Assimp with the legacy import steps for the OBJ), no GL involved
+// Exits non-zero if the GLB's mesh names differ from Assimp's or an embedded image doesn't read back byte for byte
+// Build with the same include/library setup as the main app
+// Usage: glb_load_benchmark [model path] [iterations]
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <my_gltf.h>
+#include <my_import_profile.h>
+#include <my_obj_parser.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+void appendBytes(std::vector<unsigned char>& out, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+// Write meshes as a GLB: one node per mesh, placed at the centre of its bounding box (the spin pivot of the
+// propeller and wheels) with the vertices rebased onto it, interleaved float attributes and 32-bit indices
+// Materials aren't converted, texturing isn't what's being timed. A non-empty image is embedded in the binary chunk
+// as every mesh's base colour texture, to check embedded images come back byte for byte
+bool writeGlb(const std::string& path, const std::vector<MeshData>& meshes, const std::vector<unsigned char>& image = {})
+{
+    std::vector<unsigned char> binary;
+    std::ostringstream views, accessors, nodes, gltfMeshes;
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        const MeshData& mesh = meshes[m];
+        glm::vec3 low(1e30f), high(-1e30f);
+        for (const Vertex& vertex : mesh.vertices)
+        {
+            low = glm::min(low, vertex.Position);
+            high = glm::max(high, vertex.Position);
+        }
+        glm::vec3 pivot = (low + high) * 0.5f;
+
+        size_t vertexOffset = binary.size();
+        for (Vertex vertex : mesh.vertices)
+        {
+            vertex.Position -= pivot;
+            appendBytes(binary, &vertex, sizeof(Vertex));
+        }
+        size_t indexOffset = binary.size();
+        appendBytes(binary, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+
+        const char* separator = m == 0 ? "" : ",";
+        size_t view = m * 2, accessor = m * 4;
+        views << separator << "{\"buffer\":0,\"byteOffset\":" << vertexOffset << ",\"byteLength\":" << indexOffset - vertexOffset
+            << ",\"byteStride\":" << sizeof(Vertex) << "},{\"buffer\":0,\"byteOffset\":" << indexOffset << ",\"byteLength\":" << binary.size() - indexOffset << "}";
+        accessors << separator
+            << "{\"bufferView\":" << view << ",\"byteOffset\":" << offsetof(Vertex, Position) << ",\"componentType\":5126,\"count\":" << mesh.vertices.size()
+            << ",\"type\":\"VEC3\",\"min\":[" << low.x - pivot.x << "," << low.y - pivot.y << "," << low.z - pivot.z
+            << "],\"max\":[" << high.x - pivot.x << "," << high.y - pivot.y << "," << high.z - pivot.z << "]},"
+            << "{\"bufferView\":" << view << ",\"byteOffset\":" << offsetof(Vertex, Normal) << ",\"componentType\":5126,\"count\":" << mesh.vertices.size() << ",\"type\":\"VEC3\"},"
+            << "{\"bufferView\":" << view << ",\"byteOffset\":" << offsetof(Vertex, TexCoords) << ",\"componentType\":5126,\"count\":" << mesh.vertices.size() << ",\"type\":\"VEC2\"},"
+            << "{\"bufferView\":" << view + 1 << ",\"componentType\":5125,\"count\":" << mesh.indices.size() << ",\"type\":\"SCALAR\"}";
+        gltfMeshes << separator << "{\"primitives\":[{\"attributes\":{\"POSITION\":" << accessor << ",\"NORMAL\":" << accessor + 1
+            << ",\"TEXCOORD_0\":" << accessor + 2 << "},\"indices\":" << accessor + 3 << (image.empty() ? "" : ",\"material\":0") << "}]}";
+        nodes << separator << "{\"name\":\"" << mesh.meshName << "\",\"mesh\":" << m << ",\"translation\":[" << pivot.x << "," << pivot.y << "," << pivot.z << "]}";
+    }
+
+    // Left unaligned after the indices, bufferViews of images needn't be
+    std::string materials;
+    if (!image.empty())
+    {
+        views << ",{\"buffer\":0,\"byteOffset\":" << binary.size() << ",\"byteLength\":" << image.size() << "}";
+        materials = ",\"images\":[{\"bufferView\":" + std::to_string(meshes.size() * 2) + ",\"mimeType\":\"image/png\"}],\"textures\":[{\"source\":0}]," +
+            "\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":0}}}]";
+        binary.insert(binary.end(), image.begin(), image.end());
+    }
+
+    std::ostringstream json;
+    json.precision(9);
+    json << "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" << binary.size() << "}],\"bufferViews\":[" << views.str()
+        << "],\"accessors\":[" << accessors.str() << "],\"meshes\":[" << gltfMeshes.str() << "],\"nodes\":[" << nodes.str() << "]" << materials << "}";
+    std::string jsonText = json.str();
+    while (jsonText.size() % 4 != 0)
+        jsonText += ' ';
+    while (binary.size() % 4 != 0)
+        binary.push_back(0);
+
+    uint32_t header[5] = { GLB_MAGIC, 2, static_cast<uint32_t>(12 + 8 + jsonText.size() + 8 + binary.size()),
+        static_cast<uint32_t>(jsonText.size()), GLB_CHUNK_JSON };
+    uint32_t binaryHeader[2] = { static_cast<uint32_t>(binary.size()), GLB_CHUNK_BIN };
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(jsonText.data(), jsonText.size());
+    file.write(reinterpret_cast<const char*>(binaryHeader), sizeof(binaryHeader));
+    file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    return static_cast<bool>(file);
+}
+
+// Average milliseconds per GLB read, keeps the last result
+double timeGlbLoad(const std::string& path, int iterations, GlbScene& scene)
+{
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        scene = GlbScene();
+        auto start = std::chrono::high_resolution_clock::now();
+        loadGlb(path, scene);
+        auto end = std::chrono::high_resolution_clock::now();
+        total += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return total / iterations;
+}
+
+// Average milliseconds per Assimp import, fills in the mesh names it produced
+double timeAssimpImport(const std::string& path, int iterations, std::vector<std::string>& meshNames)
+{
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, LEGACY_IMPORT_STEPS);
+        auto end = std::chrono::high_resolution_clock::now();
+        total += std::chrono::duration<double, std::milli>(end - start).count();
+
+        meshNames.clear();
+        for (unsigned int m = 0; scene && m < scene->mNumMeshes; m++)
+            meshNames.push_back(scene->mMeshes[m]->mName.C_Str());
+    }
+    return total / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "models/airplane.obj";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::vector<MeshData> objMeshes;
+    if (!parseObjFile(path, objMeshes))
+    {
+        printf("Could not read %s\n", path.c_str());
+        return -1;
+    }
+    std::string glbPath = path.substr(0, path.find_last_of('.')) + ".glb";
+    if (!writeGlb(glbPath, objMeshes))
+    {
+        printf("Could not write %s\n", glbPath.c_str());
+        return -1;
+    }
+
+    GlbScene scene;
+    double glb = timeGlbLoad(glbPath, iterations, scene);
+    std::vector<std::string> assimpNames;
+    double assimp = timeAssimpImport(path, iterations, assimpNames);
+
+    size_t uploadBytes = 0;
+    for (const MeshData& mesh : scene.meshes)
+        uploadBytes += mesh.vertexBytes() + mesh.indexBytes();
+
+    printf("%s -> %s (%d iterations, %zu meshes, %zu nodes, %.2f MB binary)\n", path.c_str(), glbPath.c_str(), iterations,
+        scene.meshes.size(), scene.nodeCount, scene.binaryBytes / (1024.0 * 1024.0));
+    printf("  GLB, mapped:            %8.3f ms (%.2f MB handed to glBufferData as is)\n", glb, uploadBytes / (1024.0 * 1024.0));
+    printf("  Assimp OBJ:             %8.3f ms\n", assimp);
+    printf("  Speedup over Assimp:    %8.1fx\n", assimp / glb);
+
+    // Rig files bind meshes by name, so both paths have to agree on them
+    bool namesMatch = assimpNames.size() == scene.meshes.size();
+    for (size_t i = 0; namesMatch && i < scene.meshes.size(); i++)
+        namesMatch = assimpNames[i] == scene.meshes[i].meshName;
+    printf("  Mesh names match Assimp: %s\n", namesMatch ? "yes" : "NO");
+
+    // Same geometry with an embedded image, which loadGlb locates by its offset into the binary chunk
+    std::vector<unsigned char> image(1021);
+    for (size_t i = 0; i < image.size(); i++)
+        image[i] = static_cast<unsigned char>(i * 7 + 3);
+    std::string imageGlbPath = path.substr(0, path.find_last_of('.')) + ".image.glb";
+    GlbScene imageScene;
+    bool imageMatches = writeGlb(imageGlbPath, objMeshes, image) && loadGlb(imageGlbPath, imageScene) && imageScene.images.size() == 1 &&
+        imageScene.images[0].size == image.size() && memcmp(imageScene.images[0].data, image.data(), image.size()) == 0;
+    printf("  Embedded image matches:  %s\n", imageMatches ? "yes" : "NO");
+    return namesMatch && imageMatches ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// Mesh codec (see my_mesh_codec.h): compression ratio, round-trip check and decode throughput on a model's meshes,
+// processed the way a compressed mesh cache stores them (optimized, then float or quantized vertices), no GL involved
+// Exits non-zero if any stream doesn't decode back byte for byte
+// Build with the same include/library setup as the main app
+// Usage: mesh_codec_benchmark [model path] [iterations]
+
+#include <my_mesh.h>
+#include <my_mesh_codec.h>
+#include <my_mesh_optimizer.h>
+#include <my_obj_parser.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// One vertex or index stream, raw and encoded
+struct CodecStream
+{
+    const void* raw;
+    size_t count;
+    size_t elementSize;
+    bool vertices;
+    std::vector<unsigned char> encoded;
+};
+
+// Decode every stream iterations times, returns decoded GB/s, clears ok on any mismatch
+double timeDecode(std::vector<CodecStream>& streams, bool vertices, bool useSimd, int iterations, bool& ok)
+{
+    size_t decodedBytes = 0;
+    double total = 0.0;
+    for (CodecStream& stream : streams)
+    {
+        if (stream.vertices != vertices)
+            continue;
+        std::vector<unsigned char> decoded(stream.count * stream.elementSize);
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            bool decodedOk = vertices
+                ? decodeVertexBuffer(decoded.data(), stream.count, stream.elementSize, stream.encoded.data(), stream.encoded.size(), useSimd)
+                : decodeIndexBuffer(decoded.data(), stream.count, stream.elementSize, stream.encoded.data(), stream.encoded.size());
+            total += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            if (!decodedOk || (!decoded.empty() && memcmp(decoded.data(), stream.raw, decoded.size()) != 0))
+                ok = false;
+        }
+        decodedBytes += decoded.size() * iterations;
+    }
+    return total > 0.0 ? decodedBytes / total / 1e9 : 0.0;
+}
+
+// Encode the current vertex and index streams of meshes and report sizes and decode speed
+bool measure(const char* label, const std::vector<MeshData>& meshes, int iterations)
+{
+    std::vector<CodecStream> streams;
+    size_t rawBytes[2] = {}, encodedBytes[2] = {};
+    for (const MeshData& mesh : meshes)
+    {
+        size_t stride = vertexFormatStride(mesh.vertexFormat);
+        size_t indexSize = indexTypeSize(mesh.indexType);
+        streams.push_back({ mesh.vertexData(), mesh.vertexCount(), stride, true, encodeVertexBuffer(mesh.vertexData(), mesh.vertexCount(), stride) });
+        streams.push_back({ mesh.indexData(), mesh.indexCount(), indexSize, false, encodeIndexBuffer(mesh.indexData(), mesh.indexCount(), indexSize) });
+    }
+    for (const CodecStream& stream : streams)
+    {
+        rawBytes[stream.vertices] += stream.count * stream.elementSize;
+        encodedBytes[stream.vertices] += stream.encoded.size();
+    }
+
+    bool ok = true;
+    double simdVertices = timeDecode(streams, true, true, iterations, ok);
+    double scalarVertices = timeDecode(streams, true, false, iterations, ok);
+    double indices = timeDecode(streams, false, true, iterations, ok);
+
+    printf("  %s\n", label);
+    printf("    Vertices: %8.1f KB -> %8.1f KB (%5.1f%%), decode %.2f GB/s SIMD, %.2f GB/s scalar\n", rawBytes[1] / 1024.0, encodedBytes[1] / 1024.0,
+        100.0 * encodedBytes[1] / std::max<size_t>(1, rawBytes[1]), simdVertices, scalarVertices);
+    printf("    Indices:  %8.1f KB -> %8.1f KB (%5.1f%%), decode %.2f GB/s\n", rawBytes[0] / 1024.0, encodedBytes[0] / 1024.0,
+        100.0 * encodedBytes[0] / std::max<size_t>(1, rawBytes[0]), indices);
+    printf("    Round trip: %s\n", ok ? "all streams match" : "MISMATCH");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "models/spitfire.obj";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    std::vector<MeshData> meshes;
+    if (!parseObjFile(path, meshes))
+    {
+        printf("Could not read %s\n", path.c_str());
+        return -1;
+    }
+    for (MeshData& mesh : meshes)
+        optimizeMesh(mesh.vertices, mesh.indices);
+
+#ifdef MESH_CODEC_SSE2
+    const char* simd = "SSE2";
+#else
+    const char* simd = "none, SIMD figures use the scalar path";
+#endif
+    printf("%s (%zu meshes, %d iterations, SIMD: %s)\n", path.c_str(), meshes.size(), iterations, simd);
+    bool ok = measure("Float vertices, 32-bit indices", meshes, iterations);
+
+    for (MeshData& mesh : meshes)
+    {
+        mesh.quantize();
+        mesh.selectIndexType();
+    }
+    ok = measure("Quantized vertices, narrowed indices (compressed mesh cache)", meshes, iterations) && ok;
+    return ok ? 0 : 1;
+}
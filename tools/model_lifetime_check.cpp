@@ -0,0 +1,323 @@
+// Model lifetime check: counts heap allocations and GL object creation/deletion while a Model is loaded, its meshes
+// are moved out and back, and the model is destroyed (see my_gl_object.h and Mesh's move-only ownership), then loads
+// it again from an uncompressed mesh cache, whose meshes upload straight from the mapping
+// Exits non-zero if a mesh, its import data or the model is copyable, the upload or a move copies geometry (allocates
+// bytes in proportion to the vertices rather than the meshes), a name is deleted twice or anything created by the
+// load is still alive afterwards
+// Leaves no mesh cache next to the model, the app writes its own on the next run
+// Build alongside src/glad.c and src/stb.cpp with the same include/library setup as the main app
+// Usage: model_lifetime_check [model path]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <my_model.h>
+#include <my_model_settings.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+static_assert(!std::is_copy_constructible<Mesh>::value && !std::is_copy_assignable<Mesh>::value, "Mesh must not be copyable");
+static_assert(!std::is_copy_constructible<MeshData>::value && !std::is_copy_assignable<MeshData>::value, "Import results must not be copyable");
+static_assert(std::is_nothrow_move_constructible<Mesh>::value, "Mesh must move without copying");
+static_assert(!std::is_copy_constructible<Model>::value && !std::is_copy_assignable<Model>::value, "Model must not be copyable");
+static_assert(!std::is_copy_constructible<GLBuffer>::value && !std::is_copy_constructible<GLVertexArray>::value, "GL handles must not be copyable");
+
+// Every operator new in the process, counted
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> allocatedBytes(0);
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    allocatedBytes += size;
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Live names of one kind of GL object, fed by the wrapped glGen*/glDelete* entry points
+struct GLObjectTracker
+{
+    std::set<GLuint> live;
+    size_t created = 0;
+    size_t deleted = 0;
+    size_t doubleDeletes = 0;
+
+    void onCreate(GLsizei count, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            live.insert(names[i]);
+            created++;
+        }
+    }
+
+    void onDelete(GLsizei count, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            if (names[i] == 0)
+                continue;   // Deleting 0 is a GL no-op
+            if (live.erase(names[i]) == 0)
+                doubleDeletes++;
+            else
+                deleted++;
+        }
+    }
+};
+
+static GLObjectTracker buffers, vertexArrays, textures;
+
+// The loaded entry points, called through by the counting wrappers glad's pointers are swapped for
+static PFNGLGENBUFFERSPROC realGenBuffers;
+static PFNGLDELETEBUFFERSPROC realDeleteBuffers;
+static PFNGLGENVERTEXARRAYSPROC realGenVertexArrays;
+static PFNGLDELETEVERTEXARRAYSPROC realDeleteVertexArrays;
+static PFNGLGENTEXTURESPROC realGenTextures;
+static PFNGLDELETETEXTURESPROC realDeleteTextures;
+
+void APIENTRY countGenBuffers(GLsizei count, GLuint* names)
+{
+    realGenBuffers(count, names);
+    buffers.onCreate(count, names);
+}
+
+void APIENTRY countDeleteBuffers(GLsizei count, const GLuint* names)
+{
+    buffers.onDelete(count, names);
+    realDeleteBuffers(count, names);
+}
+
+void APIENTRY countGenVertexArrays(GLsizei count, GLuint* names)
+{
+    realGenVertexArrays(count, names);
+    vertexArrays.onCreate(count, names);
+}
+
+void APIENTRY countDeleteVertexArrays(GLsizei count, const GLuint* names)
+{
+    vertexArrays.onDelete(count, names);
+    realDeleteVertexArrays(count, names);
+}
+
+void APIENTRY countGenTextures(GLsizei count, GLuint* names)
+{
+    realGenTextures(count, names);
+    textures.onCreate(count, names);
+}
+
+void APIENTRY countDeleteTextures(GLsizei count, const GLuint* names)
+{
+    textures.onDelete(count, names);
+    realDeleteTextures(count, names);
+}
+
+void hookObjectCalls()
+{
+    realGenBuffers = glad_glGenBuffers;
+    realDeleteBuffers = glad_glDeleteBuffers;
+    realGenVertexArrays = glad_glGenVertexArrays;
+    realDeleteVertexArrays = glad_glDeleteVertexArrays;
+    realGenTextures = glad_glGenTextures;
+    realDeleteTextures = glad_glDeleteTextures;
+    glad_glGenBuffers = countGenBuffers;
+    glad_glDeleteBuffers = countDeleteBuffers;
+    glad_glGenVertexArrays = countGenVertexArrays;
+    glad_glDeleteVertexArrays = countDeleteVertexArrays;
+    glad_glGenTextures = countGenTextures;
+    glad_glDeleteTextures = countDeleteTextures;
+}
+
+// Created and deleted counts of every tracker, to tell whether a phase touched any GL object
+size_t objectCalls()
+{
+    return buffers.created + buffers.deleted + buffers.doubleDeletes + vertexArrays.created + vertexArrays.deleted +
+        vertexArrays.doubleDeletes + textures.created + textures.deleted + textures.doubleDeletes;
+}
+
+void printTracker(const char* label, const GLObjectTracker& tracker)
+{
+    printf("  %-14s %6zu created %6zu deleted %6zu double deletes %6zu alive\n", label, tracker.created, tracker.deleted,
+        tracker.doubleDeletes, tracker.live.size());
+}
+
+bool check(bool condition, const char* failure)
+{
+    if (!condition)
+        printf("FAILED: %s\n", failure);
+    return condition;
+}
+
+// Heap bytes allocated since a mark, with a line of output
+size_t bytesSince(const char* label, size_t allocationsBefore, size_t bytesBefore, size_t geometryBytes)
+{
+    size_t bytes = allocatedBytes - bytesBefore;
+    printf("  %-26s %6zu allocations, %6zu KB (%.2fx the geometry)\n", label, allocationCount - allocationsBefore, bytes / 1024,
+        geometryBytes ? static_cast<double>(bytes) / geometryBytes : 0.0);
+    return bytes;
+}
+
+// Load path with the app's settings but an uncompressed mesh cache, which is written on the first load and mapped by
+// the ones after: with nothing kept in RAM the geometry is never copied, keeping all of it copies it once
+bool checkMappedLoad(const std::string& path)
+{
+    {
+        Model writer;
+        applyModelSettings(writer, path);
+        writer.compressMeshCache = false;
+        writer.loadModelData(path);
+        writer.uploadModelData();
+    }
+
+    bool ok = true;
+    const GeometryResidency residencies[] = { RESIDENCY_FREE_AFTER_UPLOAD, RESIDENCY_KEEP_ALL };
+    for (GeometryResidency residency : residencies)
+    {
+        size_t allocationsBefore = allocationCount, bytesBefore = allocatedBytes;
+        Model model;
+        applyModelSettings(model, path);
+        model.compressMeshCache = false;
+        model.residency = residency;
+        model.loadModelData(path);
+        size_t loadAllocations = allocationCount - allocationsBefore, loadBytes = allocatedBytes - bytesBefore;
+        allocationsBefore = allocationCount;
+        bytesBefore = allocatedBytes;
+        model.uploadModelData();
+        size_t geometryBytes = model.memoryStats().gpuGeometryBytes;
+
+        bool keepAll = residency == RESIDENCY_KEEP_ALL;
+        printf("  %-26s %6zu allocations, %6zu KB (%.2fx the geometry)\n", keepAll ? "Mapped load, keep all:" : "Mapped load, keep none:",
+            loadAllocations, loadBytes / 1024, geometryBytes ? static_cast<double>(loadBytes) / geometryBytes : 0.0);
+        size_t uploadBytes = bytesSince("  upload:", allocationsBefore, bytesBefore, geometryBytes);
+        ok = check(geometryBytes > 0 && loadBytes * 2 < geometryBytes, "mapping the mesh cache copied its geometry") && ok;
+        if (keepAll)
+            ok = check(uploadBytes * 2 < geometryBytes * 3, "keeping the geometry copied it out of the mapping more than once") && ok;
+        else
+            ok = check(uploadBytes * 2 < geometryBytes, "uploading from the mapping copied geometry that isn't kept") && ok;
+    }
+    std::remove((path + MESH_CACHE_EXTENSION).c_str());
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "models/spitfire.obj";
+
+    // Hidden window, just for a GL context
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW." << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "Model Lifetime Check", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    hookObjectCalls();
+
+    bool ok = true;
+    {
+        // Load, with the app's settings for the model
+        size_t allocationsBefore = allocationCount, bytesBefore = allocatedBytes;
+        Model model;
+        applyModelSettings(model, path);
+        model.loadModelData(path);
+        size_t loadAllocations = allocationCount - allocationsBefore, loadBytes = allocatedBytes - bytesBefore;
+        allocationsBefore = allocationCount;
+        bytesBefore = allocatedBytes;
+        model.uploadModelData();
+        size_t meshCount = model.meshes.size();
+        size_t geometryBytes = model.memoryStats().gpuGeometryBytes;
+        printf("%s: %zu meshes, %zu KB of geometry\n", path.c_str(), meshCount, geometryBytes / 1024);
+        printf("  %-26s %6zu allocations, %6zu KB\n", "Load:", loadAllocations, loadBytes / 1024);
+        size_t uploadBytes = bytesSince("Upload:", allocationsBefore, bytesBefore, geometryBytes);
+        ok = check(meshCount > 0, "the model has no meshes") && ok;
+
+        // The import results are moved into the meshes, so the upload allocates per mesh (names, textures), never per vertex
+        ok = check(uploadBytes * 2 < geometryBytes, "the upload allocated half the geometry or more, import results were copied") && ok;
+
+        // Move every mesh out and back: only the destination vectors may allocate, no GL object may change hands
+        size_t callsBefore = objectCalls();
+        allocationsBefore = allocationCount;
+        std::vector<Mesh> moved;
+        moved.reserve(meshCount);
+        for (Mesh& mesh : model.meshes)
+            moved.push_back(std::move(mesh));
+        model.meshes.clear();
+        model.meshes = std::move(moved);
+        size_t moveAllocations = allocationCount - allocationsBefore;
+        printf("  %-26s %6zu allocations, %zu GL object calls\n", "Mesh moves:", moveAllocations, objectCalls() - callsBefore);
+        ok = check(moveAllocations <= 1, "moving the meshes allocated, something was copied") && ok;
+        ok = check(objectCalls() == callsBefore, "moving the meshes created or deleted GL objects") && ok;
+        ok = check(model.meshes.size() == meshCount, "meshes were lost in the move") && ok;
+
+        // Whole vector move, as the model does when it swaps its meshes
+        callsBefore = objectCalls();
+        allocationsBefore = allocationCount;
+        std::vector<Mesh> swapped = std::move(model.meshes);
+        model.meshes = std::move(swapped);
+        ok = check(allocationCount == allocationsBefore, "moving the mesh vector allocated") && ok;
+        ok = check(objectCalls() == callsBefore, "moving the mesh vector created or deleted GL objects") && ok;
+    }
+    ok = checkMappedLoad(path) && ok;
+
+    // Destroyed: everything the load created is gone, each name exactly once
+    printTracker("Buffers", buffers);
+    printTracker("Vertex arrays", vertexArrays);
+    printTracker("Textures", textures);
+    ok = check(buffers.doubleDeletes + vertexArrays.doubleDeletes + textures.doubleDeletes == 0, "a GL object was deleted twice") && ok;
+    ok = check(buffers.live.empty() && vertexArrays.live.empty(), "buffers or vertex arrays outlived the model") && ok;
+    ok = check(textures.live.empty() && TextureCache::instance().stats().residentTextures == 0, "textures outlived the model") && ok;
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
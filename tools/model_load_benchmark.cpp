@@ -0,0 +1,86 @@
+// Model load-time benchmark: Assimp (cold) vs binary mesh cache (warm), then what the import profile's skipped
+// Assimp steps would have cost (logged by the Model)
+// Build alongside src/glad.c and src/stb.cpp with the same include/library setup as the main app
+// Usage: model_load_benchmark [model path] [iterations]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <my_model.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// Time one full Model construction in milliseconds
+double timeModelLoad(const std::string& path, bool useMeshCache)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Model model(path, useMeshCache);
+    glFinish(); // Include the GPU upload
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "models/airplane.obj";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    // Hidden window, just for a GL context
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW." << std::endl;
+        return -1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "Model Load Benchmark", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // Cold path: Assimp import every time
+    double coldTotal = 0.0;
+    for (int i = 0; i < iterations; i++)
+        coldTotal += timeModelLoad(path, false);
+
+    // Populate the cache, then time warm starts
+    std::remove((path + MESH_CACHE_EXTENSION).c_str());
+    double firstRun = timeModelLoad(path, true);
+    double warmTotal = 0.0;
+    for (int i = 0; i < iterations; i++)
+        warmTotal += timeModelLoad(path, true);
+
+    double coldAverage = coldTotal / iterations;
+    double warmAverage = warmTotal / iterations;
+    printf("%s (%d iterations)\n", path.c_str(), iterations);
+    printf("  Assimp (cold):          %8.2f ms\n", coldAverage);
+    printf("  Assimp + cache write:   %8.2f ms\n", firstRun);
+    printf("  Mesh cache (warm):      %8.2f ms\n", warmAverage);
+    printf("  Speedup:                %8.2fx\n", coldAverage / warmAverage);
+
+    // One more Assimp import that replays the steps the profile leaves out
+    {
+        Model model;
+        model.measureImportSavings = true;
+        model.loadModelData(path, false);
+        model.uploadModelData();
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
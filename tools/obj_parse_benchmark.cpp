@@ -0,0 +1,91 @@
+// OBJ parse throughput: native parser (single and multi-threaded) vs Assimp with the legacy import steps, no GL involved
+// Build with the same include/library setup as the main app
+// Usage: obj_parse_benchmark [model path] [iterations]
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <my_import_profile.h>
+#include <my_obj_parser.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Average milliseconds per native parse
+double timeNativeParse(const std::string& path, unsigned int threadCount, int iterations, std::vector<MeshData>& meshes)
+{
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        meshes.clear();
+        auto start = std::chrono::high_resolution_clock::now();
+        parseObjFile(path, meshes, threadCount);
+        auto end = std::chrono::high_resolution_clock::now();
+        total += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return total / iterations;
+}
+
+// Average milliseconds per Assimp import, fills in the mesh names it produced
+double timeAssimpImport(const std::string& path, int iterations, std::vector<std::string>& meshNames)
+{
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, LEGACY_IMPORT_STEPS);
+        auto end = std::chrono::high_resolution_clock::now();
+        total += std::chrono::duration<double, std::milli>(end - start).count();
+
+        meshNames.clear();
+        for (unsigned int m = 0; scene && m < scene->mNumMeshes; m++)
+            meshNames.push_back(scene->mMeshes[m]->mName.C_Str());
+    }
+    return total / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "models/airplane.obj";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        printf("Could not open %s\n", path.c_str());
+        return -1;
+    }
+    double megabytes = file.size() / (1024.0 * 1024.0);
+
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<MeshData> meshes;
+    double single = timeNativeParse(path, 1, iterations, meshes);
+    double parallel = timeNativeParse(path, threads, iterations, meshes);
+    std::vector<std::string> assimpNames;
+    double assimp = timeAssimpImport(path, iterations, assimpNames);
+
+    size_t vertices = 0, triangles = 0;
+    for (const MeshData& mesh : meshes)
+    {
+        vertices += mesh.vertices.size();
+        triangles += mesh.indices.size() / 3;
+    }
+
+    printf("%s (%.2f MB, %d iterations, %zu meshes, %zu vertices, %zu triangles)\n", path.c_str(), megabytes, iterations, meshes.size(), vertices, triangles);
+    printf("  Native, 1 thread:       %8.2f ms %8.1f MB/s\n", single, megabytes / (single / 1000.0));
+    printf("  Native, %2u threads:     %8.2f ms %8.1f MB/s\n", threads, parallel, megabytes / (parallel / 1000.0));
+    printf("  Assimp:                 %8.2f ms %8.1f MB/s\n", assimp, megabytes / (assimp / 1000.0));
+    printf("  Speedup over Assimp:    %8.2fx\n", assimp / parallel);
+
+    // Rig files bind meshes by name, so both importers have to agree on them
+    bool namesMatch = assimpNames.size() == meshes.size();
+    for (size_t i = 0; namesMatch && i < meshes.size(); i++)
+        namesMatch = assimpNames[i] == meshes[i].meshName;
+    printf("  Mesh names match Assimp: %s\n", namesMatch ? "yes" : "NO");
+    return namesMatch ? 0 : 1;
+}
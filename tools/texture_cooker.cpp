@@ -0,0 +1,84 @@
+// Offline texture cooker: PNG/JPEG -> KTX with a box-filtered mip chain in BC1 (opaque) or BC3 (alpha)
+// The runtime picks up "<image>.ktx" next to a texture and "cubemap.ktx" next to the first skybox face
+// Runs entirely on the CPU, each output is read back and decoded to report its PSNR
+// Build alongside src/stb.cpp with the same include setup as the main app
+// Usage: texture_cooker <image>...
+//        texture_cooker --cubemap <+x> <-x> <+y> <-y> <+z> <-z>
+
+#include <stb_image.h>
+
+#include <my_mapped_file.h>
+#include <my_texture_codec.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Cook one or six faces into a single KTX file
+bool cook(const std::vector<std::string>& sources, const std::string& outPath)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<CookedFace> faces;
+    bool withAlpha;
+    if (!cookKtxTexture(sources, outPath, faces, withAlpha))
+        return false;
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Read the file back the way the runtime does and measure the base level
+    MappedFile written(outPath);
+    KtxTexture ktx;
+    if (!written.isOpen() || !parseKtx(written.data(), written.size(), ktx))
+    {
+        std::cout << "ERROR::TEXTURE_COOKER:: " << outPath << " doesn't parse" << std::endl;
+        return false;
+    }
+
+    size_t sourceBytes = 0;
+    double worstPsnr = 99.0;
+    for (int face = 0; face < ktx.faces; face++)
+    {
+        const KtxTexture::Level& level = ktx.levels[face];
+        MipLevel decoded = decompressLevel(level.data, level.width, level.height, withAlpha);
+        double psnr = computePsnr(faces[face].baseLevel.data.data(), decoded.data.data(), static_cast<size_t>(level.width) * level.height);
+        worstPsnr = std::min(worstPsnr, psnr);
+        sourceBytes += faces[face].sourceBytes;
+    }
+
+    std::cout << outPath << ": " << ktx.width << "x" << ktx.height << " x" << ktx.faces << ", " << ktx.mipLevels << " mips, "
+        << (withAlpha ? "BC3" : "BC1") << ", " << sourceBytes / 1024 << " KB -> " << written.size() / 1024 << " KB, "
+        << "PSNR " << worstPsnr << " dB, " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: texture_cooker <image>...\n       texture_cooker --cubemap <+x> <-x> <+y> <-y> <+z> <-z>" << std::endl;
+        return -1;
+    }
+
+    // Sampled as-is by the runtime, so no flip
+    stbi_set_flip_vertically_on_load(false);
+
+    std::string first = argv[1];
+    if (first == "--cubemap")
+    {
+        if (argc != 8)
+        {
+            std::cout << "ERROR::TEXTURE_COOKER:: --cubemap takes exactly six faces" << std::endl;
+            return -1;
+        }
+        std::vector<std::string> faces(argv + 2, argv + 8);
+        return cook(faces, cookedCubemapPath(faces)) ? 0 : -1;
+    }
+
+    int failures = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!cook({ argv[i] }, cookedTexturePath(argv[i])))
+            failures++;
+    }
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,99 @@
+// Vertex quantization (see my_vertex.h): packs random vertices and a model's meshes and dequantizes them the way the
+// vertex shader does, reporting the worst position, normal and texture coordinate error
+// Exits non-zero if any error is above what 16-bit positions/UVs and octahedral snorm16 normals should give:
+// half a step of the bounds per axis (checked at one step for float slack) and a twentieth of a degree
+// Build with the same include/library setup as the main app
+// Usage: vertex_quantization_check [model path] [random vertex count]
+
+#include <my_mesh.h>
+#include <my_obj_parser.h>
+#include <my_vertex.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Largest error a round trip may have
+const float MAX_POSITION_RELATIVE_ERROR = 1.0f / 65535.0f;     // Of the largest bounds extent
+const float MAX_TEXCOORD_RELATIVE_ERROR = 1.0f / 65535.0f;     // Of the largest UV extent
+const float MAX_NORMAL_ERROR_DEGREES = 0.05f;
+
+// Quantize vertices, print the worst error and check it against the bounds
+bool check(const char* label, const std::vector<Vertex>& vertices, QuantizationError& worst)
+{
+    VertexQuantization quantization;
+    std::vector<PackedVertex> packed = quantizeVertices(vertices.data(), vertices.size(), quantization);
+    QuantizationError error = measureQuantizationError(vertices.data(), packed.data(), vertices.size(), quantization);
+
+    float texCoordExtent = std::max(quantization.texCoordScale.x, quantization.texCoordScale.y);
+    float texCoordRelative = texCoordExtent > 0.0f ? error.texCoord / texCoordExtent : 0.0f;
+    worst.position = std::max(worst.position, error.position);
+    worst.positionRelative = std::max(worst.positionRelative, error.positionRelative);
+    worst.normalDegrees = std::max(worst.normalDegrees, error.normalDegrees);
+    worst.texCoord = std::max(worst.texCoord, texCoordRelative);
+
+    bool ok = error.positionRelative <= MAX_POSITION_RELATIVE_ERROR && error.normalDegrees <= MAX_NORMAL_ERROR_DEGREES &&
+        texCoordRelative <= MAX_TEXCOORD_RELATIVE_ERROR;
+    if (!ok)
+    {
+        printf("FAILED: %s (%zu vertices): position %g (%.6f%% of bounds), normal %.4f degrees, texcoord %g (%.6f%% of UV bounds)\n",
+            label, vertices.size(), error.position, 100.0f * error.positionRelative, error.normalDegrees, error.texCoord, 100.0f * texCoordRelative);
+    }
+    return ok;
+}
+
+void printWorst(const char* label, size_t meshCount, const QuantizationError& worst)
+{
+    printf("  %-8s %4zu meshes: position %.6f%% of bounds, normal %.4f degrees, texcoord %.6f%% of UV bounds\n", label, meshCount,
+        100.0f * worst.positionRelative, worst.normalDegrees, 100.0f * worst.texCoord);
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "models/spitfire.obj";
+    size_t randomCount = argc > 2 ? std::stoul(argv[2]) : 100000;
+    bool ok = true;
+
+    // Random vertices, with a thin axis and normals on the octahedron's folds
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Vertex> vertices(randomCount);
+    for (Vertex& vertex : vertices)
+    {
+        vertex.Position = glm::vec3(unit(random) * 1000.0f, unit(random) * 0.01f, unit(random));
+        do
+            vertex.Normal = glm::vec3(unit(random), unit(random), unit(random));
+        while (glm::length(vertex.Normal) < 1e-3f);
+        vertex.Normal = glm::normalize(vertex.Normal);
+        vertex.TexCoords = glm::vec2(unit(random) * 8.0f, unit(random));
+    }
+    vertices[0].Normal = glm::vec3(0.0f, 0.0f, -1.0f);
+    if (randomCount > 1)
+        vertices[1].Normal = glm::normalize(glm::vec3(1.0f, -1.0f, 0.0f));
+    QuantizationError randomWorst;
+    ok = check("random", vertices, randomWorst) && ok;
+    std::vector<Vertex> flat = vertices;
+    for (Vertex& vertex : flat)
+        vertex.Position.z = 3.0f;
+    ok = check("random, flat", flat, randomWorst) && ok;
+
+    // A real model, as imported
+    std::vector<MeshData> meshes;
+    if (!parseObjFile(path, meshes))
+    {
+        printf("Could not read %s\n", path.c_str());
+        return -1;
+    }
+    QuantizationError modelWorst;
+    for (const MeshData& mesh : meshes)
+        ok = check(mesh.meshName.c_str(), mesh.vertices, modelWorst) && ok;
+
+    printf("Worst round trip error (limits: %.6f%% of bounds, %.4f degrees, %.6f%% of UV bounds)\n", 100.0f * MAX_POSITION_RELATIVE_ERROR,
+        MAX_NORMAL_ERROR_DEGREES, 100.0f * MAX_TEXCOORD_RELATIVE_ERROR);
+    printWorst("Random", 2, randomWorst);
+    printWorst("Model", meshes.size(), modelWorst);
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}